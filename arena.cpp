@@ -0,0 +1,45 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // max()
+
+#include "arena.h"
+
+/******************************************************************************
+| Objects are placed one after another in large blocks, so allocating one is  |
+| just moving the end of the used part of the current block. Nothing is freed |
+| one object at a time: reset() moves the end back to a mark, and clear()     |
+| moves it back to the start. The blocks themselves are kept and reused, so a |
+| parser that backtracks repeatedly doesn't allocate any new memory.          |
+******************************************************************************/
+Arena::Arena(std::size_t block_size) : block_size(block_size) {}
+
+// moves on to the next block (a new one if the next block is too small)
+void* Arena::allocate_slow(std::size_t size, std::size_t alignment) {
+	if (current < blocks.size()) {
+		current++;
+	}
+	if (current == blocks.size() || blocks[current].size < size + alignment) {
+		Block block;
+		block.size = std::max(block_size, size + alignment);
+		block.data.reset(new char[block.size]);
+		blocks.insert(blocks.begin() + current, std::move(block));
+	}
+	used = 0;
+	return allocate(size, alignment);
+}
+
+Arena_mark Arena::mark() const {
+	Arena_mark saved;
+	saved.block = current;
+	saved.used = used;
+	return saved;
+}
+
+void Arena::reset(Arena_mark saved) {
+	current = saved.block;
+	used = saved.used;
+}
+
+void Arena::clear() {
+	current = 0;
+	used = 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef ARENA_H_
+#define ARENA_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <memory>  // block storage
+#include <new>  // placement new
+#include <type_traits>  // is_trivially_destructible
+#include <vector>  // blocks
+
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+// a position in an arena. resetting the arena to a mark frees everything
+// that was allocated after the mark was taken
+struct Arena_mark {
+	std::size_t block;  // index of the block in use
+	std::size_t used;  // bytes used in that block
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Arena {  // bump allocator whose objects are all freed at once
+	private:
+		struct Block {
+			std::unique_ptr<char[]> data;
+			std::size_t size;
+		};
+
+		std::vector<Block> blocks;  // never shrinks (blocks are reused)
+		std::size_t current = 0;  // block that objects are allocated from
+		std::size_t used = 0;  // bytes used in the current block
+		std::size_t block_size;  // size of a new block
+
+		void* allocate_slow(std::size_t size, std::size_t alignment);
+
+	public:
+		explicit Arena(std::size_t block_size = 64 << 10);  // 64 KiB
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		// size bytes aligned to alignment (a power of two)
+		void* allocate(std::size_t size, std::size_t alignment) {
+			if (current < blocks.size()) {
+				std::size_t start = (used + alignment - 1) & ~(alignment - 1);
+				if (start + size <= blocks[current].size) {
+					used = start + size;
+					return blocks[current].data.get() + start;
+				}
+			}
+			return allocate_slow(size, alignment);
+		}
+
+		// a zero-initialized T. objects are never destroyed, only freed
+		template <typename T>
+		T* make() {
+			static_assert(std::is_trivially_destructible<T>::value,
+						  "arena objects are freed without being destroyed");
+			return new (allocate(sizeof(T), alignof(T))) T();
+		}
+
+		Arena_mark mark() const;  // current position
+		void reset(Arena_mark saved);  // free everything after saved
+		void clear();  // free everything (the memory is kept for reuse)
+};
+
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+#ifndef AST_H_
+#define AST_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstdint>  // node kinds
+#include <string_view>  // lexemes (views into the input buffer)
+
+#include "lexer.h"  // Symbol_id (qualifiers and operators)
+
+/******************************************************************************
+| The abstract syntax tree that the syntax analyzer builds. Every node lives  |
+| in the analyzer's Arena and is freed along with it, so nodes don't own any  |
+| memory: names and literals are string_views into the input buffer, and      |
+| lists are linked through each node's next pointer (in source order).        |
+| The semantic pass fills in the symbol of every name (its index in the       |
+| Symbol_table), which is all the code generator needs to know about it.      |
+******************************************************************************/
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+struct Identifier_node {  // <Identifier> (in an <IDs> list)
+	std::string_view name;
+	int line;
+	std::uint32_t symbol;  // its declaration (set by the semantic pass)
+	Identifier_node* next;
+};
+
+enum Expression_kind : std::uint8_t {
+	EXPRESSION_IDENTIFIER,  // x
+	EXPRESSION_CALL,  // f(x, y)
+	EXPRESSION_INTEGER,  // 12
+	EXPRESSION_REAL,  // 1.5
+	EXPRESSION_TRUE,  // true
+	EXPRESSION_FALSE,  // false
+	EXPRESSION_NEGATE,  // -x
+	EXPRESSION_BINARY  // x + y, x - y, x * y, x / y
+};
+
+// parentheses aren't kept: ( <Expression> ) is just the inner expression
+struct Expression_node {
+	Expression_kind kind;
+	Symbol_id op;  // OPERATOR_PLUS/MINUS/MULTIPLY/DIVIDE (binary only)
+	int line;  // line of the first token (the operator's, if binary)
+	std::string_view lexeme;  // name or literal (identifier, call, literal)
+	std::uint32_t symbol;  // identifier, call (set by the semantic pass)
+	Expression_node* left;  // left operand (binary), operand (negate)
+	Expression_node* right;  // right operand (binary)
+	Identifier_node* arguments;  // call only
+};
+
+struct Condition_node {  // <Expression> <Relop> <Expression>
+	Expression_node* left;
+	Symbol_id relop;  // OPERATOR_EQUAL ... OPERATOR_GREATER_EQUAL
+	Expression_node* right;
+};
+
+enum Statement_kind : std::uint8_t {
+	STATEMENT_COMPOUND,  // { body }
+	STATEMENT_ASSIGN,  // target = expression ;
+	STATEMENT_IF,  // if ( condition ) body [else else_body] fi
+	STATEMENT_RETURN,  // return [expression] ;
+	STATEMENT_PRINT,  // put ( expression ) ;
+	STATEMENT_SCAN,  // get ( ids ) ;
+	STATEMENT_WHILE,  // while ( condition ) body endwhile
+	STATEMENT_ERROR  // a statement with a syntax error (never in a full AST)
+};
+
+// one node type for every statement: only the fields of its kind are set
+struct Statement_node {
+	Statement_kind kind;
+	int line;  // line of the statement's first token
+	std::string_view target;  // assign
+	std::uint32_t target_symbol;  // assign (set by the semantic pass)
+	Expression_node* expression;  // assign, print, return (null if none)
+	Condition_node condition;  // if, while
+	Statement_node* body;  // compound (a list), if, while
+	Statement_node* else_body;  // if (null if there is no else)
+	Identifier_node* ids;  // scan
+	Statement_node* next;
+};
+
+// <Declaration> (qualifier first) and <Parameter> (ids first) have the same
+// contents, so both use this node
+struct Declaration_node {
+	Symbol_id qualifier;  // KEYWORD_INT, KEYWORD_BOOL, or KEYWORD_REAL
+	Identifier_node* ids;
+	int line;
+	Declaration_node* next;
+};
+
+struct Function_node {
+	std::string_view name;
+	int line;
+	std::uint32_t symbol;  // (set by the semantic pass)
+	Declaration_node* parameters;
+	Declaration_node* declarations;
+	Statement_node* body;
+	Function_node* next;
+};
+
+struct Program_node {  // <Rat23S>
+	Function_node* functions;
+	Declaration_node* declarations;
+	Statement_node* statements;
+};
+
+#endif
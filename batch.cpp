@@ -0,0 +1,259 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // sort()
+#include <chrono>  // timing
+#include <cstdint>  // uintmax_t
+#include <filesystem>  // directories, output paths
+#include <fstream>  // list of files
+#include <iomanip>  // setw()  setprecision()
+#include <iostream>  // summary
+#include <map>  // paths that are taken
+#include <string>
+#include <system_error>  // error_code
+#include <vector>
+
+#include "batch.h"
+#include "compile_cache.h"  // Compile_cache
+#include "output_buffer.h"  // output files
+#include "source_buffer.h"  // input files
+#include "thread_pool.h"  // workers
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+struct Batch_file {  // one input file and what happened to it
+	std::string input;
+	std::string output;
+	std::uintmax_t size = 0;  // bytes (bigger files are started first)
+	bool passed = false;
+	bool cached = false;  // its result came from the compile cache
+	std::string note;  // why it failed
+	double milliseconds = 0;  // time spent on it by its worker
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double milliseconds_since(Clock::time_point start) {
+	std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+	return elapsed.count();
+}
+
+// the same path for every name of a file (which doesn't have to exist)
+static std::filesystem::path canonical_path(const std::string& name) {
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(name, error);
+	return error ? std::filesystem::path(name).lexically_normal() : path;
+}
+
+// gives the files whose output path is taken a note (see find_inputs())
+static void refuse_taken_outputs(std::vector<Batch_file>& files) {
+	std::map<std::filesystem::path, std::size_t> inputs;  // (-> file)
+	for (std::size_t i = 0; i < files.size(); i++) {
+		inputs.emplace(canonical_path(files[i].input), i);
+	}
+	std::map<std::filesystem::path, std::size_t> outputs;
+	for (std::size_t i = 0; i < files.size(); i++) {
+		std::filesystem::path output = canonical_path(files[i].output);
+		std::map<std::filesystem::path, std::size_t>::const_iterator input =
+			inputs.find(output);
+		if (input != inputs.end()) {
+			files[i].note = "its output file '" + files[i].output
+				+ "' is the input file '" + files[input->second].input + "'";
+			continue;
+		}
+		std::pair<std::map<std::filesystem::path, std::size_t>::iterator,
+				  bool> taken = outputs.emplace(output, i);
+		if (!taken.second) {
+			files[i].note = "its output file '" + files[i].output
+				+ "' is also the output of '"
+				+ files[taken.first->second].input + "'";
+		}
+	}
+}
+
+/******************************************************************************
+| The inputs are either every *.txt file in a directory (in order by name),   |
+| or every line of a text file that lists the paths of the input files. The   |
+| output file of "name.txt" is "name.out", in the output directory if one     |
+| was given (otherwise, next to the input file). A file whose output would    |
+| overwrite an input file (itself, as for "name.out"), or the output of an    |
+| earlier file (the same name in two directories, with --out-dir), isn't      |
+| compiled: it fails with a note instead, before any output is written.       |
+******************************************************************************/
+static bool find_inputs(const Batch_options& options,
+						std::vector<Batch_file>& files) {
+	std::error_code error;
+	std::vector<std::string> names;
+	if (std::filesystem::is_directory(options.inputs, error)) {
+		for (const std::filesystem::directory_entry& entry :
+			 std::filesystem::directory_iterator(options.inputs, error)) {
+			if (entry.is_regular_file(error)
+				&& entry.path().extension() == ".txt") {
+				names.push_back(entry.path().string());
+			}
+		}
+		std::sort(names.begin(), names.end());
+	}
+	else {
+		std::ifstream list(options.inputs);
+		if (!list.is_open()) {
+			return false;
+		}
+		std::string line;
+		while (std::getline(list, line)) {
+			while (!line.empty() && (line.back() == '\r' || line.back() == ' '
+									 || line.back() == '\t')) {
+				line.pop_back();
+			}
+			if (!line.empty()) {
+				names.push_back(line);
+			}
+		}
+	}
+
+	for (const std::string& name : names) {
+		std::filesystem::path output = name;
+		output.replace_extension(".out");
+		if (!options.output_directory.empty()) {
+			output = std::filesystem::path(options.output_directory)
+				/ output.filename();
+		}
+
+		Batch_file file;
+		file.input = name;
+		file.output = output.string();
+		file.size = std::filesystem::file_size(name, error);
+		if (error) {
+			file.size = 0;
+		}
+		files.push_back(file);
+	}
+	refuse_taken_outputs(files);
+	return true;
+}
+
+// compiles one file into its output file (runs on a worker thread)
+static void compile_batch_file(const Batch_options& options,
+							   Compile_cache& cache, Batch_file& file) {
+	Clock::time_point start = Clock::now();
+
+	// (the input is opened first, so a missing one leaves no output file)
+	Source_buffer source;
+	if (!source.open(file.input)) {
+		file.note = "Couldn't open file '" + file.input + "'";
+		file.milliseconds = milliseconds_since(start);
+		return;
+	}
+
+	Output_buffer ofs(64 << 10);  // (batch inputs are usually small)
+	if (!ofs.open(file.output)) {
+		file.note = "couldn't create/edit '" + file.output + "'";
+		file.milliseconds = milliseconds_since(start);
+		return;
+	}
+
+	Compile_options compile_options;
+	compile_options.trace = options.trace;
+	compile_options.max_depth = options.max_depth;
+	compile_options.semantic = options.semantic;
+	compile_options.lexer_threads = 1;  // (the pool already uses every core)
+	compile_options.output = &ofs;
+	Compile_summary summary = cache.compile(source.begin(), source.end(),
+											compile_options);
+	ofs.close();
+
+	file.passed = summary.passed();
+	file.cached = summary.from_cache;
+	if (!file.passed) {
+		const Diagnostic& first = summary.diagnostics.front();
+		std::size_t count = summary.diagnostics.size();
+		if (!summary.lexed && first.line == 0) {  // (too large to lex)
+			file.note = first.message;
+		}
+		else if (!summary.lexed) {
+			file.note = "lexical error on line " + std::to_string(first.line);
+		}
+		else {
+			file.note = std::to_string(count)
+				+ (count == 1 ? " error" : " errors") + ", first on line "
+				+ std::to_string(first.line);
+		}
+	}
+	file.milliseconds = milliseconds_since(start);
+}
+
+/******************************************************************************
+| run_batch compiles every input file on a thread pool (one worker per core   |
+| by default), all in this one process. The biggest files are submitted       |
+| first, so that a large file doesn't start last and hold up the end of the   |
+| batch. Then a line with the result and time of every file (in input order)  |
+| is printed, followed by the totals (and the compile cache's hits/misses).   |
+******************************************************************************/
+int run_batch(const Batch_options& options) {
+	std::vector<Batch_file> files;
+	if (!find_inputs(options, files)) {
+		std::cout << "ERROR: Couldn't open file '" << options.inputs << "'\n";
+		return -1;
+	}
+	if (files.empty()) {
+		std::cout << "ERROR: No input files in '" << options.inputs << "'\n";
+		return -1;
+	}
+	if (!options.output_directory.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(options.output_directory, error);
+	}
+
+	std::vector<std::size_t> order(files.size());
+	for (std::size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(),
+					 [&files](std::size_t a, std::size_t b) {
+						 return files[a].size > files[b].size;
+					 });
+
+	Compile_cache cache(options.cache_directory);  // (shared by the workers)
+	Clock::time_point start = Clock::now();
+	unsigned thread_count;
+	{
+		Thread_pool pool(options.thread_count);
+		thread_count = pool.size();
+		for (std::size_t index : order) {
+			Batch_file* file = &files[index];
+			if (!file->note.empty()) {
+				continue;  // (refused by find_inputs())
+			}
+			pool.submit([&options, &cache, file] {
+				compile_batch_file(options, cache, *file);
+			});
+		}
+		pool.wait();
+	}
+	double wall_time = milliseconds_since(start);
+
+	// summary
+	std::size_t passed = 0;
+	double work_time = 0;
+	std::cout << std::fixed << std::setprecision(2);
+	for (const Batch_file& file : files) {
+		passed += file.passed;
+		work_time += file.milliseconds;
+		std::cout << (file.passed ? "PASS " : "FAIL ") << std::setw(10)
+			<< file.milliseconds << " ms  " << file.input;
+		if (!file.passed) {
+			std::cout << "  (" << file.note << ")";
+		}
+		if (file.cached) {
+			std::cout << "  [cached]";
+		}
+		std::cout << "\n";
+	}
+	std::cout << files.size() << " files: " << passed << " passed, "
+		<< files.size() - passed << " failed in " << wall_time << " ms ("
+		<< work_time << " ms of work on " << thread_count
+		<< (thread_count == 1 ? " thread)\n" : " threads)\n");
+	if (cache.enabled()) {
+		std::cout << "cache: " << cache.hits() << " hits, " << cache.misses()
+			<< " misses\n";
+	}
+
+	return (passed == files.size()) ? 0 : -1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#ifndef BATCH_H_
+#define BATCH_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <string>  // paths
+
+#include "syntax_analyzer.h"  // DEFAULT_MAX_DEPTH
+
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+struct Batch_options {
+	std::string inputs;  // a directory (its *.txt files) or a list of files
+	std::string output_directory;  // "" -> next to each input file
+	unsigned thread_count = 0;  // 0 -> one per core
+	bool trace = true;  // false -> output files only hold errors
+	std::string cache_directory;  // "" -> no compile cache
+	std::size_t max_depth = DEFAULT_MAX_DEPTH;  // (see Compile_options)
+	bool semantic = false;  // check declarations too
+};
+
+
+/* -------------------------- FUNCTION PROTOTYPES -------------------------- */
+int run_batch(const Batch_options& options);  // 0 if every file passed
+
+#endif
@@ -0,0 +1,112 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // min()
+#include <chrono>  // timing
+#include <cstdio>  // printf()
+#include <fstream>  // input files
+#include <iterator>  // istreambuf_iterator
+#include <string>  // inputs, output text
+#include <thread>  // hardware_concurrency()
+#include <vector>  // inputs
+
+#include "../compiler.h"  // compile()
+
+/******************************************************************************
+| Measures --pipeline (see token_ring.h) against the inline mode: compile()   |
+| is timed on whole inputs with Compile_options::pipelined off and on, with   |
+| and without the trace, and the output text of the two modes is compared.    |
+| The lexer itself runs on one thread in both modes, so the only difference   |
+| is whether it overlaps with the SA phase. That takes at least two cores: on |
+| one core the pipelined mode can only be slower. The input is a made-up      |
+| program, or the files given on the command line. Every time is the best of  |
+| RUNS.                                                                       |
+|                                                                             |
+| usage: bench_pipeline [file ...]                                            |
+******************************************************************************/
+
+const int RUNS = 5;
+const std::size_t INPUT_SIZE = 4 << 20;  // (bytes of the made-up input)
+
+struct Bench_input {
+	std::string name;
+	std::string text;
+};
+
+// a program that passes the SA phase, about INPUT_SIZE bytes long
+static std::string made_up_program() {
+	std::string text = "[* made up by bench_pipeline *]\n"
+		"function f (n int) { return n * 2; }\n#\nint a, b, c, x;\n#\n";
+	const std::string statement =
+		"x = a + b * (c - 1); if (a < b) { put(f(x)); } else "
+		"{ while (x > 0) x = x - 1; endwhile } fi\n";
+	while (text.size() < INPUT_SIZE) {
+		text += statement;
+	}
+	return text;
+}
+
+// best time of RUNS compilations, in seconds, and the output text
+static double bench_compile(const Bench_input& input, bool pipelined,
+							bool trace, std::string& output_text) {
+	double best = 1e30;
+	for (int i = 0; i < RUNS; i++) {
+		output_text.clear();
+		Output_buffer output(&output_text);
+		Compile_options options;
+		options.trace = trace;
+		options.pipelined = pipelined;
+		options.lexer_threads = 1;
+		options.output = &output;
+		std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+		compile(input.text.data(), input.text.data() + input.text.size(),
+				options);
+		output.flush();
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main(int argc, char* argv[]) {
+	std::vector<Bench_input> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file) {
+			std::printf("ERROR: Couldn't open file '%s'\n", argv[i]);
+			return -1;
+		}
+		inputs.push_back({ argv[i],
+						   std::string(std::istreambuf_iterator<char>(file),
+									   std::istreambuf_iterator<char>()) });
+	}
+	if (inputs.empty()) {
+		inputs.push_back({ "made-up program", made_up_program() });
+	}
+
+	std::printf("compile() (best of %d, %u cores):\n", RUNS,
+				std::thread::hardware_concurrency());
+	std::printf("  %-20s %6s %-8s %10s %10s %8s\n", "input", "MB", "trace",
+				"inline", "pipelined", "speedup");
+	int result = 0;
+	for (const Bench_input& input : inputs) {
+		for (int trace = 1; trace >= 0; trace--) {
+			std::string inline_text;
+			std::string pipelined_text;
+			double inline_seconds = bench_compile(input, false, trace,
+												  inline_text);
+			double pipelined_seconds = bench_compile(input, true, trace,
+													 pipelined_text);
+			bool same = inline_text == pipelined_text;
+			std::printf("  %-20s %6.1f %-8s %8.3f s %8.3f s %7.2fx%s\n",
+						input.name.c_str(), input.text.size() / 1e6,
+						trace ? "trace" : "no trace", inline_seconds,
+						pipelined_seconds, inline_seconds / pipelined_seconds,
+						same ? "" : "  (OUTPUT DIFFERS)");
+			if (!same) {
+				result = -1;
+			}
+		}
+	}
+	return result;
+}
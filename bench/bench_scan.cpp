@@ -0,0 +1,184 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // min()
+#include <chrono>  // timing
+#include <cstddef>  // size_t
+#include <cstdio>  // printf()
+#include <fstream>  // input files
+#include <iterator>  // istreambuf_iterator
+#include <string>  // inputs
+#include <vector>  // inputs
+
+#include "../lexer.h"  // Lexer
+#include "../simd_scan.h"  // Scan_kernels
+
+/******************************************************************************
+| Measures the scan kernels (see simd_scan.cpp) in bytes per second: first    |
+| each kernel on its own, over a buffer that it skips from start to end, and  |
+| then Lexer::Analyze() on whole inputs, with the scalar kernels (the         |
+| portable path) and with the best ones this CPU runs. The inputs are made up |
+| (comment-heavy, indentation-heavy, and ordinary code), or read from the     |
+| files given on the command line. Every time is the best of RUNS, and the    |
+| lexer runs on one thread, so only the kernels differ.                       |
+|                                                                             |
+| usage: bench_scan [file ...]                                                |
+******************************************************************************/
+
+const int RUNS = 7;
+const std::size_t INPUT_SIZE = 8 << 20;  // (bytes of each made-up input)
+
+struct Bench_input {
+	std::string name;
+	std::string text;
+};
+
+// best time of RUNS calls of run(), in seconds
+template <typename Function>
+static double best_time(Function run) {
+	double best = 1e30;
+	for (int i = 0; i < RUNS; i++) {
+		std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+		run();
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+static double megabytes_per_second(std::size_t bytes, double seconds) {
+	return bytes / seconds / 1e6;
+}
+
+// repeats line until text is about size bytes long
+static std::string repeat(const std::string& line, std::size_t size) {
+	std::string text;
+	text.reserve(size + line.size());
+	while (text.size() < size) {
+		text += line;
+	}
+	return text;
+}
+
+static std::vector<Bench_input> made_up_inputs() {
+	std::string comment = "[* " + std::string(300, 'c') + "\n"
+		+ std::string(200, 'd') + " *]\n";
+	return {
+		{ "comment-heavy", repeat(comment + "int x;\n", INPUT_SIZE) },
+		{ "indentation-heavy",
+		  repeat("\t\t\t\t\t\t        \r\n            x = x + 1;\n",
+				 INPUT_SIZE) },
+		{ "ordinary code",
+		  repeat("while (i < n) { put(i); i = i + 1; } endwhile\n"
+				 "if (a => b) a = b * 2; else b = a - 1; fi\n", INPUT_SIZE) }
+	};
+}
+
+// each kernel skips all of a buffer made for it
+static void bench_kernels(const Scan_kernels& kernels) {
+	std::string white_space = repeat("    \t  \n", INPUT_SIZE);
+	std::string comment = repeat("some comment text * ] *\n", INPUT_SIZE);
+	const char* end;
+	int newlines;
+	double seconds = best_time([&] {
+		newlines = 0;
+		end = kernels.skip_white_space(white_space.data(),
+									   white_space.data() + white_space.size(),
+									   &newlines);
+	});
+	std::printf("  %-6s skip_white_space   %8.0f MB/s  (%d lines)\n",
+				kernels.name,
+				megabytes_per_second(end - white_space.data(), seconds),
+				newlines);
+	seconds = best_time([&] {
+		newlines = 0;
+		end = kernels.find_comment_end(comment.data(),
+									   comment.data() + comment.size(),
+									   &newlines);
+	});
+	std::printf("  %-6s find_comment_end   %8.0f MB/s  (%d lines)\n",
+				kernels.name,
+				megabytes_per_second(end - comment.data(), seconds),
+				newlines);
+}
+
+// times Analyze() with kernels, and returns its tokens (to compare them)
+static std::vector<Token> bench_lexer(const Bench_input& input,
+									  const Scan_kernels& kernels,
+									  double& seconds) {
+	const char* begin = input.text.data();
+	const char* end = begin + input.text.size();
+	std::vector<Token> tokens;
+	seconds = best_time([&] {
+		Lexer lexer(begin, end);
+		lexer.set_thread_count(1);
+		lexer.use_scan_kernels(kernels);
+		lexer.Analyze();
+		tokens = lexer.get_tokens().tokens;
+	});
+	return tokens;
+}
+
+static bool same_tokens(const std::vector<Token>& a,
+						const std::vector<Token>& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (std::size_t i = 0; i < a.size(); i++) {
+		if (a[i].kind != b[i].kind || a[i].symbol != b[i].symbol
+			|| a[i].offset != b[i].offset || a[i].length != b[i].length
+			|| a[i].line != b[i].line) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	const Scan_kernels& scalar = scalar_scan_kernels();
+	const Scan_kernels& best = best_scan_kernels();
+
+	std::vector<Bench_input> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file) {
+			std::printf("ERROR: Couldn't open file '%s'\n", argv[i]);
+			return -1;
+		}
+		inputs.push_back({ argv[i],
+						   std::string(std::istreambuf_iterator<char>(file),
+									   std::istreambuf_iterator<char>()) });
+	}
+	if (inputs.empty()) {
+		inputs = made_up_inputs();
+	}
+
+	std::printf("kernels (best of %d):\n", RUNS);
+	bench_kernels(scalar);
+	if (&best != &scalar) {
+		bench_kernels(best);
+	}
+
+	std::printf("Lexer::Analyze() (best of %d, 1 thread):\n", RUNS);
+	std::printf("  %-20s %10s %12s %12s\n", "input", "MB", scalar.name,
+				best.name);
+	int result = 0;
+	for (const Bench_input& input : inputs) {
+		double scalar_seconds;
+		double best_seconds;
+		std::vector<Token> scalar_tokens = bench_lexer(input, scalar,
+													   scalar_seconds);
+		std::vector<Token> best_tokens = bench_lexer(input, best,
+													 best_seconds);
+		bool same = same_tokens(scalar_tokens, best_tokens);
+		std::printf("  %-20s %10.1f %7.0f MB/s %7.0f MB/s%s\n",
+					input.name.c_str(), input.text.size() / 1e6,
+					megabytes_per_second(input.text.size(), scalar_seconds),
+					megabytes_per_second(input.text.size(), best_seconds),
+					same ? "" : "  (TOKENS DIFFER)");
+		if (!same) {
+			result = -1;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,587 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <charconv>  // from_chars()  to_chars()
+#include <cstring>  // memcpy()  memcmp()
+#include <fstream>  // binary code file
+#include <string_view>  // listing text
+#include <utility>  // move()
+
+#include "code_generator.h"
+#include "source_buffer.h"  // memory-mapped code file
+
+Code_Generator::Code_Generator(const Symbol_table* symbol_table,
+							   Stack_code* stack_code,
+							   Output_buffer* output_file)
+	: symbols(symbol_table), code(stack_code), ofs(output_file) {}
+
+/******************************************************************************
+| Generate() translates the program in one pass over its AST, and every       |
+| instruction goes straight into the code's array, which is allocated once at |
+| the start (compile() passes the number of tokens as size_hint, which is     |
+| more than almost any program needs). A jump forward is emitted before its   |
+| target is known, and its operand is backpatched once the code that it skips |
+| has been generated, so nothing is ever generated twice.                     |
+|                                                                             |
+| The functions come first: each one can only call the functions written      |
+| before it (or itself), so every CALL's target is already known. The main    |
+| body comes last, after a JUMP over the functions, so a program without      |
+| functions starts at its main body, like any Rat23S program.                 |
+******************************************************************************/
+std::vector<Diagnostic> Code_Generator::Generate(const Program_node* program,
+												 std::size_t size_hint) {
+	code->instructions.clear();
+	code->instructions.reserve(size_hint);
+	entries.assign(symbols->symbol_count(), 0);
+	parameter_counts.assign(symbols->symbol_count(), 0);
+	scratch = -1;
+
+	if (program->functions) {
+		std::uint32_t skip = emit(OP_JUMP);
+		for (const Function_node* definition = program->functions; definition;
+			 definition = definition->next) {
+			generate_function(definition);
+		}
+		patch(skip);
+	}
+
+	function = nullptr;
+	check_declarations(program->declarations);
+	generate_statements(program->statements);
+	code->memory_size = symbols->get_variable_count() + (scratch < 0 ? 0 : 1);
+
+	if (ofs != nullptr) {
+		ofs->flush();
+	}
+	return std::move(diagnostics);
+}
+
+std::uint32_t Code_Generator::emit(Opcode opcode, std::int32_t operand) {
+	code->instructions.push_back(Instruction{ opcode, operand });
+	return static_cast<std::uint32_t>(code->instructions.size() - 1);
+}
+
+void Code_Generator::patch(std::uint32_t jump) {
+	code->instructions[jump].operand =
+		static_cast<std::int32_t>(code->instructions.size());
+}
+
+std::int32_t Code_Generator::slot(std::uint32_t symbol) const {
+	return static_cast<std::int32_t>(symbols->symbol(symbol).address);
+}
+
+/******************************************************************************
+| Every variable has a memory slot of its own: Rat23S has no nested           |
+| functions, so a function's variables can be allocated next to the global    |
+| ones. The caller pushes the arguments, and the function pops them into its  |
+| parameters (the last one first). The value that it returns is left on the   |
+| stack, so a function that ends without a return statement returns 0.        |
+|                                                                             |
+| A function can only be called again while it is running by calling itself   |
+| (the functions that it calls are written before it, so they can't call it), |
+| so only a call to itself has to keep its variables: they are pushed before  |
+| the call, and popped back after it, under the returned value (which waits   |
+| in a scratch slot meanwhile).                                               |
+******************************************************************************/
+void Code_Generator::generate_function(const Function_node* definition) {
+	function = definition;
+	entries[definition->symbol] =
+		static_cast<std::uint32_t>(code->instructions.size());
+	check_declarations(definition->parameters);
+	check_declarations(definition->declarations);
+
+	frame_slots.clear();
+	for (const Declaration_node* list = definition->parameters; list;
+		 list = list->next) {
+		for (const Identifier_node* id = list->ids; id; id = id->next) {
+			frame_slots.push_back(slot(id->symbol));
+		}
+	}
+	std::size_t parameter_count = frame_slots.size();
+	parameter_counts[definition->symbol] =
+		static_cast<std::uint32_t>(parameter_count);
+	for (std::size_t i = parameter_count; i-- > 0;) {
+		emit(OP_POPM, frame_slots[i]);
+	}
+	for (const Declaration_node* list = definition->declarations; list;
+		 list = list->next) {
+		for (const Identifier_node* id = list->ids; id; id = id->next) {
+			frame_slots.push_back(slot(id->symbol));
+		}
+	}
+
+	generate_statements(definition->body);
+	const Statement_node* last = definition->body;
+	while (last && last->next) {
+		last = last->next;
+	}
+	if (!last || last->kind != STATEMENT_RETURN) {
+		emit(OP_PUSHI, 0);
+		emit(OP_RETURN);
+	}
+}
+
+/******************************************************************************
+| Statements can be nested as deeply as the syntax analyzer allows, so they   |
+| are generated with an explicit stack of frames. A list frame generates one  |
+| statement and stays on the stack for the next one, and an if or while       |
+| statement pushes a frame that finishes it (backpatches its jumps) above it, |
+| then its body's list frame above that:                                      |
+|                                                                             |
+|     while:  LABEL  condition  JUMPZ end  body  JUMP LABEL  end:             |
+|     if:     condition  JUMPZ end  body  end:                                |
+|     else:   condition  JUMPZ else  body  JUMP end  else: else_body  end:    |
+******************************************************************************/
+void Code_Generator::generate_statements(const Statement_node* list) {
+	frames.clear();
+	frames.push_back(Code_frame{ CODE_LIST, list, 0, 0 });
+	while (!frames.empty()) {
+		Code_frame frame = frames.back();
+		frames.pop_back();
+		switch (frame.step) {
+			case CODE_LIST:
+				if (frame.statement) {
+					frames.push_back(Code_frame{ CODE_LIST,
+												 frame.statement->next, 0, 0 });
+					generate_statement(frame.statement);
+				}
+				break;
+
+			case CODE_IF_BODY:
+				if (frame.statement->else_body) {
+					std::uint32_t jump = emit(OP_JUMP);
+					patch(frame.jump);
+					frames.push_back(Code_frame{ CODE_ELSE_BODY,
+												 frame.statement, jump, 0 });
+					frames.push_back(Code_frame{ CODE_LIST,
+												 frame.statement->else_body,
+												 0, 0 });
+				}
+				else {
+					patch(frame.jump);
+				}
+				break;
+
+			case CODE_ELSE_BODY:
+				patch(frame.jump);
+				break;
+
+			case CODE_WHILE_BODY:
+				emit(OP_JUMP, static_cast<std::int32_t>(frame.label));
+				patch(frame.jump);
+				break;
+		}
+	}
+}
+
+// generates the statement, or pushes the frames that will (see above)
+void Code_Generator::generate_statement(const Statement_node* statement) {
+	switch (statement->kind) {
+		case STATEMENT_COMPOUND:
+			frames.push_back(Code_frame{ CODE_LIST, statement->body, 0, 0 });
+			break;
+
+		case STATEMENT_ASSIGN:
+			generate_expression(statement->expression);
+			emit(OP_POPM, slot(statement->target_symbol));
+			break;
+
+		case STATEMENT_IF: {
+			generate_condition(statement->condition);
+			std::uint32_t jump = emit(OP_JUMPZ);
+			frames.push_back(Code_frame{ CODE_IF_BODY, statement, jump, 0 });
+			frames.push_back(Code_frame{ CODE_LIST, statement->body, 0, 0 });
+			break;
+		}
+
+		case STATEMENT_WHILE: {
+			std::uint32_t label = emit(OP_LABEL);
+			generate_condition(statement->condition);
+			std::uint32_t jump = emit(OP_JUMPZ);
+			frames.push_back(Code_frame{ CODE_WHILE_BODY, statement, jump,
+										 label });
+			frames.push_back(Code_frame{ CODE_LIST, statement->body, 0, 0 });
+			break;
+		}
+
+		case STATEMENT_RETURN:  // (the main body's return ends the program)
+			if (statement->expression) {
+				generate_expression(statement->expression);
+			}
+			else if (function) {
+				emit(OP_PUSHI, 0);
+			}
+			emit(function ? OP_RETURN : OP_HALT);
+			break;
+
+		case STATEMENT_PRINT:
+			generate_expression(statement->expression);
+			emit(OP_SOUT);
+			break;
+
+		case STATEMENT_SCAN:
+			for (const Identifier_node* id = statement->ids; id;
+				 id = id->next) {
+				emit(OP_SIN);
+				emit(OP_POPM, slot(id->symbol));
+			}
+			break;
+
+		case STATEMENT_ERROR:  // (never in an AST that passed)
+			break;
+	}
+}
+
+static Opcode operator_opcode(Symbol_id op) {
+	switch (op) {
+		case OPERATOR_PLUS: return OP_ADD;
+		case OPERATOR_MINUS: return OP_SUB;
+		case OPERATOR_MULTIPLY: return OP_MUL;
+		case OPERATOR_DIVIDE: return OP_DIV;
+		case OPERATOR_EQUAL: return OP_EQU;
+		case OPERATOR_NOT_EQUAL: return OP_NEQ;
+		case OPERATOR_GREATER: return OP_GRT;
+		case OPERATOR_LESS: return OP_LES;
+		case OPERATOR_LESS_EQUAL: return OP_LEQ;
+		default: return OP_GEQ;  // OPERATOR_GREATER_EQUAL
+	}
+}
+
+void Code_Generator::generate_condition(const Condition_node& condition) {
+	generate_expression(condition.left);
+	generate_expression(condition.right);
+	emit(operator_opcode(condition.relop));
+}
+
+// (operands first, then their operator: the stack is walked the same way as
+// the semantic pass walks it)
+void Code_Generator::generate_expression(const Expression_node* expression) {
+	expressions.clear();
+	expressions.push_back(Expression_item{ expression, false });
+	while (!expressions.empty()) {
+		Expression_item item = expressions.back();
+		expressions.pop_back();
+		const Expression_node* e = item.expression;
+		switch (e->kind) {
+			case EXPRESSION_IDENTIFIER:
+				emit(OP_PUSHM, slot(e->symbol));
+				break;
+
+			case EXPRESSION_CALL:
+				generate_call(e);
+				break;
+
+			case EXPRESSION_INTEGER:
+				push_integer(e, false);
+				break;
+
+			case EXPRESSION_REAL:
+				report_error(e->line, "Real number '" + std::string(e->lexeme)
+							 + "' can't be used: the stack machine only has"
+							 " integers");
+				break;
+
+			case EXPRESSION_TRUE:
+				emit(OP_PUSHI, 1);
+				break;
+
+			case EXPRESSION_FALSE:
+				emit(OP_PUSHI, 0);
+				break;
+
+			case EXPRESSION_NEGATE:  // 0 - operand (there is no NEG)
+				if (item.operands_done) {
+					emit(OP_SUB);
+				}
+				else if (e->left->kind == EXPRESSION_INTEGER) {
+					push_integer(e->left, true);
+				}
+				else {
+					emit(OP_PUSHI, 0);
+					expressions.push_back(Expression_item{ e, true });
+					expressions.push_back(Expression_item{ e->left, false });
+				}
+				break;
+
+			case EXPRESSION_BINARY:
+				if (item.operands_done) {
+					emit(operator_opcode(e->op));
+				}
+				else {
+					expressions.push_back(Expression_item{ e, true });
+					expressions.push_back(Expression_item{ e->right, false });
+					expressions.push_back(Expression_item{ e->left, false });
+				}
+				break;
+		}
+	}
+}
+
+// (see generate_function() for a call to the function being generated)
+void Code_Generator::generate_call(const Expression_node* call) {
+	std::uint32_t callee = call->symbol;
+	std::uint32_t argument_count = 0;
+	for (const Identifier_node* id = call->arguments; id; id = id->next) {
+		argument_count++;
+	}
+	if (argument_count != parameter_counts[callee]) {
+		report_error(call->line, "Function '" + std::string(call->lexeme)
+					 + "' is called with " + std::to_string(argument_count)
+					 + " argument(s), but has "
+					 + std::to_string(parameter_counts[callee])
+					 + " parameter(s)");
+		return;
+	}
+
+	bool recursive = (function && callee == function->symbol);
+	if (recursive) {
+		if (scratch < 0) {
+			scratch = static_cast<std::int32_t>(symbols->get_variable_count());
+		}
+		for (std::int32_t kept : frame_slots) {
+			emit(OP_PUSHM, kept);
+		}
+	}
+	for (const Identifier_node* id = call->arguments; id; id = id->next) {
+		emit(OP_PUSHM, slot(id->symbol));
+	}
+	emit(OP_CALL, static_cast<std::int32_t>(entries[callee]));
+	if (recursive) {
+		emit(OP_POPM, scratch);
+		for (std::size_t i = frame_slots.size(); i-- > 0;) {
+			emit(OP_POPM, frame_slots[i]);
+		}
+		emit(OP_PUSHM, scratch);
+	}
+}
+
+// PUSHI of an integer literal (negative -> of -literal, which can be one
+// lower than the lowest positive literal)
+void Code_Generator::push_integer(const Expression_node* literal,
+								  bool negative) {
+	std::uint32_t value = 0;
+	std::from_chars_result read = std::from_chars(
+		literal->lexeme.data(), literal->lexeme.data() + literal->lexeme.size(),
+		value);
+	std::uint32_t limit = negative ? 0x80000000u : 0x7FFFFFFFu;
+	if (read.ec != std::errc() || value > limit) {
+		report_error(literal->line, "Integer '" + std::string(literal->lexeme)
+					 + "' doesn't fit in the stack machine's 32 bits");
+		return;
+	}
+	std::int64_t pushed = negative ? -static_cast<std::int64_t>(value) : value;
+	emit(OP_PUSHI, static_cast<std::int32_t>(pushed));
+}
+
+void Code_Generator::check_declarations(const Declaration_node* list) {
+	for (; list; list = list->next) {
+		if (list->qualifier != KEYWORD_REAL) {
+			continue;
+		}
+		for (const Identifier_node* id = list->ids; id; id = id->next) {
+			report_error(id->line, "Identifier '" + std::string(id->name)
+						 + "' is real, but the stack machine only has"
+						 " integers");
+		}
+	}
+}
+
+// writes the error to the output file (the same way as the semantic pass)
+void Code_Generator::report_error(int line, std::string err_msg) {
+	if (ofs != nullptr) {
+		*ofs << line << ": ERROR - " << err_msg << "\n";
+	}
+
+	Diagnostic diagnostic;
+	diagnostic.line = line;
+	diagnostic.message = std::move(err_msg);
+	diagnostic.token = NO_TOKEN;
+	diagnostics.push_back(std::move(diagnostic));
+}
+
+const char* opcode_name(Opcode opcode) {
+	static const char* const NAMES[OPCODE_COUNT] = {
+		"PUSHI", "PUSHM", "POPM", "SOUT", "SIN", "ADD", "SUB", "MUL", "DIV",
+		"GRT", "LES", "EQU", "NEQ", "GEQ", "LEQ", "JUMPZ", "JUMP", "LABEL",
+		"CALL", "RETURN", "HALT"
+	};
+	return NAMES[opcode];
+}
+
+// writes text, then spaces up to width
+static void write_column(Output_buffer& out, std::string_view text,
+						 std::size_t width) {
+	out << text;
+	for (std::size_t i = text.size(); i < width; i++) {
+		out << ' ';
+	}
+}
+
+static std::string_view type_name(Symbol_id type) {
+	switch (type) {
+		case KEYWORD_INT: return "integer";
+		case KEYWORD_BOOL: return "boolean";
+		default: return "real";  // KEYWORD_REAL
+	}
+}
+
+/******************************************************************************
+| write_listing() writes one line per instruction (its number, its opcode,    |
+| and its operand, if it has one), then the symbol table: each variable and   |
+| parameter, in the order they were declared, with its memory location and    |
+| its type. Numbers are formatted into a small buffer with to_chars(), so a   |
+| long listing doesn't allocate a string per line.                            |
+******************************************************************************/
+void write_listing(const Stack_code& code, const Symbol_table& symbols,
+				   Output_buffer& listing) {
+	char number[16];
+	std::size_t number_width =
+		std::to_chars(number, number + sizeof(number),
+					  code.instructions.size()).ptr - number;
+	for (std::size_t i = 0; i < code.instructions.size(); i++) {
+		const Instruction& instruction = code.instructions[i];
+		char* end = std::to_chars(number, number + sizeof(number), i + 1).ptr;
+		for (std::size_t c = end - number; c < number_width; c++) {
+			listing << ' ';
+		}
+		listing << std::string_view(number, end - number) << "  ";
+
+		std::int64_t operand = instruction.operand;
+		switch (instruction.opcode) {
+			case OP_PUSHI:
+				break;
+			case OP_PUSHM:
+			case OP_POPM:
+				operand += MEMORY_BASE;
+				break;
+			case OP_JUMPZ:
+			case OP_JUMP:
+			case OP_CALL:
+				operand += 1;  // (numbered from 1)
+				break;
+			default:  // (no operand)
+				listing << opcode_name(instruction.opcode) << "\n";
+				continue;
+		}
+		write_column(listing, opcode_name(instruction.opcode), 7);
+		end = std::to_chars(number, number + sizeof(number), operand).ptr;
+		listing << std::string_view(number, end - number) << "\n";
+	}
+
+	std::size_t name_width = 10;  // "Identifier"
+	for (std::size_t i = 0; i < symbols.symbol_count(); i++) {
+		std::size_t length = symbols.name(symbols.symbol(i).name).size();
+		name_width = (length > name_width) ? length : name_width;
+	}
+	listing << "\nSymbol Table\n";
+	write_column(listing, "Identifier", name_width + 2);
+	listing << "MemoryLocation  Type\n";
+	for (std::size_t i = 0; i < symbols.symbol_count(); i++) {
+		const Symbol& symbol = symbols.symbol(i);
+		if (symbol.kind == DECLARED_FUNCTION) {
+			continue;
+		}
+		write_column(listing, symbols.name(symbol.name), name_width + 2);
+		char* end = std::to_chars(number, number + sizeof(number),
+								  MEMORY_BASE + symbol.address).ptr;
+		write_column(listing, std::string_view(number, end - number), 16);
+		listing << type_name(symbol.type) << "\n";
+	}
+	listing.flush();
+}
+
+/******************************************************************************
+| The binary form of the code is a header, then each instruction as its       |
+| opcode (1 byte) and its operand (4 bytes, unaligned):                       |
+|                                                                             |
+|     "R23SCODE"  uint32 instruction_count  uint32 memory_size                |
+|     instruction_count x { uint8 opcode, int32 operand }                     |
+|                                                                             |
+| Numbers are stored in the machine's own byte order (like the compile        |
+| cache, it is meant to be read back on the same machine). load_code() checks |
+| every instruction, so that a machine running the code never has to: every   |
+| opcode is known, every memory slot is below memory_size, and every jump or  |
+| call lands on an instruction (or just after the last one, which ends the    |
+| program). memory_size itself is limited, since a machine allocates all of   |
+| it before it starts.                                                        |
+******************************************************************************/
+static const char CODE_MAGIC[8] = {'R', '2', '3', 'S', 'C', 'O', 'D', 'E'};
+static const std::size_t CODE_HEADER_SIZE = sizeof(CODE_MAGIC) + 8;
+static const std::size_t CODE_RECORD_SIZE = 5;
+static const std::uint32_t MAX_CODE_MEMORY = 1 << 24;  // (slots: 64 MiB)
+
+// (an Output_buffer would write newlines as CRLF on Windows, so the bytes
+// are collected in a string and written in binary mode, like a cache entry)
+bool save_code(const Stack_code& code, const std::string& file_name) {
+	std::string bytes;
+	bytes.reserve(CODE_HEADER_SIZE
+				  + CODE_RECORD_SIZE * code.instructions.size());
+	char header[CODE_HEADER_SIZE];
+	std::uint32_t instruction_count =
+		static_cast<std::uint32_t>(code.instructions.size());
+	std::memcpy(header, CODE_MAGIC, sizeof(CODE_MAGIC));
+	std::memcpy(header + 8, &instruction_count, 4);
+	std::memcpy(header + 12, &code.memory_size, 4);
+	bytes.append(header, sizeof(header));
+
+	char record[CODE_RECORD_SIZE];
+	for (const Instruction& instruction : code.instructions) {
+		record[0] = static_cast<char>(instruction.opcode);
+		std::memcpy(record + 1, &instruction.operand, 4);
+		bytes.append(record, sizeof(record));
+	}
+	std::ofstream file(file_name, std::ios::binary);
+	file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	return static_cast<bool>(file);
+}
+
+bool load_code(const std::string& file_name, Stack_code& code) {
+	Source_buffer file;
+	if (!file.open(file_name)) {
+		return false;
+	}
+	const char* position = file.begin();
+	std::size_t size = file.end() - file.begin();
+	std::uint32_t instruction_count;
+	if (size < CODE_HEADER_SIZE
+		|| std::memcmp(position, CODE_MAGIC, sizeof(CODE_MAGIC)) != 0) {
+		return false;
+	}
+	std::memcpy(&instruction_count, position + 8, 4);
+	std::memcpy(&code.memory_size, position + 12, 4);
+	if ((size - CODE_HEADER_SIZE) / CODE_RECORD_SIZE != instruction_count
+		|| (size - CODE_HEADER_SIZE) % CODE_RECORD_SIZE != 0
+		|| code.memory_size > MAX_CODE_MEMORY) {
+		return false;
+	}
+
+	position += CODE_HEADER_SIZE;
+	code.instructions.resize(instruction_count);
+	for (Instruction& instruction : code.instructions) {
+		unsigned char opcode = static_cast<unsigned char>(position[0]);
+		std::memcpy(&instruction.operand, position + 1, 4);
+		position += CODE_RECORD_SIZE;
+		if (opcode >= OPCODE_COUNT) {
+			return false;
+		}
+		instruction.opcode = static_cast<Opcode>(opcode);
+
+		std::int64_t operand = instruction.operand;
+		switch (instruction.opcode) {
+			case OP_PUSHM:
+			case OP_POPM:
+				if (operand < 0 || operand >= code.memory_size) {
+					return false;
+				}
+				break;
+			case OP_JUMPZ:
+			case OP_JUMP:
+			case OP_CALL:
+				if (operand < 0 || operand > instruction_count) {
+					return false;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	return true;
+}
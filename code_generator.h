@@ -0,0 +1,134 @@
+#pragma once
+#ifndef CODE_GENERATOR_H_
+#define CODE_GENERATOR_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <cstdint>  // operands
+#include <string>  // file names, error messages
+#include <vector>  // instructions, diagnostics, explicit stacks
+
+#include "ast.h"  // Program_node
+#include "output_buffer.h"  // output file, listing
+#include "symbol_table.h"  // Symbol_table (memory addresses)
+#include "syntax_analyzer.h"  // Diagnostic
+
+/******************************************************************************
+| The Rat23S stack machine has an operand stack, a memory of integer slots    |
+| (one per variable, at the address the Symbol_table gave it), and a program  |
+| of instructions that is run from the first one. Comparisons push 1 or 0,    |
+| and JUMPZ pops the value that decides whether to jump. CALL, RETURN and     |
+| HALT aren't in the original instruction set: they are only used by          |
+| programs that have functions (see code_generator.cpp).                      |
+******************************************************************************/
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+enum Opcode : std::uint8_t {
+	OP_PUSHI,  // push the operand
+	OP_PUSHM,  // push memory[operand]
+	OP_POPM,  // pop into memory[operand]
+	OP_SOUT,  // pop and print
+	OP_SIN,  // read an integer and push it
+	OP_ADD,  // pop b, pop a, push a + b
+	OP_SUB,  // ... a - b
+	OP_MUL,  // ... a * b
+	OP_DIV,  // ... a / b
+	OP_GRT,  // pop b, pop a, push a > b
+	OP_LES,  // ... a < b
+	OP_EQU,  // ... a == b
+	OP_NEQ,  // ... a != b
+	OP_GEQ,  // ... a >= b
+	OP_LEQ,  // ... a <= b
+	OP_JUMPZ,  // pop, and jump to instruction operand if it is 0
+	OP_JUMP,  // jump to instruction operand
+	OP_LABEL,  // does nothing (marks where a while loop starts)
+	OP_CALL,  // jump to instruction operand, and come back after RETURN
+	OP_RETURN,  // jump back to the instruction after the last CALL
+	OP_HALT  // stop the program
+};
+const int OPCODE_COUNT = OP_HALT + 1;
+
+const std::int32_t MEMORY_BASE = 5000;  // address of memory[0] in a listing
+
+struct Instruction {
+	Opcode opcode;
+	std::int32_t operand;  // a value, memory slot or instruction index (or 0)
+};
+
+struct Stack_code {  // a whole program for the stack machine
+	std::vector<Instruction> instructions;
+	std::uint32_t memory_size = 0;  // memory slots that it uses
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Code_Generator {  // translates a checked AST into stack machine code
+	private:
+		enum Code_step : std::uint8_t {
+			CODE_LIST,  // the statements from statement on
+			CODE_IF_BODY,  // after the body of if statement
+			CODE_ELSE_BODY,  // after the else body of if statement
+			CODE_WHILE_BODY  // after the body of while statement
+		};
+
+		struct Code_frame {
+			Code_step step;
+			const Statement_node* statement;
+			std::uint32_t jump;  // (if, while) the jump to backpatch
+			std::uint32_t label;  // (while) its LABEL
+		};
+
+		struct Expression_item {
+			const Expression_node* expression;
+			bool operands_done;  // (negate, binary) its operator is next
+		};
+
+		const Symbol_table* symbols;  // (filled in by the semantic pass)
+		Stack_code* code;  // filled in by Generate()
+		Output_buffer* ofs;  // write to output file (if there is one)
+		std::vector<Diagnostic> diagnostics;  // errors found so far
+		std::vector<Code_frame> frames;  // (explicit stack)
+		std::vector<Expression_item> expressions;  // (explicit stack)
+		std::vector<std::uint32_t> entries;  // by symbol: first instruction
+		std::vector<std::uint32_t> parameter_counts;  // by symbol
+		const Function_node* function = nullptr;  // null -> main body
+		std::vector<std::int32_t> frame_slots;  // function's memory slots
+		std::int32_t scratch = -1;  // memory slot for recursive calls
+
+		std::uint32_t emit(Opcode opcode, std::int32_t operand = 0);
+		void patch(std::uint32_t jump);  // jumps to the next instruction
+		std::int32_t slot(std::uint32_t symbol) const;
+		void generate_function(const Function_node* definition);
+		void generate_statements(const Statement_node* list);
+		void generate_statement(const Statement_node* statement);
+		void generate_condition(const Condition_node& condition);
+		void generate_expression(const Expression_node* expression);
+		void generate_call(const Expression_node* call);
+		void push_integer(const Expression_node* literal, bool negative);
+		void check_declarations(const Declaration_node* list);
+		void report_error(int line, std::string err_msg);
+
+	public:
+		Code_Generator(const Symbol_table* symbol_table, Stack_code* stack_code,
+					   Output_buffer* output_file);  // constructor
+
+		// size_hint: about how many instructions there will be (the code's
+		// array is allocated for that many at the start)
+		std::vector<Diagnostic> Generate(const Program_node* program,
+										 std::size_t size_hint);
+};
+
+
+/* -------------------------- FUNCTION PROTOTYPES -------------------------- */
+const char* opcode_name(Opcode opcode);  // ie. OP_PUSHI -> "PUSHI"
+
+// the instructions (numbered from 1) and the symbol table, the way they are
+// listed for Rat23S (memory slots are shown from MEMORY_BASE)
+void write_listing(const Stack_code& code, const Symbol_table& symbols,
+				   Output_buffer& listing);
+
+// the binary form: a header, then 5 bytes per instruction (see save_code())
+bool save_code(const Stack_code& code, const std::string& file_name);
+bool load_code(const std::string& file_name, Stack_code& code);  // validated
+
+#endif
@@ -0,0 +1,257 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstring>  // memcpy()  memcmp()
+#include <filesystem>  // cache directory, rename()
+#include <fstream>  // entry files
+#include <random>  // random_device
+#include <string>
+#include <string_view>  // stored output text
+#include <system_error>  // error_code
+
+#include "compile_cache.h"
+#include "output_buffer.h"  // output text
+#include "source_buffer.h"  // memory-mapped entry files
+
+/******************************************************************************
+| A cache entry is one file named after its key (a hash of the analyzer's     |
+| version, the options that change the output, and the input's bytes). It     |
+| holds a header, then every diagnostic, then the output text:                |
+|                                                                             |
+|     Entry_header                                                            |
+|     diagnostic_count x { int32 line, Token token, uint32 size, message }    |
+|     output_size bytes of output text                                        |
+|                                                                             |
+| Numbers are stored in the machine's own byte order (a cache directory is    |
+| only meant to be shared by builds on one machine). The input's size is      |
+| stored too, so that a hash collision between inputs of different sizes is   |
+| never mistaken for a hit.                                                   |
+******************************************************************************/
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+static const char ENTRY_MAGIC[8] = {'R', '2', '3', 'S', 'C', 'A', 'C', 'H'};
+
+struct Entry_header {
+	char magic[8];
+	std::uint64_t key;
+	std::uint64_t input_size;
+	std::uint64_t output_size;
+	std::uint32_t diagnostic_count;
+	std::uint32_t lexed;
+};
+
+// appends the bytes of value to entry
+template <typename T>
+static void append_value(std::string& entry, const T& value) {
+	entry.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// copies the next value out of [position, end) (false if there isn't one)
+template <typename T>
+static bool read_value(const char*& position, const char* end, T& value) {
+	if (static_cast<std::size_t>(end - position) < sizeof(T)) {
+		return false;
+	}
+	std::memcpy(&value, position, sizeof(T));
+	position += sizeof(T);
+	return true;
+}
+
+std::uint64_t fnv1a_hash(const char* begin, const char* end,
+						 std::uint64_t hash) {
+	for (const char* c = begin; c != end; c++) {
+		hash ^= static_cast<unsigned char>(*c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+Compile_cache::Compile_cache(const std::string& cache_directory)
+	: directory(cache_directory) {
+	std::random_device random;
+	temporary_prefix = std::to_string(random()) + std::to_string(random());
+	if (!directory.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+	}
+}
+
+bool Compile_cache::enabled() const {
+	return !directory.empty();
+}
+
+std::size_t Compile_cache::hits() const {
+	return hit_count.load();
+}
+
+std::size_t Compile_cache::misses() const {
+	return miss_count.load();
+}
+
+std::string Compile_cache::entry_name(std::uint64_t key) const {
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+	std::string name(16, '0');
+	for (int i = 15; i >= 0; i--, key >>= 4) {
+		name[i] = HEX_DIGITS[key & 0xF];
+	}
+	return (std::filesystem::path(directory) / (name + ".rcache")).string();
+}
+
+/******************************************************************************
+| compile() looks for the input in the cache before compiling it. On a hit,   |
+| the stored output text is copied straight from the mapped entry file to     |
+| options.output, and the stored diagnostics are returned, without lexing or  |
+| parsing anything. On a miss, the input is compiled with its output kept in  |
+| memory, which is saved in a new entry and then written to options.output.   |
+| Either way, the output is the same as compile() would have written.         |
+|                                                                             |
+| Several threads may share one cache (see batch.cpp): the counters are       |
+| atomic, and a new entry is written to a file of its own and then renamed,   |
+| so a reader never sees half of an entry.                                    |
+******************************************************************************/
+Compile_summary Compile_cache::compile(const char* text_begin,
+									   const char* text_end,
+									   const Compile_options& options) {
+	Compile_summary summary;
+	std::size_t input_size = text_end - text_begin;
+	std::uint64_t key = 0;
+	if (enabled()) {
+		const char* version = ANALYZER_VERSION;
+		char trace = options.trace ? 'T' : 'N';
+		char semantic = options.semantic ? 'S' : 'N';
+		char generate = options.generate ? 'G' : 'N';
+		key = fnv1a_hash(version, version + std::strlen(version));
+		key = fnv1a_hash(&trace, &trace + 1, key);
+		key = fnv1a_hash(&semantic, &semantic + 1, key);
+		key = fnv1a_hash(&generate, &generate + 1, key);
+		const char* max_depth =
+			reinterpret_cast<const char*>(&options.max_depth);
+		key = fnv1a_hash(max_depth, max_depth + sizeof(options.max_depth),
+						 key);
+		key = fnv1a_hash(text_begin, text_end, key);
+		if (load(key, input_size, options, summary)) {
+			hit_count++;
+			summary.from_cache = true;
+			return summary;
+		}
+		miss_count++;
+	}
+
+	std::string output;
+	Output_buffer memory(&output);
+	Compile_options compile_options = options;
+	if (enabled()) {
+		compile_options.output = &memory;  // (kept for the entry)
+	}
+	{
+		Compilation compilation = ::compile(text_begin, text_end,
+											compile_options);
+		summary.lexed = compilation.lexed();
+		summary.diagnostics = compilation.diagnostics();
+		summary.memo = compilation.memo_stats();
+	}
+	if (!enabled()) {
+		return summary;
+	}
+
+	memory.flush();
+	store(key, input_size, output, summary);
+	if (options.output != nullptr) {
+		*options.output << std::string_view(output);
+		options.output->flush();
+	}
+	return summary;
+}
+
+// reads the entry of key into summary and writes its output text (false if
+// there is no usable entry)
+bool Compile_cache::load(std::uint64_t key, std::size_t input_size,
+						 const Compile_options& options,
+						 Compile_summary& summary) {
+	Source_buffer entry;
+	if (!entry.open(entry_name(key))) {
+		return false;
+	}
+	const char* position = entry.begin();
+	const char* end = entry.end();
+
+	Entry_header header;
+	if (!read_value(position, end, header)
+		|| std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0
+		|| header.key != key || header.input_size != input_size) {
+		return false;
+	}
+
+	summary.lexed = (header.lexed != 0);
+	summary.diagnostics.clear();
+	for (std::uint32_t i = 0; i < header.diagnostic_count; i++) {
+		Diagnostic diagnostic;
+		std::int32_t line;
+		std::uint32_t message_size;
+		if (!read_value(position, end, line)
+			|| !read_value(position, end, diagnostic.token)
+			|| !read_value(position, end, message_size)
+			|| static_cast<std::size_t>(end - position) < message_size) {
+			return false;
+		}
+		diagnostic.line = line;
+		diagnostic.message.assign(position, message_size);
+		position += message_size;
+		summary.diagnostics.push_back(diagnostic);
+	}
+	if (static_cast<std::uint64_t>(end - position) != header.output_size) {
+		return false;  // (a damaged entry is compiled again)
+	}
+
+	if (options.output != nullptr) {
+		*options.output << std::string_view(position, header.output_size);
+		options.output->flush();
+	}
+	return true;
+}
+
+// saves a new entry (a cache that can't be written to is just never hit)
+void Compile_cache::store(std::uint64_t key, std::size_t input_size,
+						  const std::string& output,
+						  const Compile_summary& summary) {
+	Entry_header header;
+	std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+	header.key = key;
+	header.input_size = input_size;
+	header.output_size = output.size();
+	header.diagnostic_count =
+		static_cast<std::uint32_t>(summary.diagnostics.size());
+	header.lexed = summary.lexed;
+
+	std::string entry;
+	append_value(entry, header);
+	for (const Diagnostic& diagnostic : summary.diagnostics) {
+		append_value(entry, static_cast<std::int32_t>(diagnostic.line));
+		append_value(entry, diagnostic.token);
+		append_value(entry,
+					 static_cast<std::uint32_t>(diagnostic.message.size()));
+		entry += diagnostic.message;
+	}
+
+	// written under a name no other thread/process uses, then renamed
+	std::string name = entry_name(key);
+	std::string temporary = name + "." + temporary_prefix + "."
+		+ std::to_string(temporary_count++) + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		if (!file.is_open()) {
+			return;
+		}
+		file.write(entry.data(), entry.size());
+		file.write(output.data(), output.size());
+		if (!file) {
+			file.close();
+			std::error_code error;
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, name, error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef COMPILE_CACHE_H_
+#define COMPILE_CACHE_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <atomic>  // counters (shared by batch workers)
+#include <cstddef>  // size_t
+#include <cstdint>  // keys
+#include <string>  // cache directory
+#include <vector>  // diagnostics
+
+#include "compiler.h"  // compile(), Compile_options, Diagnostic
+
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+// what is kept of a compilation when it may come from the cache (the output
+// file text is written to Compile_options::output either way)
+struct Compile_summary {
+	bool lexed = false;  // passed the LA phase
+	std::vector<Diagnostic> diagnostics;
+	bool from_cache = false;
+	Memo_stats memo;  // (packrat) not kept in the cache
+
+	bool passed() const { return lexed && diagnostics.empty(); }
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Compile_cache {  // on-disk results of earlier compilations
+	private:
+		std::string directory;  // "" -> no caching
+		std::atomic<std::size_t> hit_count{0};
+		std::atomic<std::size_t> miss_count{0};
+		std::string temporary_prefix;  // unique to this cache (see store())
+		std::atomic<std::size_t> temporary_count{0};
+
+		std::string entry_name(std::uint64_t key) const;
+		bool load(std::uint64_t key, std::size_t input_size,
+				  const Compile_options& options, Compile_summary& summary);
+		void store(std::uint64_t key, std::size_t input_size,
+				   const std::string& output, const Compile_summary& summary);
+
+	public:
+		explicit Compile_cache(const std::string& cache_directory);
+		Compile_cache(const Compile_cache&) = delete;
+		Compile_cache& operator=(const Compile_cache&) = delete;
+
+		bool enabled() const;
+		Compile_summary compile(const char* text_begin, const char* text_end,
+								const Compile_options& options);
+		std::size_t hits() const;
+		std::size_t misses() const;
+};
+
+
+/* -------------------------- FUNCTION PROTOTYPES -------------------------- */
+// 64-bit FNV-1a hash of [begin, end), continued from hash
+std::uint64_t fnv1a_hash(const char* begin, const char* end,
+						 std::uint64_t hash = 14695981039346656037ull);
+
+#endif
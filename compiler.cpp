@@ -0,0 +1,194 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <memory>  // make_unique()
+#include <string>  // to_string()
+#include <thread>  // pipelined lexer
+
+#include "compiler.h"
+#include "token_ring.h"  // pipelined tokens
+
+bool Compilation::passed() const {
+	return lexer_passed && result.passed();
+}
+
+bool Compilation::lexed() const {
+	return lexer_passed;
+}
+
+// every token that was recorded (up to the error, if the LA phase failed)
+const Token_stream& Compilation::tokens() const {
+	if (analyzer) {  // (a pipelined lexer hands its tokens to the analyzer)
+		return analyzer->get_tokens();
+	}
+	return lexer ? lexer->get_tokens() : no_tokens;
+}
+
+const Program_node* Compilation::program() const {
+	return result.program;
+}
+
+const std::vector<Diagnostic>& Compilation::diagnostics() const {
+	return result.diagnostics;
+}
+
+const Memo_stats& Compilation::memo_stats() const {
+	return result.memo;
+}
+
+const Symbol_table* Compilation::symbols() const {
+	return symbol_table.get();
+}
+
+const Stack_code* Compilation::code() const {
+	return stack_code.get();
+}
+
+/******************************************************************************
+| compile() runs the same phases as the command line program. A lexical error |
+| stops the compilation before the SA phase: it becomes the only diagnostic,  |
+| and the same message that main used to write is written to the output.      |
+| An input over MAX_INPUT_SIZE bytes isn't lexed at all (its diagnostic is on |
+| line 0). Syntax errors don't stop it (see Syntax_Analyzer::print_error()),  |
+| but the semantic checks are only run on a program whose syntax is correct   |
+| (they need the whole AST), and code is only generated for a program that    |
+| passed them (it needs every name's symbol).                                 |
+******************************************************************************/
+Compilation compile(const char* text_begin, const char* text_end,
+					const Compile_options& options) {
+	Compilation compilation;
+	if (static_cast<std::size_t>(text_end - text_begin) > MAX_INPUT_SIZE) {
+		Diagnostic diagnostic;
+		diagnostic.line = 0;
+		diagnostic.message = "File is too large: "
+			+ std::to_string(text_end - text_begin) + " bytes (the limit is "
+			+ std::to_string(MAX_INPUT_SIZE) + ")";
+		diagnostic.token = NO_TOKEN;
+		compilation.result.diagnostics.push_back(diagnostic);
+		if (options.output != nullptr) {
+			*options.output << "ERROR: " << diagnostic.message << ".\n";
+			options.output->flush();
+		}
+		return compilation;
+	}
+	compilation.lexer = std::make_unique<Lexer>(text_begin, text_end);
+	compilation.lexer->set_thread_count(options.lexer_threads);
+
+	if (options.pipelined) {
+		compilation.analyze_pipelined(text_begin, text_end, options);
+	}
+	else if (compilation.lexer->Analyze() == 0) {  // Lexical Analysis
+		compilation.lexer_passed = true;
+
+		// Syntax Analysis
+		compilation.analyzer = std::make_unique<Syntax_Analyzer>(
+			&compilation.lexer->get_tokens(), options.output);
+		compilation.analyzer->set_parse_mode(options.mode);
+		compilation.analyzer->set_trace(options.trace);
+		compilation.analyzer->set_packrat(options.packrat_entries);
+		compilation.analyzer->set_max_depth(options.max_depth);
+		compilation.result = compilation.analyzer->Rat23S();
+	}
+
+	if ((options.semantic || options.generate)
+		&& compilation.result.program != nullptr) {
+		compilation.analyze_semantics(options);
+	}
+	if (options.generate && compilation.result.program != nullptr) {
+		compilation.generate_code(options);
+	}
+
+	if (!compilation.lexer_passed) {
+		Diagnostic diagnostic;
+		diagnostic.line = compilation.lexer->get_line_number();
+		diagnostic.message = "File failed lexical analysis";
+		diagnostic.token = NO_TOKEN;
+		compilation.result.diagnostics.push_back(diagnostic);
+		if (options.output != nullptr) {
+			*options.output << "ERROR: File failed lexical analysis on line "
+				<< diagnostic.line << ".\n";
+			options.output->flush();
+		}
+	}
+	return compilation;
+}
+
+/******************************************************************************
+| Pipelined mode runs the LA and SA phases at the same time: the lexer runs   |
+| on a thread of its own and hands each token to the analyzer through a       |
+| Token_ring, so parsing starts with the first token instead of after the     |
+| last one. The results are the same as lexing first: if the lexer finds an   |
+| error, the analysis is abandoned (the analyzer throws Lexical_error when it |
+| receives the error) and the text that it already wrote is taken back.       |
+******************************************************************************/
+void Compilation::analyze_pipelined(const char* text_begin,
+									const char* text_end,
+									const Compile_options& options) {
+	Token_ring ring;
+	std::size_t output_start = options.output ? options.output->position() : 0;
+	analyzer = std::make_unique<Syntax_Analyzer>(&ring, text_begin, text_end,
+												 options.output);
+	analyzer->set_parse_mode(options.mode);
+	analyzer->set_trace(options.trace);
+	analyzer->set_packrat(options.packrat_entries);
+	analyzer->set_max_depth(options.max_depth);
+
+	int lexer_result = 0;
+	std::thread lexing([this, &ring, &lexer_result] {
+		lexer_result = lexer->Analyze(ring);
+	});
+	try {
+		result = analyzer->Rat23S();
+		analyzer->receive_rest();
+	}
+	catch (Lexical_error&) {
+		result = Syntax_result();
+		if (options.output != nullptr) {
+			options.output->truncate(output_start);
+		}
+	}
+	lexing.join();
+	lexer_passed = (lexer_result == 0);
+}
+
+// declarations and uses of identifiers (see semantic_analyzer.cpp). their
+// errors are added to the syntax analysis' (none), and leave no program
+void Compilation::analyze_semantics(const Compile_options& options) {
+	symbol_table = std::make_unique<Symbol_table>();
+	Semantic_Analyzer checker(symbol_table.get(), options.output);
+	result.diagnostics = checker.Analyze(result.program);
+	if (!result.diagnostics.empty()) {
+		result.program = nullptr;
+	}
+}
+
+// stack machine code (see code_generator.cpp). its errors leave no program,
+// and no code
+void Compilation::generate_code(const Compile_options& options) {
+	stack_code = std::make_unique<Stack_code>();
+	Code_Generator generator(symbol_table.get(), stack_code.get(),
+							 options.output);
+	result.diagnostics = generator.Generate(result.program,
+											tokens().tokens.size());
+	if (!result.diagnostics.empty()) {
+		result.program = nullptr;
+		stack_code.reset();
+	}
+}
+
+Compilation compile_file(const std::string& file_name,
+						 const Compile_options& options) {
+	std::unique_ptr<Source_buffer> source = std::make_unique<Source_buffer>();
+	if (!source->open(file_name)) {
+		Compilation compilation;
+		Diagnostic diagnostic;
+		diagnostic.line = 0;
+		diagnostic.message = "Couldn't open file '" + file_name + "'";
+		diagnostic.token = NO_TOKEN;
+		compilation.result.diagnostics.push_back(diagnostic);
+		return compilation;
+	}
+
+	Compilation compilation = compile(source->begin(), source->end(), options);
+	compilation.source = std::move(source);
+	return compilation;
+}
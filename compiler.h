@@ -0,0 +1,92 @@
+#pragma once
+#ifndef COMPILER_H_
+#define COMPILER_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <memory>  // owned analyzers
+#include <string>  // file name
+#include <vector>  // diagnostics
+
+#include "ast.h"  // Program_node
+#include "code_generator.h"  // Code_Generator, Stack_code
+#include "lexer.h"  // Lexer, Token_stream
+#include "output_buffer.h"  // output (trace and errors)
+#include "semantic_analyzer.h"  // Semantic_Analyzer (declarations)
+#include "source_buffer.h"  // input file (compile_file())
+#include "symbol_table.h"  // Symbol_table
+#include "syntax_analyzer.h"  // Syntax_Analyzer, Diagnostic, Parse_mode
+
+/******************************************************************************
+| The front end as a library: compile() runs the LA and SA phases (and the    |
+| semantic checks and code generation, if asked to) over a buffer and returns |
+| everything they found. Nothing is shared between two compilations, nothing  |
+| is printed to the console, and errors never end the program, so separate    |
+| compilations can run on separate threads at the same time.                  |
+******************************************************************************/
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+// changed whenever compile() can write different output or diagnostics for
+// the same input (results saved by Compile_cache are only reused if they were
+// made by the same version)
+#define ANALYZER_VERSION "rat23s-sa 16"
+
+struct Compile_options {
+	Parse_mode mode = PARSE_PREDICTIVE;
+	bool trace = true;  // print every token and its productions to output
+	unsigned lexer_threads = 0;  // 0 -> one per core, 1 -> never parallel
+	bool pipelined = false;  // lex on another thread while the SA phase runs
+	std::size_t packrat_entries = 0;  // memo table size (0 -> no packrat)
+	std::size_t max_depth = DEFAULT_MAX_DEPTH;  // nesting limit (0 -> none)
+	bool semantic = false;  // check declarations if the syntax is correct
+	bool generate = false;  // stack machine code too (checks declarations)
+	Output_buffer* output = nullptr;  // output file text (null -> none)
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Compilation {  // the results of compiling one input (owns all of them)
+	private:
+		std::unique_ptr<Source_buffer> source;  // (only for compile_file())
+		std::unique_ptr<Lexer> lexer;  // owns the tokens
+		std::unique_ptr<Syntax_Analyzer> analyzer;  // owns the AST's nodes
+		std::unique_ptr<Symbol_table> symbol_table;  // (semantic)
+		std::unique_ptr<Stack_code> stack_code;  // (generate)
+		Token_stream no_tokens;  // tokens() if the input couldn't be read
+		Syntax_result result;
+		bool lexer_passed = false;
+
+		void analyze_pipelined(const char* text_begin, const char* text_end,
+							   const Compile_options& options);
+		void analyze_semantics(const Compile_options& options);
+		void generate_code(const Compile_options& options);
+
+		friend Compilation compile(const char* text_begin,
+								   const char* text_end,
+								   const Compile_options& options);
+		friend Compilation compile_file(const std::string& file_name,
+										const Compile_options& options);
+
+	public:
+		bool passed() const;  // no errors at all
+		bool lexed() const;  // passed the LA phase (the SA phase was run)
+		const Token_stream& tokens() const;
+		const Program_node* program() const;  // null if it didn't pass
+		const std::vector<Diagnostic>& diagnostics() const;
+		const Memo_stats& memo_stats() const;  // (packrat_entries > 0)
+		const Symbol_table* symbols() const;  // null if not checked (semantic)
+		const Stack_code* code() const;  // null if not generated (generate)
+};
+
+
+/* -------------------------- FUNCTION PROTOTYPES -------------------------- */
+// the tokens and AST point into [text_begin, text_end), which has to outlive
+// the Compilation
+Compilation compile(const char* text_begin, const char* text_end,
+					const Compile_options& options = Compile_options());
+
+// reads the file itself (a file that can't be read is a diagnostic on line 0)
+Compilation compile_file(const std::string& file_name,
+						 const Compile_options& options = Compile_options());
+
+#endif
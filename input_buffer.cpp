@@ -0,0 +1,112 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // min()
+#include <cerrno>  // EINTR
+
+#ifdef _WIN32
+#include <io.h>  // _read()
+#else
+#include <unistd.h>  // read()
+#endif
+
+#include "input_buffer.h"
+
+/******************************************************************************
+| The input is read from the OS a whole buffer at a time, and integers are    |
+| parsed straight out of the buffer, so a program that reads a lot of numbers |
+| doesn't make a call (or go through a stream) for each one. A number can be  |
+| split between two reads, so the characters are read through peek(), which   |
+| refills the buffer when it runs out. Through a stream, a refill waits for   |
+| one character, and then only takes what the stream already has, so that a   |
+| get() at the console never waits for more than a line.                      |
+******************************************************************************/
+Input_buffer::Input_buffer(std::streambuf* input_stream, std::size_t capacity)
+	: fd(input_stream ? -1 : 0), stream(input_stream), buffer(capacity) {
+	next = end = buffer.data();
+}
+
+Input_buffer::Input_buffer(std::string_view input_text)
+	: next(input_text.data()), end(input_text.data() + input_text.size()) {}
+
+bool Input_buffer::fill() {
+	if (stream) {
+		int c = stream->sbumpc();
+		if (c == std::char_traits<char>::eof()) {
+			stream = nullptr;
+			return false;
+		}
+		buffer[0] = static_cast<char>(c);
+		std::streamsize count = 1;
+		std::streamsize available = stream->in_avail();
+		if (available > 0) {
+			count += stream->sgetn(buffer.data() + 1,
+								   std::min<std::streamsize>(
+									   available, buffer.size() - 1));
+		}
+		next = buffer.data();
+		end = next + count;
+		return true;
+	}
+	if (fd < 0) {
+		return false;
+	}
+	for (;;) {
+#ifdef _WIN32
+		int count = _read(fd, buffer.data(),
+						  static_cast<unsigned>(buffer.size()));
+#else
+		ssize_t count = ::read(fd, buffer.data(), buffer.size());
+#endif
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			fd = -1;  // (the end, or an error: nothing more can be read)
+			return false;
+		}
+		next = buffer.data();
+		end = next + count;
+		return true;
+	}
+}
+
+bool Input_buffer::buffered() const {
+	return next != end || (fd < 0 && !stream)
+		|| (stream && stream->in_avail() > 0);
+}
+
+// the next character, without reading it (-1 at the end of the input)
+int Input_buffer::peek() {
+	if (next == end && !fill()) {
+		return -1;
+	}
+	return static_cast<unsigned char>(*next);
+}
+
+bool Input_buffer::read_integer(std::int32_t& value) {
+	int c = peek();
+	while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+		next++;
+		c = peek();
+	}
+
+	bool negative = (c == '-');
+	if (c == '-' || c == '+') {
+		next++;
+		c = peek();
+	}
+	if (c < '0' || c > '9') {
+		return false;
+	}
+	std::int64_t magnitude = 0;
+	std::int64_t limit = negative ? 2147483648ll : 2147483647ll;
+	while (c >= '0' && c <= '9') {
+		magnitude = 10 * magnitude + (c - '0');
+		if (magnitude > limit) {
+			return false;
+		}
+		next++;
+		c = peek();
+	}
+	value = static_cast<std::int32_t>(negative ? -magnitude : magnitude);
+	return true;
+}
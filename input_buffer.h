@@ -0,0 +1,40 @@
+#pragma once
+#ifndef INPUT_BUFFER_H_
+#define INPUT_BUFFER_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <cstdint>  // integers read
+#include <streambuf>  // input through a stream (std::cin)
+#include <string_view>  // input text (in memory)
+#include <vector>  // buffer
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Input_buffer {  // standard input, read in large blocks (for get())
+	private:
+		int fd = -1;  // standard input (-1 -> the text is all in memory)
+		std::streambuf* stream = nullptr;  // (read instead of fd, if given)
+		std::vector<char> buffer;
+		const char* next = nullptr;  // next character to read
+		const char* end = nullptr;  // end of the characters read so far
+
+		bool fill();  // false at the end of the input
+		int peek();
+
+	public:
+		// reads fd 0 directly (stream: through a stream's buffer instead,
+		// for input that it may already have read ahead, like std::cin's)
+		explicit Input_buffer(std::streambuf* input_stream = nullptr,
+							  std::size_t capacity = 64 << 10);  // 64 KiB
+		explicit Input_buffer(std::string_view input_text);  // in memory
+		Input_buffer(const Input_buffer&) = delete;
+		Input_buffer& operator=(const Input_buffer&) = delete;
+
+		// the next integer (after any whitespace). false at the end of the
+		// input, or if the next word isn't an integer that fits in 32 bits
+		bool read_integer(std::int32_t& value);
+		bool buffered() const;  // can read without waiting for the OS
+};
+
+#endif
@@ -0,0 +1,934 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // sort()  fill()  min()  max()
+#include <cstring>  // memcpy()
+#include <iterator>  // begin()  end()
+
+#ifdef __linux__
+#include <sys/mman.h>  // mmap()  mprotect()  munmap()
+#endif
+
+#include "jit_machine.h"
+
+// (the largest program that is compiled: its machine code is ~20x as big)
+const std::size_t JIT_MAX_INSTRUCTIONS = 1 << 22;
+
+// x86-64 condition codes (the low bit negates them)
+const unsigned CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_BE = 0x6, CC_S = 0x8;
+const unsigned CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF;
+const unsigned CC_ALWAYS = 16;
+// (by comparison, in the order of REG_GRT ... REG_LEQ)
+const unsigned COMPARISON_CONDITIONS[6] = {
+	CC_G, CC_L, CC_E, CC_E ^ 1, CC_GE, CC_LE
+};
+
+// get() and put() for the machine code, which calls them with the host ABI.
+// jit_read() returns -1 if there is no integer to read
+static std::int64_t jit_read(Jit_context* context) {
+	if (!context->input->buffered()) {
+		context->output->flush();  // (put() before get() shows up first)
+	}
+	std::int32_t value;
+	if (!context->input->read_integer(value)) {
+		return -1;
+	}
+	return static_cast<std::uint32_t>(value);
+}
+
+static void jit_write(Jit_context* context, std::int32_t value) {
+	*context->output << static_cast<int>(value) << '\n';
+}
+
+Jit_Compiler::Jit_Compiler(const Register_code* register_code,
+						   std::vector<std::uint8_t>* native_code)
+	: code(register_code), machine_code(native_code) {}
+
+std::size_t Jit_Compiler::entry_label(std::uint32_t position) const {
+	return 2 * static_cast<std::size_t>(position);
+}
+
+std::size_t Jit_Compiler::body_label(std::uint32_t position) const {
+	return 2 * static_cast<std::size_t>(position) + 1;
+}
+
+std::size_t Jit_Compiler::exit_label() const {
+	return 2 * (code->instructions.size() + 1);
+}
+
+/******************************************************************************
+| A unit is the main body (from instruction 0) or a function (from the        |
+| target of a CALL): the instructions that are reached from its start without |
+| going into a CALL. Each one is compiled on its own, and calls the others    |
+| with the host's call and ret. The code has to be in such units (generated   |
+| code always is), and a RETURN can't be in the main body, or else it isn't   |
+| compiled.                                                                   |
+******************************************************************************/
+bool Jit_Compiler::find_units() {
+	const std::vector<Register_instruction>& instructions = code->instructions;
+	std::uint32_t count = static_cast<std::uint32_t>(instructions.size());
+	unit_of.assign(count, -1);
+	rank_of.assign(count, 0);
+	units.clear();
+	std::vector<std::int32_t> unit_starting(count, -1);
+	std::vector<std::uint32_t> starts;
+	std::vector<std::uint32_t> pending;
+	if (count > 0) {
+		unit_starting[0] = 0;
+		starts.push_back(0);
+	}
+
+	for (std::size_t unit = 0; unit < starts.size(); unit++) {
+		std::int32_t id = static_cast<std::int32_t>(unit);
+		units.emplace_back();
+		pending.push_back(starts[unit]);
+		while (!pending.empty()) {
+			std::uint32_t position = pending.back();
+			pending.pop_back();
+			if (position > count) {
+				return false;  // (a jump past the end of the program)
+			}
+			if (position == count || unit_of[position] == id) {
+				continue;
+			}
+			if (unit_of[position] != -1
+				|| (unit_starting[position] != -1
+					&& unit_starting[position] != id)) {
+				return false;  // (two units share it)
+			}
+			unit_of[position] = id;
+			units[unit].push_back(position);
+
+			const Register_instruction& instruction = instructions[position];
+			switch (instruction.opcode) {
+				case REG_JUMP:
+					pending.push_back(instruction.target);
+					break;
+				case REG_HALT:
+					break;
+				case REG_RETURN:
+					if (unit == 0) {
+						return false;
+					}
+					break;
+				case REG_CALL: {
+					std::uint32_t target = instruction.target;
+					if (target >= count || target == 0) {
+						return false;
+					}
+					if (unit_starting[target] == -1) {
+						if (unit_of[target] != -1) {
+							return false;
+						}
+						unit_starting[target] =
+							static_cast<std::int32_t>(starts.size());
+						starts.push_back(target);
+					}
+					pending.push_back(position + 1);
+					break;
+				}
+				default:
+					if (instruction.opcode >= REG_JUMPZ
+						&& instruction.opcode <= REG_JUMPZ_LEQ) {
+						pending.push_back(instruction.target);
+					}
+					pending.push_back(position + 1);
+					break;
+			}
+		}
+		std::sort(units[unit].begin(), units[unit].end());
+		for (std::size_t rank = 0; rank < units[unit].size(); rank++) {
+			rank_of[units[unit][rank]] = static_cast<std::uint32_t>(rank);
+		}
+	}
+	return true;
+}
+
+// the registers that instruction writes or reads (but not constants)
+static int used_registers(const Register_instruction& instruction,
+						  std::uint32_t constant_base,
+						  std::uint32_t temporary_base,
+						  std::uint32_t* used) {
+	Register_opcode opcode = instruction.opcode;
+	bool writes_x = opcode <= REG_LEQ || opcode == REG_POP
+		|| opcode == REG_READ;
+	bool reads_y = opcode <= REG_JUMPZ_LEQ || opcode == REG_PUSH
+		|| opcode == REG_WRITE;
+	bool reads_z = (opcode >= REG_ADD && opcode <= REG_LEQ)
+		|| (opcode >= REG_JUMPZ_GRT && opcode <= REG_JUMPZ_LEQ);
+	std::uint32_t candidates[3] = { instruction.x, instruction.y,
+									instruction.z };
+	bool uses[3] = { writes_x, reads_y, reads_z };
+	int count = 0;
+	for (int i = 0; i < 3; i++) {
+		if (uses[i] && (candidates[i] < constant_base
+						|| candidates[i] >= temporary_base)) {
+			used[count++] = candidates[i];
+		}
+	}
+	return count;
+}
+
+/******************************************************************************
+| The interval of a register in a unit starts where it is first used, and     |
+| ends where it is last used, and is then grown to cover every jump that      |
+| goes over any of it. So nothing jumps into or out of it: it is entered at   |
+| its start, where the value is loaded, and a loop is either all in it or all |
+| out of it. A memory slot is also kept until the last CALL or RETURN after   |
+| its start, since the other units read it from memory: it is stored there    |
+| before each one (and loaded again after a CALL). For each rank, the jumps   |
+| that go over it are summed up by the lowest and highest rank they reach,    |
+| which a segment tree gives for a range of ranks.                            |
+******************************************************************************/
+void Jit_Compiler::find_intervals(const std::vector<std::uint32_t>& unit) {
+	const std::vector<Register_instruction>& instructions = code->instructions;
+	std::uint32_t constant_base = code->memory_size;
+	std::uint32_t temporary_base = constant_base
+		+ static_cast<std::uint32_t>(code->constants.size());
+	std::uint32_t size = static_cast<std::uint32_t>(unit.size());
+	std::vector<std::int64_t> farthest(size, -1);  // (by the lower end)
+	std::int64_t last_transfer = -1;  // (the last CALL or RETURN)
+
+	intervals.clear();
+	for (std::uint32_t rank = 0; rank < size; rank++) {
+		const Register_instruction& instruction = instructions[unit[rank]];
+		std::uint32_t used[3];
+		int count = used_registers(instruction, constant_base, temporary_base,
+								   used);
+		for (int i = 0; i < count; i++) {
+			int& index = host_of[used[i]];  // (the interval, for now)
+			if (index == -1) {
+				index = static_cast<int>(intervals.size());
+				intervals.push_back({ used[i], rank, rank });
+			}
+			intervals[index].end = rank;
+		}
+
+		Register_opcode opcode = instruction.opcode;
+		if (opcode == REG_CALL || opcode == REG_RETURN) {
+			last_transfer = rank;
+		}
+		if (opcode >= REG_JUMPZ && opcode <= REG_JUMP
+			&& instruction.target < instructions.size()) {
+			std::uint32_t target = rank_of[instruction.target];
+			std::uint32_t low = std::min(rank, target);
+			farthest[low] = std::max<std::int64_t>(farthest[low],
+												   std::max(rank, target));
+		}
+	}
+
+	// lowest[size + rank], highest[size + rank]: where the jumps over rank
+	// reach (rank itself if there are none). the lowest one only goes up
+	std::vector<std::uint32_t> lowest(2 * size);
+	std::vector<std::uint32_t> highest(2 * size);
+	std::int64_t reach = -1;
+	std::uint32_t low = 0;
+	for (std::uint32_t rank = 0; rank < size; rank++) {
+		reach = std::max(reach, farthest[rank]);
+		if (reach >= rank) {
+			while (farthest[low] < rank) {
+				low++;
+			}
+			lowest[size + rank] = low;
+			highest[size + rank] = static_cast<std::uint32_t>(reach);
+		}
+		else {
+			lowest[size + rank] = rank;
+			highest[size + rank] = rank;
+		}
+	}
+	for (std::uint32_t i = size - 1; i > 0; i--) {
+		lowest[i] = std::min(lowest[2 * i], lowest[2 * i + 1]);
+		highest[i] = std::max(highest[2 * i], highest[2 * i + 1]);
+	}
+
+	for (Interval& interval : intervals) {
+		host_of[interval.reg] = -1;
+		bool grown = true;
+		while (grown) {
+			grown = false;
+			if (interval.reg < constant_base
+				&& last_transfer > static_cast<std::int64_t>(interval.end)) {
+				interval.end = static_cast<std::uint32_t>(last_transfer);
+			}
+			std::uint32_t first = interval.start;
+			std::uint32_t last = interval.end;
+			for (std::uint32_t left = size + first, right = size + last + 1;
+				 left < right; left /= 2, right /= 2) {
+				if (left & 1) {
+					first = std::min(first, lowest[left]);
+					last = std::max(last, highest[left++]);
+				}
+				if (right & 1) {
+					first = std::min(first, lowest[--right]);
+					last = std::max(last, highest[right]);
+				}
+			}
+			if (first < interval.start || last > interval.end) {
+				interval.start = first;
+				interval.end = last;
+				grown = true;
+			}
+		}
+	}
+}
+
+/******************************************************************************
+| Linear scan (Poletto and Sarkar): the intervals are taken by where they     |
+| start, and each one gets a host register that no interval still going on    |
+| has. When there is none, the interval that ends last (this one, or one      |
+| going on) is spilled: it is kept in the register file for all of it. The    |
+| callee-saved registers are handed out first, since the ones a get() or      |
+| put() call can change have to be stored while it runs.                      |
+******************************************************************************/
+void Jit_Compiler::allocate_registers() {
+	static const int HOSTS[] = {
+		R11, R10, R9, R8, RDI, RSI, R13, R12, RBP  // (taken from the back)
+	};
+	std::sort(intervals.begin(), intervals.end(),
+			  [](const Interval& a, const Interval& b) {
+				  return a.start < b.start
+					  || (a.start == b.start && a.reg < b.reg);
+			  });
+	std::vector<int> free_hosts(std::begin(HOSTS), std::end(HOSTS));
+	std::vector<std::size_t> active;
+	for (std::size_t i = 0; i < intervals.size(); i++) {
+		Interval& interval = intervals[i];
+		for (std::size_t j = 0; j < active.size();) {
+			if (intervals[active[j]].end < interval.start) {
+				free_hosts.push_back(intervals[active[j]].host);
+				active[j] = active.back();
+				active.pop_back();
+			}
+			else {
+				j++;
+			}
+		}
+
+		if (!free_hosts.empty()) {
+			interval.host = free_hosts.back();
+			free_hosts.pop_back();
+			active.push_back(i);
+			continue;
+		}
+		std::size_t last = 0;
+		for (std::size_t j = 1; j < active.size(); j++) {
+			if (intervals[active[j]].end > intervals[active[last]].end) {
+				last = j;
+			}
+		}
+		Interval& spilled = intervals[active[last]];
+		if (spilled.end > interval.end) {
+			interval.host = spilled.host;
+			spilled.host = -1;
+			active[last] = i;
+		}
+	}
+	for (const Interval& interval : intervals) {
+		host_of[interval.reg] = interval.host;
+	}
+}
+
+void Jit_Compiler::compile_unit(const std::vector<std::uint32_t>& unit) {
+	const std::vector<Register_instruction>& instructions = code->instructions;
+	std::size_t next = 0;  // (the next interval to start)
+	live.clear();
+	for (std::uint32_t rank = 0; rank < unit.size(); rank++) {
+		std::uint32_t position = unit[rank];
+		for (std::size_t i = 0; i < live.size();) {
+			if (intervals[live[i]].end < rank) {
+				live[i] = live.back();
+				live.pop_back();
+			}
+			else {
+				i++;
+			}
+		}
+
+		labels[entry_label(position)] = machine_code->size();
+		for (; next < intervals.size() && intervals[next].start <= rank;
+			 next++) {
+			const Interval& interval = intervals[next];
+			if (interval.host == -1) {
+				continue;
+			}
+			live.push_back(static_cast<std::uint32_t>(next));
+			if (interval.reg < code->memory_size) {
+				load(interval.host, { Operand::MEMORY, 0,
+					static_cast<std::int32_t>(4 * interval.reg) });
+			}
+		}
+		labels[body_label(position)] = machine_code->size();
+
+		const Register_instruction& instruction = instructions[position];
+		compile_instruction(instruction, rank);
+		Register_opcode opcode = instruction.opcode;
+		bool falls_through = opcode != REG_JUMP && opcode != REG_RETURN
+			&& opcode != REG_HALT;
+		if (falls_through && (rank + 1 == unit.size()
+							  || unit[rank + 1] != position + 1)) {
+			jump(CC_ALWAYS, entry_label(position + 1));
+		}
+	}
+}
+
+// stores the host registers of the intervals that go on at rank (memory_only:
+// only memory slots, caller_saved_only: only the ones a call can change), or
+// loads them again
+void Jit_Compiler::save_live(std::uint32_t rank, bool memory_only,
+							 bool caller_saved_only, bool load_again) {
+	for (std::uint32_t index : live) {
+		const Interval& interval = intervals[index];
+		if (interval.start > rank || interval.end < rank
+			|| (memory_only && interval.reg >= code->memory_size)
+			|| (caller_saved_only && (interval.host == RBP
+									  || interval.host == R12
+									  || interval.host == R13))) {
+			continue;
+		}
+		Operand home = { Operand::MEMORY, 0,
+			static_cast<std::int32_t>(4 * interval.reg) };
+		if (load_again) {
+			load(interval.host, home);
+		}
+		else {
+			store(home, interval.host);
+		}
+	}
+}
+
+// calls function(rbx, esi) with the host stack aligned to 16 bytes (it can be
+// anywhere, as each CALL pushes a return address)
+void Jit_Compiler::call_helper(std::uintptr_t function) {
+	host_operation(0x89, true, RBX, RDI);  // mov rdi, rbx
+	host_operation(0x89, true, RSP, RAX);  // mov rax, rsp
+	host_operation(0x83, true, 4, RSP);  // and rsp, -16
+	byte(0xF0);
+	byte(0x50);  // push rax (twice, to stay aligned)
+	byte(0x50);
+	byte(0x48);  // mov rax, function
+	byte(0xB8);
+	for (int i = 0; i < 8; i++) {
+		byte(static_cast<std::uint8_t>(function >> (8 * i)));
+	}
+	host_operation(0xFF, false, 2, RAX);  // call rax
+	byte(0x59);  // pop rcx
+	byte(0x5C);  // pop rsp
+}
+
+void Jit_Compiler::compile_instruction(const Register_instruction& instruction,
+									   std::uint32_t rank) {
+	Register_opcode opcode = instruction.opcode;
+	Operand x = operand(instruction.x);
+	Operand y = operand(instruction.y);
+	Operand z = operand(instruction.z);
+	std::uint32_t source = instruction.source;
+	switch (opcode) {
+		case REG_MOVE:
+			if (x.kind == Operand::HOST) {
+				load(x.host, y);
+			}
+			else if (y.kind == Operand::HOST) {
+				store(x, y.host);
+			}
+			else if (y.kind == Operand::IMMEDIATE) {
+				memory_operation(0xC7, false, 0, R15, x.value);  // mov [x], y
+				dword(static_cast<std::uint32_t>(y.value));
+			}
+			else {
+				load(RAX, y);
+				store(x, RAX);
+			}
+			break;
+
+		case REG_ADD:
+		case REG_SUB:
+		case REG_MUL:
+			if (x.kind == Operand::HOST
+				&& !(z.kind == Operand::HOST && z.host == x.host)) {
+				load(x.host, y);
+				arithmetic(opcode, x.host, z);
+			}
+			else if (x.kind == Operand::HOST && opcode != REG_SUB) {
+				arithmetic(opcode, x.host, y);  // (x = z, and it commutes)
+			}
+			else if (x.kind == Operand::MEMORY && instruction.x == instruction.y
+					 && opcode != REG_MUL && z.kind != Operand::MEMORY) {
+				if (z.kind == Operand::HOST) {  // add/sub [x], z
+					memory_operation((opcode == REG_ADD) ? 0x01 : 0x29, false,
+									 z.host, R15, x.value);
+				}
+				else {
+					memory_operation(0x81, false, (opcode == REG_ADD) ? 0 : 5,
+									 R15, x.value);
+					dword(static_cast<std::uint32_t>(z.value));
+				}
+			}
+			else {
+				load(RAX, y);
+				arithmetic(opcode, RAX, z);
+				store(x, RAX);
+			}
+			break;
+
+		case REG_DIV:
+			load(RAX, y);
+			if (z.kind == Operand::IMMEDIATE && z.value == 0) {
+				error_exit(CC_ALWAYS, RUN_DIVIDE_BY_ZERO, source);
+				break;
+			}
+			if (z.kind == Operand::IMMEDIATE && z.value == -1) {
+				host_operation(0xF7, false, 3, RAX);  // neg eax
+			}
+			else if (z.kind == Operand::IMMEDIATE) {
+				load(RCX, z);
+				byte(0x99);  // cdq
+				host_operation(0xF7, false, 7, RCX);  // idiv ecx
+			}
+			else {
+				load(RCX, z);
+				host_operation(0x85, false, RCX, RCX);  // test ecx, ecx
+				error_exit(CC_E, RUN_DIVIDE_BY_ZERO, source);
+				host_operation(0x83, false, 7, RCX);  // cmp ecx, -1
+				byte(0xFF);
+				byte(0x75);  // jne (the division)
+				byte(4);
+				host_operation(0xF7, false, 3, RAX);  // neg eax
+				byte(0xEB);  // jmp (past it)
+				byte(3);
+				byte(0x99);  // cdq
+				host_operation(0xF7, false, 7, RCX);  // idiv ecx
+			}
+			store(x, RAX);
+			break;
+
+		case REG_GRT:
+		case REG_LES:
+		case REG_EQU:
+		case REG_NEQ:
+		case REG_GEQ:
+		case REG_LEQ:
+			compare(y, z);
+			byte(0x0F);  // setcc al
+			byte(static_cast<std::uint8_t>(
+				0x90 | COMPARISON_CONDITIONS[opcode - REG_GRT]));
+			byte(0xC0);
+			byte(0x0F);  // movzx eax, al
+			byte(0xB6);
+			byte(0xC0);
+			store(x, RAX);
+			break;
+
+		case REG_JUMPZ:
+			compare(y, { Operand::IMMEDIATE, 0, 0 });
+			jump(CC_E, body_label(instruction.target));
+			break;
+
+		case REG_JUMPZ_GRT:
+		case REG_JUMPZ_LES:
+		case REG_JUMPZ_EQU:
+		case REG_JUMPZ_NEQ:
+		case REG_JUMPZ_GEQ:
+		case REG_JUMPZ_LEQ:
+			compare(y, z);
+			jump(COMPARISON_CONDITIONS[opcode - REG_JUMPZ_GRT] ^ 1,
+				 body_label(instruction.target));
+			break;
+
+		case REG_JUMP:
+			jump(CC_ALWAYS, body_label(instruction.target));
+			break;
+
+		case REG_PUSH:
+			memory_operation(0x3B, true, R14, RBX,  // cmp r14, stack_end
+							 offsetof(Jit_context, stack_end));
+			error_exit(CC_AE, RUN_STACK_OVERFLOW, source);
+			if (y.kind == Operand::IMMEDIATE) {
+				memory_operation(0xC7, false, 0, R14, 0);  // mov [r14], y
+				dword(static_cast<std::uint32_t>(y.value));
+			}
+			else {
+				unsigned host = (y.kind == Operand::HOST) ? y.host : RAX;
+				load(host, y);
+				memory_operation(0x89, false, host, R14, 0);  // mov [r14], y
+			}
+			host_operation(0x83, true, 0, R14);  // add r14, 4
+			byte(4);
+			break;
+
+		case REG_POP:
+			memory_operation(0x3B, true, R14, RBX,  // cmp r14, stack_begin
+							 offsetof(Jit_context, stack_begin));
+			error_exit(CC_BE, RUN_STACK_UNDERFLOW, source);
+			host_operation(0x83, true, 5, R14);  // sub r14, 4
+			byte(4);
+			if (x.kind == Operand::HOST) {
+				memory_operation(0x8B, false, x.host, R14, 0);  // mov x, [r14]
+			}
+			else {
+				memory_operation(0x8B, false, RAX, R14, 0);
+				store(x, RAX);
+			}
+			break;
+
+		case REG_READ:
+			save_live(rank, false, true, false);
+			call_helper(reinterpret_cast<std::uintptr_t>(&jit_read));
+			host_operation(0x85, true, RAX, RAX);  // test rax, rax
+			error_exit(CC_S, RUN_BAD_INPUT, source);
+			save_live(rank, false, true, true);
+			store(x, RAX);
+			break;
+
+		case REG_WRITE:
+			save_live(rank, false, true, false);
+			load(RSI, y);
+			call_helper(reinterpret_cast<std::uintptr_t>(&jit_write));
+			save_live(rank, false, true, true);
+			break;
+
+		case REG_CALL:
+			save_live(rank, true, false, false);
+			memory_operation(0x81, true, 5, RBX,  // sub calls_left, 1
+							 offsetof(Jit_context, calls_left));
+			dword(1);
+			error_exit(CC_B, RUN_CALL_OVERFLOW, source);
+			byte(0xE8);  // call
+			fixups.push_back({ machine_code->size(),
+							   entry_label(instruction.target) });
+			dword(0);
+			memory_operation(0x81, true, 0, RBX,  // add calls_left, 1
+							 offsetof(Jit_context, calls_left));
+			dword(1);
+			save_live(rank, true, false, true);
+			break;
+
+		case REG_RETURN:
+			save_live(rank, true, false, false);
+			byte(0xC3);  // ret
+			break;
+
+		default:  // REG_HALT
+			jump(CC_ALWAYS, exit_label());
+			break;
+	}
+}
+
+// (entered as void (*)(Jit_context*))
+void Jit_Compiler::prologue() {
+	static const std::uint8_t SAVE[] = {
+		0x53, 0x55, 0x41, 0x54, 0x41, 0x55,  // push rbx, rbp, r12, r13,
+		0x41, 0x56, 0x41, 0x57,  // r14, r15
+		0x48, 0x83, 0xEC, 0x08  // sub rsp, 8 (aligned to 16 bytes)
+	};
+	for (std::uint8_t value : SAVE) {
+		byte(value);
+	}
+	host_operation(0x89, true, RDI, RBX);  // mov rbx, rdi
+	memory_operation(0x89, true, RSP, RBX,
+					 offsetof(Jit_context, saved_stack_pointer));
+	memory_operation(0x8B, true, R15, RBX, offsetof(Jit_context, registers));
+	memory_operation(0x8B, true, R14, RBX,
+					 offsetof(Jit_context, stack_begin));
+	jump(CC_ALWAYS, entry_label(0));
+}
+
+// (the stack pointer is restored first: the program can end inside calls)
+void Jit_Compiler::epilogue() {
+	static const std::uint8_t RESTORE[] = {
+		0x48, 0x83, 0xC4, 0x08,  // add rsp, 8
+		0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D,  // pop r15, r14, r13,
+		0x41, 0x5C, 0x5D, 0x5B, 0xC3  // r12, rbp, rbx, and ret
+	};
+	memory_operation(0x8B, true, RSP, RBX,
+					 offsetof(Jit_context, saved_stack_pointer));
+	for (std::uint8_t value : RESTORE) {
+		byte(value);
+	}
+}
+
+Jit_Compiler::Operand Jit_Compiler::operand(std::uint32_t reg) const {
+	std::uint32_t constant_base = code->memory_size;
+	if (reg >= constant_base && reg - constant_base < code->constants.size()) {
+		return { Operand::IMMEDIATE, 0, code->constants[reg - constant_base] };
+	}
+	if (reg < host_of.size() && host_of[reg] != -1) {
+		return { Operand::HOST, host_of[reg], 0 };
+	}
+	return { Operand::MEMORY, 0, static_cast<std::int32_t>(4 * reg) };
+}
+
+void Jit_Compiler::byte(std::uint8_t value) {
+	machine_code->push_back(value);
+}
+
+void Jit_Compiler::dword(std::uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		byte(static_cast<std::uint8_t>(value >> (8 * i)));
+	}
+}
+
+// (only written if it is needed: wide operands, or registers r8 ... r15)
+void Jit_Compiler::rex(bool wide, unsigned reg, unsigned rm) {
+	unsigned prefix = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0)
+		| ((rm & 8) ? 1 : 0);
+	if (prefix != 0x40) {
+		byte(static_cast<std::uint8_t>(prefix));
+	}
+}
+
+// opcode reg, rm (reg is an opcode extension for some). opcodes above 0xFF
+// are two bytes (0x0F ...)
+void Jit_Compiler::host_operation(unsigned opcode, bool wide, unsigned reg,
+								  unsigned rm) {
+	rex(wide, reg, rm);
+	if (opcode > 0xFF) {
+		byte(static_cast<std::uint8_t>(opcode >> 8));
+	}
+	byte(static_cast<std::uint8_t>(opcode));
+	byte(static_cast<std::uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// opcode reg, [base + offset]
+void Jit_Compiler::memory_operation(unsigned opcode, bool wide, unsigned reg,
+									unsigned base, std::int32_t offset) {
+	rex(wide, reg, base);
+	if (opcode > 0xFF) {
+		byte(static_cast<std::uint8_t>(opcode >> 8));
+	}
+	byte(static_cast<std::uint8_t>(opcode));
+	byte(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7)));
+	if ((base & 7) == RSP) {
+		byte(0x24);  // (SIB: no index)
+	}
+	dword(static_cast<std::uint32_t>(offset));
+}
+
+void Jit_Compiler::load(unsigned host, const Operand& source) {
+	if (source.kind == Operand::HOST) {
+		if (static_cast<unsigned>(source.host) != host) {
+			host_operation(0x8B, false, host, source.host);
+		}
+	}
+	else if (source.kind == Operand::MEMORY) {
+		memory_operation(0x8B, false, host, R15, source.value);
+	}
+	else {
+		rex(false, 0, host);  // mov host, imm32
+		byte(static_cast<std::uint8_t>(0xB8 | (host & 7)));
+		dword(static_cast<std::uint32_t>(source.value));
+	}
+}
+
+void Jit_Compiler::store(const Operand& destination, unsigned host) {
+	if (destination.kind == Operand::HOST) {
+		if (static_cast<unsigned>(destination.host) != host) {
+			host_operation(0x89, false, host, destination.host);
+		}
+	}
+	else {
+		memory_operation(0x89, false, host, R15, destination.value);
+	}
+}
+
+// host = host + source (or -, *)
+void Jit_Compiler::arithmetic(Register_opcode opcode, unsigned host,
+							  const Operand& source) {
+	unsigned operation = (opcode == REG_ADD) ? 0x03
+		: (opcode == REG_SUB) ? 0x2B : 0x0FAF;
+	if (source.kind == Operand::HOST) {
+		host_operation(operation, false, host, source.host);
+	}
+	else if (source.kind == Operand::MEMORY) {
+		memory_operation(operation, false, host, R15, source.value);
+	}
+	else {
+		if (opcode == REG_MUL) {
+			host_operation(0x69, false, host, host);  // imul host, host, imm
+		}
+		else {
+			host_operation(0x81, false, (opcode == REG_ADD) ? 0 : 5, host);
+		}
+		dword(static_cast<std::uint32_t>(source.value));
+	}
+}
+
+// sets the flags to left - right
+void Jit_Compiler::compare(const Operand& left, const Operand& right) {
+	if (left.kind == Operand::HOST) {
+		if (right.kind == Operand::HOST) {
+			host_operation(0x3B, false, left.host, right.host);
+		}
+		else if (right.kind == Operand::MEMORY) {
+			memory_operation(0x3B, false, left.host, R15, right.value);
+		}
+		else {
+			host_operation(0x81, false, 7, left.host);
+			dword(static_cast<std::uint32_t>(right.value));
+		}
+	}
+	else if (left.kind == Operand::MEMORY && right.kind == Operand::HOST) {
+		memory_operation(0x39, false, right.host, R15, left.value);
+	}
+	else if (left.kind == Operand::MEMORY
+			 && right.kind == Operand::IMMEDIATE) {
+		memory_operation(0x81, false, 7, R15, left.value);
+		dword(static_cast<std::uint32_t>(right.value));
+	}
+	else {
+		load(RAX, left);
+		compare({ Operand::HOST, RAX, 0 }, right);
+	}
+}
+
+void Jit_Compiler::jump(unsigned condition, std::size_t label) {
+	if (condition == CC_ALWAYS) {
+		byte(0xE9);
+	}
+	else {
+		byte(0x0F);
+		byte(static_cast<std::uint8_t>(0x80 | condition));
+	}
+	fixups.push_back({ machine_code->size(), label });
+	dword(0);
+}
+
+void Jit_Compiler::error_exit(unsigned condition, Run_status status,
+							  std::uint32_t instruction) {
+	if (condition == CC_ALWAYS) {
+		byte(0xE9);
+	}
+	else {
+		byte(0x0F);
+		byte(static_cast<std::uint8_t>(0x80 | condition));
+	}
+	error_exits.push_back({ machine_code->size(), status, instruction });
+	dword(0);
+}
+
+/******************************************************************************
+| The machine code keeps the Jit_context in rbx, the register file in r15,    |
+| and the top of the operand stack in r14, and uses rax, rcx and rdx for what |
+| it computes. The other host registers hold the program's registers (see     |
+| allocate_registers()). A CALL is the host's call, so the host stack holds   |
+| the return addresses, and the number of calls is checked against            |
+| calls_left. An error jumps to a stub of its own, which sets the status and  |
+| the instruction, and then to the epilogue, like HALT. Every label is only   |
+| known once all of the code is there, so the jumps to them are patched last. |
+******************************************************************************/
+bool Jit_Compiler::Compile() {
+	std::size_t count = code->instructions.size();
+	if (count > JIT_MAX_INSTRUCTIONS || !find_units()) {
+		return false;
+	}
+	machine_code->clear();
+	machine_code->reserve(24 * count + 64);
+	labels.assign(exit_label() + 1, 0);
+	fixups.clear();
+	error_exits.clear();
+	host_of.assign(code->register_count(), -1);
+
+	prologue();
+	for (const std::vector<std::uint32_t>& unit : units) {
+		find_intervals(unit);
+		allocate_registers();
+		compile_unit(unit);
+		for (const Interval& interval : intervals) {
+			host_of[interval.reg] = -1;
+		}
+	}
+	std::uint32_t end = static_cast<std::uint32_t>(count);
+	labels[entry_label(end)] = machine_code->size();
+	labels[body_label(end)] = machine_code->size();
+	labels[exit_label()] = machine_code->size();
+	epilogue();
+
+	for (const Error_exit& exit : error_exits) {  // (one for each)
+		std::size_t here = machine_code->size();
+		std::int32_t offset = static_cast<std::int32_t>(here - (exit.at + 4));
+		std::memcpy(machine_code->data() + exit.at, &offset, 4);
+		memory_operation(0xC7, false, 0, RBX, offsetof(Jit_context, status));
+		dword(exit.status);
+		memory_operation(0xC7, false, 0, RBX,
+						 offsetof(Jit_context, instruction));
+		dword(exit.instruction);
+		jump(CC_ALWAYS, exit_label());
+	}
+	for (const Fixup& fixup : fixups) {
+		std::int32_t offset = static_cast<std::int32_t>(
+			labels[fixup.label] - (fixup.at + 4));
+		std::memcpy(machine_code->data() + fixup.at, &offset, 4);
+	}
+	return true;
+}
+
+Jit_Machine::Jit_Machine(const Register_code* register_code,
+						 std::size_t stack_values, std::size_t max_calls)
+	: code(register_code),
+	  interpreter(register_code, stack_values, max_calls),
+	  registers(register_code->register_count()), stack_size(stack_values),
+	  call_depth(max_calls), stack(new std::int32_t[stack_values]) {}
+
+Jit_Machine::~Jit_Machine() {
+#ifdef JIT_SUPPORTED
+	if (native_code) {
+		munmap(native_code, native_size);
+	}
+#endif
+}
+
+// maps the machine code, and then makes it executable instead of writable
+bool Jit_Machine::compile() {
+#ifdef JIT_SUPPORTED
+	std::vector<std::uint8_t> machine_code;
+	if (!Jit_Compiler(code, &machine_code).Compile()) {
+		return false;
+	}
+	void* memory = mmap(nullptr, machine_code.size(), PROT_READ | PROT_WRITE,
+						MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return false;
+	}
+	std::memcpy(memory, machine_code.data(), machine_code.size());
+	if (mprotect(memory, machine_code.size(), PROT_READ | PROT_EXEC) != 0) {
+		munmap(memory, machine_code.size());
+		return false;
+	}
+	native_code = memory;
+	native_size = machine_code.size();
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Jit_Machine::is_native() const {
+	return native_code != nullptr;
+}
+
+Run_result Jit_Machine::Run(Input_buffer* input, Output_buffer* output) {
+	if (!compiled) {
+		compiled = true;
+		compile();
+	}
+	if (!native_code) {
+		return interpreter.Run(input, output);
+	}
+	std::fill(registers.begin(), registers.begin() + code->memory_size, 0);
+
+	Jit_context context;
+	context.registers = registers.data();
+	context.stack_begin = stack.get();
+	context.stack_end = stack.get() + stack_size;
+	context.calls_left = call_depth;
+	context.saved_stack_pointer = nullptr;
+	context.input = input;
+	context.output = output;
+	context.status = RUN_FINISHED;
+	context.instruction = 0;
+	reinterpret_cast<void (*)(Jit_context*)>(native_code)(&context);
+
+	Run_result result;
+	result.status = static_cast<Run_status>(context.status);
+	result.instruction = context.instruction;
+	output->flush();
+	return result;
+}
@@ -0,0 +1,155 @@
+#pragma once
+#ifndef JIT_MACHINE_H_
+#define JIT_MACHINE_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <cstdint>  // registers, machine code
+#include <memory>  // fixed-size operand stack
+#include <vector>  // machine code, intervals, labels
+
+#include "input_buffer.h"  // get()
+#include "output_buffer.h"  // put()
+#include "register_machine.h"  // Register_code, Register_Machine
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_SUPPORTED 1  // (native code is only run on x86-64 Linux)
+#endif
+
+/******************************************************************************
+| The JIT translates Register_code into x86-64 machine code, and runs it from |
+| memory that is mapped executable (see jit_machine.cpp). The main body and   |
+| each function are compiled on their own, with the registers of the program  |
+| (its memory slots and temporaries) given host registers by a linear scan. A |
+| program that it can't compile, or any program on another platform, is run   |
+| by the register machine instead.                                            |
+******************************************************************************/
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+struct Jit_context {  // what the machine code reads and writes, besides memory
+	std::int32_t* registers;  // the register file (memory slots first)
+	std::int32_t* stack_begin;  // the operand stack
+	std::int32_t* stack_end;
+	std::uint64_t calls_left;  // nested calls that are still allowed
+	void* saved_stack_pointer;  // the host stack when the program started
+	Input_buffer* input;
+	Output_buffer* output;
+	std::uint32_t status;  // Run_status
+	std::uint32_t instruction;  // the stack instruction that failed
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Jit_Compiler {  // translates Register_code into x86-64 machine code
+	private:
+		enum Host_register : std::uint8_t {
+			RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+			R8, R9, R10, R11, R12, R13, R14, R15
+		};
+
+		struct Interval {  // where a register's value is kept in a unit
+			std::uint32_t reg;
+			std::uint32_t start;  // ranks (positions in the unit)
+			std::uint32_t end;
+			int host = -1;  // Host_register (-1 -> in the register file)
+		};
+
+		struct Operand {  // where an instruction finds a register's value
+			enum Kind : std::uint8_t { HOST, MEMORY, IMMEDIATE } kind;
+			int host;  // HOST
+			std::int32_t value;  // MEMORY: its offset, IMMEDIATE: the value
+		};
+
+		struct Fixup {  // a rel32 that jumps to a label
+			std::size_t at;
+			std::size_t label;
+		};
+
+		struct Error_exit {  // a jump to where a run ends with an error
+			std::size_t at;
+			Run_status status;
+			std::uint32_t instruction;
+		};
+
+		const Register_code* code;
+		std::vector<std::uint8_t>* machine_code;
+		std::vector<std::int32_t> unit_of;  // (by instruction, -1 -> never run)
+		std::vector<std::vector<std::uint32_t>> units;  // their instructions
+		std::vector<std::uint32_t> rank_of;  // position in its unit
+		std::vector<Interval> intervals;  // of the unit being compiled
+		std::vector<int> host_of;  // (by register) in the unit being compiled
+		std::vector<std::uint32_t> live;  // intervals in a host register
+		std::vector<std::size_t> labels;  // offsets of the labels
+		std::vector<Fixup> fixups;
+		std::vector<Error_exit> error_exits;
+
+		// the labels of an instruction: before the registers that start
+		// there are loaded (calls, fallthrough), and after them (jumps)
+		std::size_t entry_label(std::uint32_t position) const;
+		std::size_t body_label(std::uint32_t position) const;
+		std::size_t exit_label() const;
+
+		bool find_units();
+		void find_intervals(const std::vector<std::uint32_t>& unit);
+		void allocate_registers();
+		void compile_unit(const std::vector<std::uint32_t>& unit);
+		void compile_instruction(const Register_instruction& instruction,
+								 std::uint32_t rank);
+		void save_live(std::uint32_t rank, bool memory_only,
+					   bool caller_saved_only, bool load);
+		void call_helper(std::uintptr_t function);
+		void prologue();
+		void epilogue();
+
+		Operand operand(std::uint32_t reg) const;
+		void byte(std::uint8_t value);
+		void dword(std::uint32_t value);
+		void rex(bool wide, unsigned reg, unsigned rm);
+		void host_operation(unsigned opcode, bool wide, unsigned reg,
+							unsigned rm);
+		void memory_operation(unsigned opcode, bool wide, unsigned reg,
+							  unsigned base, std::int32_t offset);
+		void load(unsigned host, const Operand& source);
+		void store(const Operand& destination, unsigned host);
+		void arithmetic(Register_opcode opcode, unsigned host,
+						const Operand& source);
+		void compare(const Operand& left, const Operand& right);
+		void jump(unsigned condition, std::size_t label);  // (16 -> always)
+		void error_exit(unsigned condition, Run_status status,
+						std::uint32_t instruction);
+
+	public:
+		Jit_Compiler(const Register_code* register_code,
+					 std::vector<std::uint8_t>* native_code);
+		bool Compile();  // false -> it has to run on the register machine
+};
+
+class Jit_Machine {  // runs Register_code natively (see jit_machine.cpp)
+	private:
+		const Register_code* code;
+		Register_Machine interpreter;  // (for what the JIT can't compile)
+		std::vector<std::int32_t> registers;
+		std::size_t stack_size;
+		std::size_t call_depth;
+		std::unique_ptr<std::int32_t[]> stack;
+		void* native_code = nullptr;  // (made by the 1st Run(), if it can be)
+		std::size_t native_size = 0;
+		bool compiled = false;  // (it was tried)
+
+		bool compile();
+
+	public:
+		explicit Jit_Machine(const Register_code* register_code,
+							 std::size_t stack_values = DEFAULT_STACK_SIZE,
+							 std::size_t max_calls = DEFAULT_CALL_DEPTH);
+		~Jit_Machine();  // unmaps the machine code
+		Jit_Machine(const Jit_Machine&) = delete;
+		Jit_Machine& operator=(const Jit_Machine&) = delete;
+
+		// runs the program from the start, with every memory slot set to 0.
+		// Run_result::executed is 0 if it ran as machine code
+		Run_result Run(Input_buffer* input, Output_buffer* output);
+		bool is_native() const;  // (after Run()) it ran as machine code
+};
+
+#endif
@@ -1,375 +1,804 @@
 /* ------------------------------- LIBRARIES ------------------------------- */
-#include <cstring>  // tolower()
-#include <ctype.h>  // isalpha()  isdigit()
+#include <algorithm>  // min()  max()
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t
 #include <fstream>  // input file
-#include <map>  // symbol table (SYM)
-#include <string>  // substring
-#include <utility>  // token_type and lexeme_value pairs (ie. tokens)
+#include <iterator>  // istreambuf_iterator
+#include <string>
+#include <thread>  // parallel lexing
 
 #include "lexer.h"
-
-/************************************************************************
-| The constructor initializes the SYM table, which will make lookups of |
-| existing operators, separators, and keywords possible. It also        |
-| initializes the input file reader.                                    |
-************************************************************************/
-Lexer::Lexer(std::ifstream* input_file_stream) {
-	initialize_sym_table(SYM);
-	ifs = input_file_stream;
-}
+#include "token_ring.h"  // pipelined lexing
+
+/* ---------------------- KEYWORD AND CHARACTER TABLES ---------------------- */
+// the keywords of the RAT23S programming language (all lowercase)
+struct Keyword {
+	const char* text;
+	std::size_t length;
+	Symbol_id symbol;
+};
+
+static constexpr Keyword KEYWORDS[] = {
+	{ "function", 8, KEYWORD_FUNCTION },
+	{ "int", 3, KEYWORD_INT },
+	{ "bool", 4, KEYWORD_BOOL },
+	{ "real", 4, KEYWORD_REAL },
+	{ "if", 2, KEYWORD_IF },
+	{ "fi", 2, KEYWORD_FI },
+	{ "else", 4, KEYWORD_ELSE },
+	{ "return", 6, KEYWORD_RETURN },
+	{ "put", 3, KEYWORD_PUT },
+	{ "get", 3, KEYWORD_GET },
+	{ "while", 5, KEYWORD_WHILE },
+	{ "endwhile", 8, KEYWORD_ENDWHILE },
+	{ "true", 4, KEYWORD_TRUE },
+	{ "false", 5, KEYWORD_FALSE }
+};
+static constexpr int KEYWORD_COUNT = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
 
 /*****************************************************************************
-| The lexer function extracts tokens from the input file ifs. First, it      |
-| skips over any white spaces (spacebar, tab, newline). Then, it may call    |
-| helper functions to see if the current token is valid. If it is, it will   |
-| return the token type and the lexeme value. If not, it will return the     |
-| "ERROR" token type.                                                        |
+| keyword_hash maps a lexeme to one of 32 slots using its length and its     |
+| first and last characters. The characters are folded to lowercase with     |
+| | 0x20 (lexemes reaching this point only hold letters, digits, and _, and  |
+| folding never turns a digit or _ into a letter), so 'While' and 'while'    |
+| land in the same slot. The constants were chosen so that no two keywords   |
+| share a slot, which build_keyword_slots() checks at compile time.          |
 *****************************************************************************/
-Token Lexer::get_token() {
-	// check if EOF reached
-	if (!ifs->good()) {
-		return { "EOF", "" };
-	}
+static constexpr std::size_t KEYWORD_SLOTS = 32;
+
+static constexpr std::size_t keyword_hash(std::size_t length,
+										  unsigned char first,
+										  unsigned char last) {
+	return (length + (first | 0x20u) + 24u * (last | 0x20u)) % KEYWORD_SLOTS;
+}
 
-	// overpass whitespaces
-	char buf = ifs->get();
-	if (!ifs->good()) {
-		return { "EOF", "" };  // EOF reached (kinda repetitive, but needed)
+struct Keyword_slots {
+	std::int8_t keyword[KEYWORD_SLOTS];  // index into KEYWORDS, or -1
+	bool perfect;  // true if no two keywords hash to the same slot
+};
+
+static constexpr Keyword_slots build_keyword_slots() {
+	Keyword_slots slots = {};
+	slots.perfect = true;
+	for (std::size_t i = 0; i < KEYWORD_SLOTS; i++) {
+		slots.keyword[i] = -1;
 	}
-	while (is_white_space(buf)) {
-		if (buf == '\n') {  // keep track of where next token appears
-			line_number++;
-		}
-		buf = ifs->get();
-		if (!ifs->good()) {
-			return { "EOF", "" };  // EOF reached
+	for (int i = 0; i < KEYWORD_COUNT; i++) {
+		const Keyword& k = KEYWORDS[i];
+		std::size_t slot = keyword_hash(k.length, k.text[0],
+										k.text[k.length - 1]);
+		if (slots.keyword[slot] != -1) {
+			slots.perfect = false;
 		}
+		slots.keyword[slot] = static_cast<std::int8_t>(i);
 	}
+	return slots;
+}
 
+static constexpr Keyword_slots KEYWORD_TABLE = build_keyword_slots();
+static_assert(KEYWORD_TABLE.perfect, "keyword_hash() must not collide");
 
-	// first character is a letter -> check if token is ID or keyword
-	if (isalpha(buf)) {
-		return DFSM_identifier();  // use DFSM_id
+/*****************************************************************************
+| Every byte of the input belongs to one of these equivalence classes. The   |
+| scanner never looks at a byte again after mapping it to its class, so the  |
+| classes must separate every pair of bytes that the DFSM treats differently.|
+| CLASS_EOF isn't a byte: it is fed to the DFSM once the input runs out.     |
+*****************************************************************************/
+enum Char_class : std::uint8_t {
+	CLASS_LETTER,
+	CLASS_DIGIT,
+	CLASS_UNDERSCORE,  // _
+	CLASS_DOT,  // .
+	CLASS_SPACE,  // space, tab, vertical tab, carriage return
+	CLASS_NEWLINE,  // \n (counted for line numbers)
+	CLASS_EQUALS,  // =
+	CLASS_LESS,  // <
+	CLASS_GREATER,  // >
+	CLASS_BANG,  // !
+	CLASS_STAR,  // *
+	CLASS_LEFT_BRACKET,  // [
+	CLASS_RIGHT_BRACKET,  // ]
+	CLASS_SYMBOL,  // the other one-character operators/separators
+	CLASS_OTHER,  // anything else (always an error outside of comments)
+	CLASS_EOF,
+	CLASS_COUNT
+};
+
+struct Char_table {
+	Char_class char_class[256];
+	Symbol_id symbol[256];  // symbol of the one-character operators/separators
+};
+
+static constexpr Char_table build_char_table() {
+	Char_table table = {};
+	for (int c = 0; c < 256; c++) {
+		table.char_class[c] = CLASS_OTHER;
+		table.symbol[c] = SYMBOL_NONE;
 	}
-
-	// first character is a number -> check if token is int or real
-	else if (isdigit(buf)) {
-		return DFSM_int_real();  // use DFSM_int_real
+	for (int c = 'a'; c <= 'z'; c++) {
+		table.char_class[c] = CLASS_LETTER;
+		table.char_class[c - 'a' + 'A'] = CLASS_LETTER;
 	}
-
-	// if first char is =, token could either be =, ==, or =>
-	// use check_operator_equals() to determine which one it is
-	else if (buf == '=') {
-		return check_operator_equals();
+	for (int c = '0'; c <= '9'; c++) {
+		table.char_class[c] = CLASS_DIGIT;
 	}
-
-	// same case as =, but for < and <=
-	else if (buf == '<') {
-		return check_operator_less_than();
+	table.char_class['_'] = CLASS_UNDERSCORE;
+	table.char_class['.'] = CLASS_DOT;
+	table.char_class[' '] = CLASS_SPACE;
+	table.char_class['\t'] = CLASS_SPACE;
+	table.char_class['\v'] = CLASS_SPACE;
+	table.char_class['\r'] = CLASS_SPACE;  // CRLF files aren't translated
+	table.char_class['\n'] = CLASS_NEWLINE;
+	table.char_class['!'] = CLASS_BANG;
+	table.char_class['['] = CLASS_LEFT_BRACKET;
+	table.char_class[']'] = CLASS_RIGHT_BRACKET;
+
+	const char one_char_symbols[] = "=+-*/><(){};#,";
+	const Symbol_id ids[] = {
+		OPERATOR_ASSIGN, OPERATOR_PLUS, OPERATOR_MINUS, OPERATOR_MULTIPLY,
+		OPERATOR_DIVIDE, OPERATOR_GREATER, OPERATOR_LESS, SEPARATOR_LEFT_PAREN,
+		SEPARATOR_RIGHT_PAREN, SEPARATOR_LEFT_BRACE, SEPARATOR_RIGHT_BRACE,
+		SEPARATOR_SEMICOLON, SEPARATOR_HASH, SEPARATOR_COMMA
+	};
+	for (int i = 0; one_char_symbols[i] != '\0'; i++) {
+		unsigned char c = static_cast<unsigned char>(one_char_symbols[i]);
+		table.char_class[c] = CLASS_SYMBOL;
+		table.symbol[c] = ids[i];
 	}
+	table.char_class['='] = CLASS_EQUALS;  // could be =, ==, or =>
+	table.char_class['<'] = CLASS_LESS;  // could be < or <=
+	table.char_class['>'] = CLASS_GREATER;  // ends =>
+	table.char_class['*'] = CLASS_STAR;  // opens/closes comments
+	return table;
+}
+
+static constexpr Char_table CHAR_TABLE = build_char_table();
 
-	// the only time ! can be used is for !=. otherwise, return ERROR msg
-	else if (buf == '!') {
-		buf = ifs->get();
-		if (buf == '=') {
-			return { "operator", "!=" };
+static inline bool is_white_space(char c) {
+	Char_class c_class = CHAR_TABLE.char_class[static_cast<unsigned char>(c)];
+	return c_class == CLASS_SPACE || c_class == CLASS_NEWLINE;
+}
+
+/*****************************************************************************
+| The states of the lexer's DFSM. One DFSM covers every kind of token. The   |
+| states before STATE_FIRST_FINAL are scanning states; reaching a final      |
+| state ends the token. FINAL_CONSUMES records whether the byte that caused  |
+| the final transition is part of the token (ie. the second = of ==) or is   |
+| only a lookahead that belongs to the next token (ie. the ; after an id).   |
+*****************************************************************************/
+enum DFSM_state_id : std::uint8_t {
+	STATE_START,  // between tokens (whitespace is skipped here)
+	STATE_IDENTIFIER,  // letter followed by letters/digits/_
+	STATE_BAD_IDENTIFIER,  // identifier containing an unaccepted character
+	STATE_INTEGER,  // digits
+	STATE_INTEGER_DOT,  // digits followed by .
+	STATE_REAL,  // digits . digits
+	STATE_BAD_NUMBER,  // number containing an unaccepted character
+	STATE_EQUALS,  // =
+	STATE_LESS,  // <
+	STATE_BANG,  // !
+	STATE_LEFT_BRACKET,  // [
+	STATE_COMMENT,  // [* ...
+	STATE_COMMENT_STAR,  // [* ... *
+
+	STATE_FIRST_FINAL,
+	FINAL_IDENTIFIER = STATE_FIRST_FINAL,  // identifier or keyword
+	FINAL_INTEGER,
+	FINAL_REAL,
+	FINAL_SYMBOL,  // one-character operator/separator
+	FINAL_ASSIGN,  // =
+	FINAL_EQUAL,  // ==
+	FINAL_GREATER_EQUAL,  // =>
+	FINAL_LESS,  // <
+	FINAL_LESS_EQUAL,  // <=
+	FINAL_NOT_EQUAL,  // !=
+	FINAL_COMMENT,
+	FINAL_EOF,
+	FINAL_ERROR,
+	STATE_COUNT
+};
+
+// sets of character classes, used by the DFSM specification below
+static constexpr std::uint32_t CLASS_SET(Char_class c) {
+	return 1u << c;
+}
+static constexpr std::uint32_t ANY_CLASS = (1u << CLASS_COUNT) - 1;
+static constexpr std::uint32_t ID_CHARS = CLASS_SET(CLASS_LETTER)
+	| CLASS_SET(CLASS_DIGIT) | CLASS_SET(CLASS_UNDERSCORE);
+// characters that end an identifier or a number without being part of it
+static constexpr std::uint32_t DELIMITERS = CLASS_SET(CLASS_SPACE)
+	| CLASS_SET(CLASS_NEWLINE) | CLASS_SET(CLASS_EQUALS)
+	| CLASS_SET(CLASS_LESS) | CLASS_SET(CLASS_GREATER) | CLASS_SET(CLASS_BANG)
+	| CLASS_SET(CLASS_STAR) | CLASS_SET(CLASS_SYMBOL) | CLASS_SET(CLASS_EOF);
+
+// one transition rule: from 'state', every class in 'classes' goes to 'next'
+struct DFSM_rule {
+	DFSM_state_id state;
+	std::uint32_t classes;
+	DFSM_state_id next;
+};
+
+/*****************************************************************************
+| The declarative specification of the DFSM. Rules are applied in order, so  |
+| a later rule overrides an earlier one for the same state and class. Any    |
+| transition that isn't specified goes to FINAL_ERROR.                       |
+*****************************************************************************/
+static constexpr DFSM_rule DFSM_SPEC[] = {
+	// whitespace between tokens
+	{ STATE_START, CLASS_SET(CLASS_SPACE) | CLASS_SET(CLASS_NEWLINE),
+	  STATE_START },
+	{ STATE_START, CLASS_SET(CLASS_EOF), FINAL_EOF },
+
+	// identifiers/keywords: a letter, then letters, digits, and underscores
+	{ STATE_START, CLASS_SET(CLASS_LETTER), STATE_IDENTIFIER },
+	{ STATE_IDENTIFIER, ANY_CLASS & ~DELIMITERS, STATE_BAD_IDENTIFIER },
+	{ STATE_IDENTIFIER, ID_CHARS, STATE_IDENTIFIER },
+	{ STATE_IDENTIFIER, DELIMITERS, FINAL_IDENTIFIER },
+	{ STATE_BAD_IDENTIFIER, ANY_CLASS & ~DELIMITERS, STATE_BAD_IDENTIFIER },
+
+	// integers (digits) and reals (digits . digits)
+	{ STATE_START, CLASS_SET(CLASS_DIGIT), STATE_INTEGER },
+	{ STATE_INTEGER, ANY_CLASS & ~DELIMITERS, STATE_BAD_NUMBER },
+	{ STATE_INTEGER, CLASS_SET(CLASS_DIGIT), STATE_INTEGER },
+	{ STATE_INTEGER, CLASS_SET(CLASS_DOT), STATE_INTEGER_DOT },
+	{ STATE_INTEGER, DELIMITERS, FINAL_INTEGER },
+	{ STATE_INTEGER_DOT, ANY_CLASS & ~DELIMITERS, STATE_BAD_NUMBER },
+	{ STATE_INTEGER_DOT, CLASS_SET(CLASS_DIGIT), STATE_REAL },
+	{ STATE_REAL, ANY_CLASS & ~DELIMITERS, STATE_BAD_NUMBER },
+	{ STATE_REAL, CLASS_SET(CLASS_DIGIT), STATE_REAL },
+	{ STATE_REAL, DELIMITERS, FINAL_REAL },
+	{ STATE_BAD_NUMBER, ANY_CLASS & ~DELIMITERS, STATE_BAD_NUMBER },
+
+	// operators and separators
+	{ STATE_START, CLASS_SET(CLASS_SYMBOL) | CLASS_SET(CLASS_GREATER)
+	  | CLASS_SET(CLASS_STAR), FINAL_SYMBOL },
+	{ STATE_START, CLASS_SET(CLASS_EQUALS), STATE_EQUALS },
+	{ STATE_EQUALS, ANY_CLASS, FINAL_ASSIGN },
+	{ STATE_EQUALS, CLASS_SET(CLASS_EQUALS), FINAL_EQUAL },
+	{ STATE_EQUALS, CLASS_SET(CLASS_GREATER), FINAL_GREATER_EQUAL },
+	{ STATE_START, CLASS_SET(CLASS_LESS), STATE_LESS },
+	{ STATE_LESS, ANY_CLASS, FINAL_LESS },
+	{ STATE_LESS, CLASS_SET(CLASS_EQUALS), FINAL_LESS_EQUAL },
+	{ STATE_START, CLASS_SET(CLASS_BANG), STATE_BANG },  // only used for !=
+	{ STATE_BANG, CLASS_SET(CLASS_EQUALS), FINAL_NOT_EQUAL },
+
+	// comments: [* ... *]
+	{ STATE_START, CLASS_SET(CLASS_LEFT_BRACKET), STATE_LEFT_BRACKET },
+	{ STATE_LEFT_BRACKET, CLASS_SET(CLASS_STAR), STATE_COMMENT },
+	{ STATE_COMMENT, ANY_CLASS & ~CLASS_SET(CLASS_EOF), STATE_COMMENT },
+	{ STATE_COMMENT, CLASS_SET(CLASS_STAR), STATE_COMMENT_STAR },
+	{ STATE_COMMENT_STAR, ANY_CLASS & ~CLASS_SET(CLASS_EOF), STATE_COMMENT },
+	{ STATE_COMMENT_STAR, CLASS_SET(CLASS_STAR), STATE_COMMENT_STAR },
+	{ STATE_COMMENT_STAR, CLASS_SET(CLASS_RIGHT_BRACKET), FINAL_COMMENT }
+};
+
+struct DFSM_table {
+	std::uint8_t next[STATE_FIRST_FINAL][CLASS_COUNT];  // fused transitions
+	bool consumes[STATE_COUNT];  // FINAL_CONSUMES (see DFSM_state_id)
+	Token_kind kind[STATE_COUNT];  // kind of token that a final state ends
+	Symbol_id symbol[STATE_COUNT];  // symbol of that token (if fixed)
+};
+
+static constexpr DFSM_table build_DFSM_table() {
+	DFSM_table table = {};
+	for (int state = 0; state < STATE_FIRST_FINAL; state++) {
+		for (int c = 0; c < CLASS_COUNT; c++) {
+			table.next[state][c] = FINAL_ERROR;
 		}
-		return { "ERROR", "! is an unrecognized symbol." };
 	}
-
-	// the only time [ can be used is for comments. use check_comment()
-	// to see if [**] is used properly
-	else if (buf == '[') {
-		return check_comment();
+	for (const DFSM_rule& rule : DFSM_SPEC) {
+		for (int c = 0; c < CLASS_COUNT; c++) {
+			if (rule.classes & CLASS_SET(static_cast<Char_class>(c))) {
+				table.next[rule.state][c] = rule.next;
+			}
+		}
 	}
 
-	// if char is an existing op/sep in SYM, return it and its token type
-	lexeme_value buf_string(1, buf);  // SYM uses strings -> need to convert
-	if (SYM.find(buf_string) != SYM.end()) {  // char found in SYM
-		return { SYM.at(buf_string), buf_string };
+	table.consumes[FINAL_SYMBOL] = true;
+	table.consumes[FINAL_EQUAL] = true;
+	table.consumes[FINAL_GREATER_EQUAL] = true;
+	table.consumes[FINAL_LESS_EQUAL] = true;
+	table.consumes[FINAL_NOT_EQUAL] = true;
+	table.consumes[FINAL_COMMENT] = true;
+
+	// the ids' keywords and the one-character symbols are looked up later
+	const struct { DFSM_state_id state; Token_kind kind; Symbol_id symbol; }
+	finals[] = {
+		{ FINAL_IDENTIFIER, TOKEN_IDENTIFIER, SYMBOL_IDENTIFIER },
+		{ FINAL_INTEGER, TOKEN_INTEGER, SYMBOL_INTEGER },
+		{ FINAL_REAL, TOKEN_REAL, SYMBOL_REAL },
+		{ FINAL_SYMBOL, TOKEN_OPERATOR, SYMBOL_NONE },
+		{ FINAL_ASSIGN, TOKEN_OPERATOR, OPERATOR_ASSIGN },
+		{ FINAL_EQUAL, TOKEN_OPERATOR, OPERATOR_EQUAL },
+		{ FINAL_GREATER_EQUAL, TOKEN_OPERATOR, OPERATOR_GREATER_EQUAL },
+		{ FINAL_LESS, TOKEN_OPERATOR, OPERATOR_LESS },
+		{ FINAL_LESS_EQUAL, TOKEN_OPERATOR, OPERATOR_LESS_EQUAL },
+		{ FINAL_NOT_EQUAL, TOKEN_OPERATOR, OPERATOR_NOT_EQUAL },
+		{ FINAL_COMMENT, TOKEN_COMMENT, SYMBOL_NONE },
+		{ FINAL_EOF, TOKEN_EOF, SYMBOL_EOF },
+		{ FINAL_ERROR, TOKEN_ERROR, SYMBOL_NONE }
+	};
+	for (const auto& final : finals) {
+		table.kind[final.state] = final.kind;
+		table.symbol[final.state] = final.symbol;
 	}
+	return table;
+}
 
-	// char is not an int, id, real, op, sep, or keyword -> invalid
-	else {
-		return { "ERROR", buf_string + " is an unrecognized symbol." };
-	}
+static constexpr DFSM_table DFSM = build_DFSM_table();
+
+/************************************************************************
+| The constructor reads the rest of the input file stream into memory   |
+| once, so that tokens are scanned out of a contiguous buffer. This     |
+| constructor is the fallback for inputs that can't be opened as a      |
+| Source_buffer (ie. pipes). The keyword and character tables are       |
+| built at compile time, so constructing a lexer is cheap.              |
+************************************************************************/
+Lexer::Lexer(std::ifstream* input_file_stream) {
+	ifs = input_file_stream;
+	stream_text.assign(std::istreambuf_iterator<char>(*ifs),
+					   std::istreambuf_iterator<char>());
+	text_begin = stream_text.data();
+	cursor = text_begin;
+	text_end = text_begin + stream_text.size();
+}
+
+/*************************************************************************
+| This constructor scans the characters in [text_begin, text_end), which |
+| usually come from a memory-mapped Source_buffer. The buffer must stay  |
+| alive for as long as the lexer is used.                                |
+*************************************************************************/
+Lexer::Lexer(const char* text_begin, const char* text_end) {
+	this->text_begin = text_begin;
+	cursor = text_begin;
+	this->text_end = text_end;
 }
 
 /*****************************************************************************
-| The DFSM_identifier function checks if a token is a valid id or keyword.   |
-| If it is, the DFSM will return its type (id/keyword) and its lexeme value. |
-| If not, the DFSM will return the "ERROR" token type, which will let the    |
-| main function know to stop running.                                        |
+| The lexer function extracts the next token from the input buffer. It runs  |
+| one table-driven DFSM: each byte is mapped to its character class, and     |
+| the class and the current state select the next state. Whitespace keeps    |
+| the DFSM in its start state (and moves the lexeme's beginning forward).    |
+| Once a final state is reached, it decides the token's kind. If the token   |
+| is invalid, the TOKEN_ERROR kind is returned.                              |
+|                                                                            |
+| The two places where the input is skipped rather than tokenized (runs of   |
+| whitespace before a token, and the body of a comment) are handed to the    |
+| scan kernels, which check a block of bytes per step instead of one byte.   |
 *****************************************************************************/
-Token Lexer::DFSM_identifier() {
-	// reset reader to get entire lexeme
-	ifs->unget();
-	lexeme_value lexeme = "";
-
-	// use the DFSM_id transition table when reading the token.
-	// if it ends on a valid state, then the token is a valid id/keyword
-	DFSM_state current_state = 0;
-	while (true) {
-		char buf = ifs->get();
-		// stop when whitespaces/operators/separators/EOF are reached
-		if (is_white_space(buf) || SYM.find(std::string(1, buf)) != SYM.end()
-			|| buf == '!' || !ifs->good()) {  // ! is for the != operator
-
-			// reset reader in case operators/separators are next
-			ifs->unget();
-			break;
-		}
-
-		// otherwise, traverse through DFSM table while reading rest of lexeme
-		if (isalpha(buf)) {  // letters
-			current_state = DFSM_id_table[current_state][0];
-		}
-		else if (isdigit(buf)) {  // digits
-			current_state = DFSM_id_table[current_state][1];
-		}
-		else if (buf == '_') {  // underscores
-			current_state = DFSM_id_table[current_state][2];
-		}
-		else {  // unaccepted characters
-			current_state = DFSM_id_table[current_state][3];
+Token Lexer::get_token() {
+	// the scan runs on local copies of the cursor and line number, so they
+	// stay in registers (the compiler can't assume that reading a char from
+	// the buffer doesn't change the lexer's members)
+	const char* p = cursor;
+	const char* end = text_end;
+	int line = line_number;
+
+	// most tokens are preceded by a single space (or none), which is cheaper
+	// to step over here. the kernel is only called for longer runs
+	if (p != end && is_white_space(*p)) {
+		line += (*p == '\n');
+		p++;
+		if (p != end && is_white_space(*p)) {
+			p = kernels->skip_white_space(p, end, &line);
 		}
-
-		// record entire lexeme
-		lexeme += buf;
 	}
+	const char* lexeme_begin = p;
 
-	// check to see if token ended on an accepting state (not 4)
-	if (current_state != 4) {
-		lexeme_value lower_lexeme = "";
-		for (int i = 0; i < lexeme.size(); i++) {
-			if (isupper(lexeme[i])) {
-				lower_lexeme += tolower(lexeme[i]);
-			}
-			else {
-				lower_lexeme += lexeme[i];
+	std::uint8_t state = STATE_START;
+	while (true) {
+		std::uint8_t c = (p != end)
+			? CHAR_TABLE.char_class[static_cast<unsigned char>(*p)]
+			: CLASS_EOF;
+		std::uint8_t next = DFSM.next[state][c];
+		if (next >= STATE_FIRST_FINAL) {
+			// the last byte is only part of the token for some final states
+			if (DFSM.consumes[next] && c != CLASS_EOF) {
+				line += (c == CLASS_NEWLINE);
+				p++;
 			}
+			state = next;
+			break;
 		}
 
-		// if the lexeme already exists in SYM, it is a keyword
-		if (SYM.find(lower_lexeme) != SYM.end()) {
-			return { "keyword", lexeme };
+		line += (c == CLASS_NEWLINE);  // keep track of where tokens are
+		p++;
+		// whitespace is never part of a lexeme (written as a select instead
+		// of an if, since whitespace and token bytes alternate unpredictably)
+		lexeme_begin = (next == STATE_START) ? p : lexeme_begin;
+		state = next;
+
+		if (state == STATE_COMMENT) {  // [* was just read
+			p = kernels->find_comment_end(p, end, &line);
+			if (p == end) {
+				continue;  // the comment never closes (EOF -> FINAL_ERROR)
+			}
+			p += 2;  // the comment's *]
+			state = FINAL_COMMENT;
+			break;
 		}
-		// otherwise, it is an identifier
-		else {
-			return { "identifier", lexeme };
+	}
+	cursor = p;
+	line_number = line;
+
+	// the final state determines the token's kind and symbol
+	Token token = make_token(DFSM.kind[state], DFSM.symbol[state],
+							 lexeme_begin);
+	if (state == FINAL_IDENTIFIER) {
+		// if the lexeme is in the keyword table, it is a keyword
+		Symbol_id keyword = find_keyword(lexeme_begin);
+		if (keyword != SYMBOL_NONE) {
+			token.kind = TOKEN_KEYWORD;
+			token.symbol = keyword;
 		}
 	}
-	else {  // invalid state
-		return { "ERROR", lexeme + " is an invalid identifier name" };
+	else if (state == FINAL_SYMBOL) {  // one-character operator/separator
+		token.symbol =
+			CHAR_TABLE.symbol[static_cast<unsigned char>(*lexeme_begin)];
+		token.kind = symbol_kind(token.symbol);
 	}
+	return token;
 }
 
 /*****************************************************************************
-| The DFSM_int_real function checks if a token is a valid int or real. If it |
-| is, the DFSM will return its type (int/real) and its lexeme value. If not, |
-| the DFSM will return the "ERROR" token type, which will let the main       |
-| function know to stop running.                                             |
+| find_keyword returns the keyword's Symbol_id if the identifier-shaped      |
+| lexeme from lexeme_begin up to the cursor is a keyword (in any case, since |
+| Rat23S is NOT case sensitive), or SYMBOL_NONE if it isn't. The lexeme's    |
+| slot in the perfect hash table holds the only keyword it can be, so one    |
+| probe and one case-insensitive comparison are enough.                      |
 *****************************************************************************/
-Token Lexer::DFSM_int_real() {
-	// reset reader to get entire lexeme
-	ifs->unget();
-	lexeme_value lexeme = "";
-
-	// use the DFSM_int_real transition table when reading the token
-	// if it ends on a valid state, then the token is a valid int/real
-	DFSM_state current_state = 0;
+Symbol_id Lexer::find_keyword(const char* lexeme_begin) {
+	std::size_t length = cursor - lexeme_begin;
+	int index = KEYWORD_TABLE.keyword[keyword_hash(length,
+		static_cast<unsigned char>(lexeme_begin[0]),
+		static_cast<unsigned char>(lexeme_begin[length - 1]))];
+	if (index < 0 || KEYWORDS[index].length != length) {
+		return SYMBOL_NONE;
+	}
+
+	const char* text = KEYWORDS[index].text;
+	for (std::size_t i = 0; i < length; i++) {
+		if ((lexeme_begin[i] | 0x20) != text[i]) {
+			return SYMBOL_NONE;
+		}
+	}
+	return KEYWORDS[index].symbol;
+}
+
+// returns where the lexer is currently pointing to (line number)
+int Lexer::get_line_number() {
+	return line_number;
+}
+
+/******************************************************************************
+| Checks if a file passes the Lexical Analysis phase. Returns 0 when the file |
+| passes, returns -1 when it does not. Every token that is read (except for   |
+| comments) is recorded, so the Syntax Analysis phase can reuse the tokens    |
+| instead of lexing the file a second time. Large files are lexed by several  |
+| threads at once (see analyze_parallel()), which records the same tokens and |
+| stops at the same error as lexing the file from front to back.              |
+******************************************************************************/
+static constexpr std::size_t MIN_CHUNK_BYTES = 256 * 1024;  // per thread
+
+int Lexer::Analyze() {
+	stream.text = text_begin;
+	stream.tokens.clear();
+
+	std::size_t threads = (thread_count != 0) ? thread_count
+		: std::thread::hardware_concurrency();
+	std::size_t chunk_count = std::min(threads,
+		static_cast<std::size_t>(text_end - cursor) / MIN_CHUNK_BYTES);
+	int result = (chunk_count > 1) ? analyze_parallel(chunk_count)
+		: analyze_sequential();
+
+	// Analysis successful (close ifs)
+	if (result == 0) {
+		close_ifs();
+	}
+	return result;
+}
+
+// lexes the input front to back, one token at a time
+int Lexer::analyze_sequential() {
+	stream.tokens.reserve((text_end - cursor) / 4 + 1);  // ~4 bytes per token
+
 	while (true) {
-		char buf = ifs->get();
-		// stop when whitespaces/operators/separators/EOF are reached
-		if (is_white_space(buf) || SYM.find(std::string(1, buf)) != SYM.end()
-			|| buf == '!' || !ifs->good()) {  // ! is for the != operator
+		Token token = get_token();
+
+		// if token is invalid, return error code (-1)
+		if (token.kind == TOKEN_ERROR) {
+			return -1;
+		}
+		else if (token.kind != TOKEN_COMMENT) {
+			stream.tokens.push_back(token);
+		}
 
-			// reset reader in case operators/separators are next
-			ifs->unget();
+		// stop reading once EOF is reached (EOF is the stream's last token)
+		if (token.kind == TOKEN_EOF) {
 			break;
 		}
+	}
+	return 0;
+}
+
+/******************************************************************************
+| Pipelined Lexical Analysis: instead of being recorded, every token (except  |
+| comments) is pushed into ring as soon as it is read, so the Syntax Analyzer |
+| can parse it on another thread while the rest of the input is still being   |
+| lexed. The last token pushed is EOF, or the ERROR token that the analysis   |
+| stopped at (get_tokens() stays empty: the analyzer keeps the tokens).       |
+******************************************************************************/
+int Lexer::Analyze(Token_ring& ring) {
+	stream.text = text_begin;
+	stream.tokens.clear();
 
-		// otherwise, traverse through DFSM table while reading rest of lexeme
-		if (isdigit(buf)) {  // digits
-			current_state = DFSM_int_real_table[current_state][0];
+	while (true) {
+		Token token = get_token();
+		if (token.kind != TOKEN_COMMENT) {
+			ring.push(token);
 		}
-		else if (buf == '.') {  // decimals
-			current_state = DFSM_int_real_table[current_state][1];
+		if (token.kind == TOKEN_ERROR) {
+			return -1;
 		}
-		else {  // unaccepted characters
-			current_state = DFSM_int_real_table[current_state][2];
+		if (token.kind == TOKEN_EOF) {
+			break;
 		}
-
-		// record entire lexeme
-		lexeme += buf;
 	}
+	close_ifs();
+	return 0;
+}
 
-	// check to see if token ended on an accepting state
-	if (current_state == 0) {  // int
-		return { "integer", lexeme };
+// runs task(0), ..., task(count - 1), each one on its own thread
+template <typename Task>
+static void run_on_threads(std::size_t count, const Task& task) {
+	std::vector<std::thread> workers;
+	workers.reserve(count - 1);
+	for (std::size_t i = 1; i < count; i++) {
+		workers.emplace_back(task, i);
 	}
-	else if (current_state == 2) {  // real
-		return { "real", lexeme };
-	}
-	else {  // invalid state
-		return { "ERROR", lexeme + " is an invalid integer/real value." };
+	task(0);  // this thread does the first task
+	for (std::thread& worker : workers) {
+		worker.join();
 	}
 }
 
-/****************************************************************************
-| If a token begins with =, it can either be the =, ==, or => operator.     |
-| This function will look at the token's next character to see if it is     |
-| either == or =>. If it is neither, then the token will be the = operator. |
-****************************************************************************/
-Token Lexer::check_operator_equals() {
-	char buf = ifs->get();  // get next character and check it
-	if (buf == '=') {
-		return { "operator", "==" };
-	}
-	else if (buf == '>') {
-		return { "operator", "=>" };
+/*****************************************************************************
+| analyze_parallel splits the input into chunks that each begin right after  |
+| a whitespace byte. No token continues across whitespace, so the lexer      |
+| reaches the first byte of a chunk either between tokens or inside a        |
+| [* *] comment. The chunks are lexed at the same time (one thread each),    |
+| from both of those states, and are then stitched together in order: a      |
+| chunk starts inside a comment exactly when the chunk before it ends        |
+| inside one. Each chunk counts its lines from its own start, so the token   |
+| lines are fixed by adding the newlines of the chunks before it.            |
+*****************************************************************************/
+int Lexer::analyze_parallel(std::size_t chunk_count) {
+	std::vector<const char*> bounds = { cursor };
+	std::size_t size = text_end - cursor;
+	for (std::size_t i = 1; i < chunk_count; i++) {
+		const char* split = std::max(cursor + size * i / chunk_count,
+									 bounds.back() + 1);
+		while (split < text_end && !is_white_space(split[-1])) {
+			split++;
+		}
+		if (split < text_end) {
+			bounds.push_back(split);
+		}
 	}
-	else {
-		ifs->unget();  // reset the reader since = is only one character
-		return { "operator", "=" };
+	bounds.push_back(text_end);
+	chunk_count = bounds.size() - 1;
+
+	std::vector<Lexed_chunk> chunks(chunk_count);
+	run_on_threads(chunk_count, [&](std::size_t i) {
+		lex_chunk(bounds[i], bounds[i + 1], i + 1 == chunk_count, chunks[i]);
+	});
+
+	// pick the state that each chunk really starts in, and find where its
+	// tokens go in the stream (stopping at the first chunk with an error)
+	std::vector<bool> starts_in_comment(chunk_count, false);
+	std::vector<std::size_t> first_token(chunk_count, 0);
+	std::vector<int> first_line(chunk_count, 1);
+	std::size_t token_count = 0;
+	std::size_t used_chunks = 0;
+	bool in_comment = false;
+	int line = 1;
+	bool error = false;
+	while (used_chunks < chunk_count && !error) {
+		const Lexed_chunk& chunk = chunks[used_chunks];
+		const Chunk_pass& pass = in_comment ? chunk.in_comment : chunk.in_code;
+		starts_in_comment[used_chunks] = in_comment;
+		first_token[used_chunks] = token_count;
+		first_line[used_chunks] = line;
+		token_count += pass.tokens.size();
+		if (in_comment) {  // + the tokens it shares with the code pass
+			token_count += chunk.in_code.tokens.size() - pass.rejoin;
+		}
+
+		line += pass.newlines;
+		in_comment = pass.ends_in_comment;
+		error = pass.error;
+		used_chunks++;
 	}
+	line_number = line;
+
+	// copy every chunk's tokens into the stream at the same time
+	stream.tokens.resize(token_count);
+	run_on_threads(used_chunks, [&](std::size_t i) {
+		Token* out = stream.tokens.data() + first_token[i];
+		auto append = [&](const std::vector<Token>& tokens, std::size_t from) {
+			for (std::size_t t = from; t < tokens.size(); t++) {
+				*out = tokens[t];
+				out->line += first_line[i];
+				out++;
+			}
+		};
+		if (starts_in_comment[i]) {
+			append(chunks[i].in_comment.tokens, 0);
+			append(chunks[i].in_code.tokens, chunks[i].in_comment.rejoin);
+		}
+		else {
+			append(chunks[i].in_code.tokens, 0);
+		}
+	});
+	return error ? -1 : 0;
 }
 
-/****************************************************************************
-| If a token begins with <, it can either be the < or <= operator.          |
-| This function will look at the token's next character to see if it is     |
-| <=. If not, then the token will be the < operator.                        |
-****************************************************************************/
-Token Lexer::check_operator_less_than() {
-	char buf = ifs->get();  // get next character and check it
-	if (buf == '=') {
-		return { "operator", "<=" };
-	}
-	else {
-		ifs->unget();  // reset the reader since < is only one character
-		return { "operator", "<" };
+/*****************************************************************************
+| lex_chunk lexes [chunk_begin, chunk_end) from both states that the chunk   |
+| can start in. The pass that starts inside a comment skips to the end of    |
+| the comment first. After that, it usually soon starts a token that the     |
+| code pass also started, and from there on both passes would read the same  |
+| tokens, so it stops and reuses the rest of the code pass instead.          |
+*****************************************************************************/
+void Lexer::lex_chunk(const char* chunk_begin, const char* chunk_end,
+					  bool last_chunk, Lexed_chunk& chunk) {
+	// the chunk's lexer keeps the whole input as its text, so token offsets
+	// are already relative to the start of the input
+	Lexer lexer(text_begin, chunk_end);
+	lexer.kernels = kernels;
+
+	lexer.cursor = chunk_begin;
+	lexer.line_number = 0;
+	lexer.lex_pass(last_chunk, nullptr, chunk.in_code);
+
+	lexer.cursor = chunk_begin;
+	lexer.line_number = 0;
+	const char* comment_end = kernels->find_comment_end(chunk_begin, chunk_end,
+														&lexer.line_number);
+	if (comment_end == chunk_end) {  // the whole chunk is inside the comment
+		chunk.in_comment.rejoin = chunk.in_code.tokens.size();
+		chunk.in_comment.newlines = lexer.line_number;
+		chunk.in_comment.error = last_chunk;  // the comment is never closed
+		chunk.in_comment.ends_in_comment = !last_chunk;
+		return;
 	}
+	lexer.cursor = comment_end + 2;  // the comment's *]
+	lexer.lex_pass(last_chunk, &chunk.in_code, chunk.in_comment);
 }
 
-/******************************************************************************
-| If the lexer function comes across a [, then the program has to check       |
-| if the [ is being properly used for a comment. All comments begin with "[*" |
-| and end with "*]". This function, check_comment, makes sure that all        |
-| comments follow this format. If a comment is not used properly, then this   |
-| function will return the "ERROR" token type, which will let the main        |
-| function know to stop running.                                              |
-******************************************************************************/
-Token Lexer::check_comment() {
-	char buf = ifs->get();
-
-	if (!ifs->good()) {  // file ends before comment is closed with **]
-		return { "ERROR", "Unclosed comment." };
-	}
-	else if (buf == '*') {
-		buf = ifs->get();
-		while (ifs->good()) {  // keep reading until EOF or comment ends
-			if (buf == '*') {
-				buf = ifs->get();
-				if (!ifs->good()) {
-					// file ended before comment was closed with "*]"
-					return { "ERROR", "Unclosed comment." };
-				}
-				else if (buf == ']') {  // file reaches "*]" -> comment ends
-					return { "comment", "" };
-				}
-				ifs->unget();  // if something else (like *a *b), reset reader
+// lexes the rest of a chunk into pass (if in_code is given, the pass stops
+// at the first token that in_code also starts, and reuses the rest of it)
+void Lexer::lex_pass(bool last_chunk, const Chunk_pass* in_code,
+					 Chunk_pass& pass) {
+	if (in_code == nullptr) {
+		pass.tokens.reserve((text_end - cursor) / 4 + 1);
+	}
+
+	std::size_t code_token = 0;  // in_code's first token that isn't before us
+	while (true) {
+		Token token = get_token();
+		if (token.kind == TOKEN_ERROR) {
+			// a chunk (except the last) ends with whitespace, so the only way
+			// to read up to its end is in a comment that a later chunk closes
+			pass.ends_in_comment = !last_chunk && cursor == text_end;
+			pass.error = !pass.ends_in_comment;
+			break;
+		}
+		else if (token.kind == TOKEN_EOF) {  // only the input's EOF is kept
+			if (last_chunk) {
+				pass.tokens.push_back(token);
 			}
-			else if (buf == '\n') {
-				line_number++;  // keep track of line number
+			break;
+		}
+		else if (token.kind == TOKEN_COMMENT) {
+			continue;
+		}
+
+		if (in_code != nullptr) {
+			while (code_token < in_code->tokens.size()
+				   && in_code->tokens[code_token].offset < token.offset) {
+				code_token++;
+			}
+			if (code_token < in_code->tokens.size()
+				&& in_code->tokens[code_token].offset == token.offset) {
+				pass.rejoin = code_token;
+				pass.newlines = in_code->newlines;
+				pass.error = in_code->error;
+				pass.ends_in_comment = in_code->ends_in_comment;
+				return;
 			}
-			buf = ifs->get();  // read the comment's next character
 		}
-		// file ended before comment was closed with "*]"
-		return { "ERROR", "Unclosed comment." };
+		pass.tokens.push_back(token);
 	}
-	else {  // comment does not start with "[*" (and [ is not a valid token)
-		return { "ERROR", "[ is an unrecognized symbol" };
+
+	pass.newlines = line_number;
+	if (in_code != nullptr) {  // none of in_code's tokens are reused
+		pass.rejoin = in_code->tokens.size();
 	}
 }
 
-/***********************************************************************
-| The is_white_space function will return true whenever a character is |
-| a whitespace (either a space, tab, or new line).                     |
-***********************************************************************/
-bool Lexer::is_white_space(char c) {
-	return c == ' ' || c == '\t' || c == '\v' || c == '\n';
+// returns the tokens recorded by the last call to Analyze()
+const Token_stream& Lexer::get_tokens() {
+	return stream;
 }
 
-/****************************************************************************
-| The initialize_sym_table function will add the operators, separators, and |
-| keywords from the RAT23S programming language to the SYM table. The SYM   |
-| table is used for lookups of existing tokens (ie. existing keywords)      |
-****************************************************************************/
-void Lexer::initialize_sym_table(Symbol_table& table) {
-	table["function"] = "keyword";
-	table["int"] = "keyword";
-	table["bool"] = "keyword";
-	table["real"] = "keyword";
-	table["if"] = "keyword";
-	table["fi"] = "keyword";
-	table["else"] = "keyword";
-	table["return"] = "keyword";
-	table["put"] = "keyword";
-	table["get"] = "keyword";
-	table["while"] = "keyword";
-	table["endwhile"] = "keyword";
-	table["true"] = "keyword";
-	table["false"] = "keyword";
-
-	table["="] = "operator";
-	table["+"] = "operator";
-	table["-"] = "operator";
-	table["*"] = "operator";
-	table["/"] = "operator";
-	table["=="] = "operator";
-	table["!="] = "operator";
-	table[">"] = "operator";
-	table["<"] = "operator";
-	table["<="] = "operator";
-	table["=>"] = "operator";
-
-	table["("] = "separator";
-	table[")"] = "separator";
-	table["{"] = "separator";
-	table["}"] = "separator";
-	table[";"] = "separator";
-	table["#"] = "separator";
-	table[","] = "separator";
+/*****************************************************************************
+| make_token builds a token whose lexeme spans from lexeme_begin up to (but  |
+| not including) the lexer's cursor. No characters are copied: the token     |
+| only records where its lexeme is in the input buffer.                      |
+*****************************************************************************/
+Token Lexer::make_token(Token_kind kind, Symbol_id symbol,
+						const char* lexeme_begin) {
+	Token token;
+	token.kind = kind;
+	token.symbol = symbol;
+	token.offset = static_cast<std::uint32_t>(lexeme_begin - text_begin);
+	token.length = static_cast<std::uint32_t>(cursor - lexeme_begin);
+	token.line = line_number;
+	return token;
 }
 
-// returns where the lexer is currently pointing to (line number)
-int Lexer::get_line_number() {
-	return line_number;
+// returns the text form of a token's kind (used when tokens are printed)
+const char* token_type_name(Token_kind kind) {
+	switch (kind) {
+		case TOKEN_IDENTIFIER: return "identifier";
+		case TOKEN_KEYWORD: return "keyword";
+		case TOKEN_INTEGER: return "integer";
+		case TOKEN_REAL: return "real";
+		case TOKEN_OPERATOR: return "operator";
+		case TOKEN_SEPARATOR: return "separator";
+		case TOKEN_COMMENT: return "comment";
+		case TOKEN_EOF: return "EOF";
+		case TOKEN_ERROR: return "ERROR";
+		default: return "";
+	}
 }
 
-/******************************************************************************
-| Checks if a file passes the Lexical Analysis phase. Returns 0 when the file |
-| passes, returns -1 when it does not.                                        |
-******************************************************************************/
-int Lexer::Analyze() {
-	// peek at next character
-	while (ifs->get() && ifs->good()) {  // if EOF reached, stop reading
-		ifs->unget();
-		Token token = get_token();
-		token_type type = token.first;
+// returns the kind of token that a symbol belongs to
+Token_kind symbol_kind(Symbol_id symbol) {
+	if (symbol >= KEYWORD_FUNCTION && symbol <= KEYWORD_FALSE) {
+		return TOKEN_KEYWORD;
+	}
+	else if (symbol >= OPERATOR_ASSIGN && symbol <= OPERATOR_GREATER_EQUAL) {
+		return TOKEN_OPERATOR;
+	}
+	else if (symbol >= SEPARATOR_LEFT_PAREN && symbol <= SEPARATOR_COMMA) {
+		return TOKEN_SEPARATOR;
+	}
 
-		// if token is invalid, return error code (-1)
-		if (type == "ERROR") {
-			return -1;
-		}
+	switch (symbol) {
+		case SYMBOL_IDENTIFIER: return TOKEN_IDENTIFIER;
+		case SYMBOL_INTEGER: return TOKEN_INTEGER;
+		case SYMBOL_REAL: return TOKEN_REAL;
+		case SYMBOL_EOF: return TOKEN_EOF;
+		default: return TOKEN_NONE;
 	}
+}
 
-	// Analysis successful (close ifs)
-	close_ifs();
-	return 0;
+// replaces the kernels that skip whitespace and comments (ie. to compare the
+// SIMD kernels against scalar_scan_kernels())
+void Lexer::use_scan_kernels(const Scan_kernels& scan_kernels) {
+	kernels = &scan_kernels;
+}
+
+// sets how many threads Analyze() may use (0 -> one per core)
+void Lexer::set_thread_count(unsigned count) {
+	thread_count = count;
 }
 
 // close the input file stream (for syntax analyzer's lexer too)
 void Lexer::close_ifs() {
-	ifs->close();
-}
\ No newline at end of file
+	if (ifs != nullptr) {
+		ifs->close();
+	}
+}
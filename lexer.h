@@ -3,68 +3,161 @@
 #define LEXER_H_
 
 /* ------------------------------- LIBRARIES ------------------------------- */
-#include <fstream>  // input file
-#include <map>  // symbol table (SYM)
+#include <cstddef>  // size_t
+#include <cstdint>  // fixed-size token fields
+#include <fstream>  // input file (fallback for non-seekable inputs)
 #include <string>
-#include <utility>  // token_type and lexeme_value pairs (ie. tokens)
+#include <string_view>  // lexemes (views into the input buffer)
+#include <vector>  // Token_stream
+
+#include "simd_scan.h"  // whitespace/comment skipping kernels
 
 /* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
-typedef std::string token_type;
-typedef std::string lexeme_value;
-typedef int DFSM_state;
+const std::size_t MAX_INPUT_SIZE = UINT32_MAX;  // bytes (see Token::offset)
+
+// the kind of a token. its text form ("identifier", "separator", etc.) is
+// only produced when a token is printed (see token_type_name())
+enum Token_kind : std::uint8_t {
+	TOKEN_NONE,  // no token (ie. the syntax analyzer hasn't read one yet)
+	TOKEN_IDENTIFIER,
+	TOKEN_KEYWORD,
+	TOKEN_INTEGER,
+	TOKEN_REAL,
+	TOKEN_OPERATOR,
+	TOKEN_SEPARATOR,
+	TOKEN_COMMENT,
+	TOKEN_EOF,
+	TOKEN_ERROR
+};
+
+// the exact symbol of a token. every keyword, operator, and separator has
+// its own id, so matching a token against an expected symbol is a single
+// integer comparison
+enum Symbol_id : std::uint8_t {
+	SYMBOL_NONE,  // comments, errors, and "no token"
+	SYMBOL_IDENTIFIER,
+	SYMBOL_INTEGER,
+	SYMBOL_REAL,
+	SYMBOL_EOF,
+
+	KEYWORD_FUNCTION,
+	KEYWORD_INT,
+	KEYWORD_BOOL,
+	KEYWORD_REAL,
+	KEYWORD_IF,
+	KEYWORD_FI,
+	KEYWORD_ELSE,
+	KEYWORD_RETURN,
+	KEYWORD_PUT,
+	KEYWORD_GET,
+	KEYWORD_WHILE,
+	KEYWORD_ENDWHILE,
+	KEYWORD_TRUE,
+	KEYWORD_FALSE,
 
-// SYM table format is { key = lexeme_value, value = token_type }
-// it is used to store the list of exisiting tokens (ie. ops, seps, keywords)
-typedef std::map <lexeme_value, token_type> Symbol_table;
+	OPERATOR_ASSIGN,  // =
+	OPERATOR_PLUS,  // +
+	OPERATOR_MINUS,  // -
+	OPERATOR_MULTIPLY,  // *
+	OPERATOR_DIVIDE,  // /
+	OPERATOR_EQUAL,  // ==
+	OPERATOR_NOT_EQUAL,  // !=
+	OPERATOR_GREATER,  // >
+	OPERATOR_LESS,  // <
+	OPERATOR_LESS_EQUAL,  // <=
+	OPERATOR_GREATER_EQUAL,  // =>
 
-// Tokens use format { token_type, lexeme_value }
-typedef std::pair <token_type, lexeme_value> Token;
+	SEPARATOR_LEFT_PAREN,  // (
+	SEPARATOR_RIGHT_PAREN,  // )
+	SEPARATOR_LEFT_BRACE,  // {
+	SEPARATOR_RIGHT_BRACE,  // }
+	SEPARATOR_SEMICOLON,  // ;
+	SEPARATOR_HASH,  // #
+	SEPARATOR_COMMA  // ,
+};
+
+// Tokens are 16 bytes and never own any memory: the lexeme is stored as a
+// span (offset, length) into the input buffer that the lexer scanned, so an
+// input can be at most MAX_INPUT_SIZE bytes long (compile() rejects the rest)
+struct Token {
+	Token_kind kind;
+	Symbol_id symbol;
+	std::uint32_t offset;  // position of the lexeme's first character
+	std::uint32_t length;  // number of characters in the lexeme
+	std::int32_t line;  // line number that the token appears on
+};
+
+// every token of an input file in order (comments removed, EOF last), and
+// the input buffer that the tokens' lexemes point into
+struct Token_stream {
+	const char* text = nullptr;
+	std::vector<Token> tokens;
+
+	std::string_view lexeme(const Token& token) const {
+		return std::string_view(text + token.offset, token.length);
+	}
+};
+
+// the tokens of one chunk of the input (see Lexer::analyze_parallel()),
+// lexed from one of the two states that a chunk can start in. line numbers
+// are counted from the chunk's first line (starting at 0)
+struct Chunk_pass {
+	std::vector<Token> tokens;
+	std::size_t rejoin = 0;  // (comment pass) first code pass token it reuses
+	int newlines = 0;  // newlines read (before the error, if there is one)
+	bool error = false;  // the chunk has a lexical error
+	bool ends_in_comment = false;  // a later chunk closes its last comment
+};
+
+struct Lexed_chunk {
+	Chunk_pass in_code;  // the chunk starts between tokens
+	Chunk_pass in_comment;  // the chunk starts inside a [* *] comment
+};
+
+class Token_ring;  // (see token_ring.h)
+
+const char* token_type_name(Token_kind kind);  // ie. "identifier"
+Token_kind symbol_kind(Symbol_id symbol);  // ie. KEYWORD_IF -> TOKEN_KEYWORD
 
 
 /* -------------------------------- CLASSES -------------------------------- */
 class Lexer {  // used for an input file's Lexical Analysis
 	private:
-		// Contains a list of all tokens (operators, separators, keywords, etc.)
-		Symbol_table SYM;
-		std::ifstream* ifs;  // reads input file
+		std::ifstream* ifs = nullptr;  // input file (only for stream input)
+		std::string stream_text;  // contents read from ifs (if used)
+		const char* text_begin;  // first character of the input
+		const char* cursor;  // next character to be read
+		const char* text_end;  // one past the last character of the input
 		int line_number = 1;  // records the line that the lexer is currently on
-
-		// DFSM transition table (N) for identifiers/keywords
-		DFSM_state DFSM_id_table[5][4] =
-		{
-			{1, 2, 3, 4},
-			{1, 2, 3, 4},
-			{1, 2, 3, 4},
-			{1, 2, 3, 4},
-			{4, 4, 4, 4}
-		};
-
-		// DFSM transition table (N) for integers/reals
-		DFSM_state DFSM_int_real_table[4][3] =
-		{
-			{0, 1, 3},
-			{2, 3, 3},
-			{2, 3, 3},
-			{3, 3, 3},
-		};
+		Token_stream stream;  // tokens recorded by Analyze()
+		const Scan_kernels* kernels = &best_scan_kernels();  // SIMD (if any)
+		unsigned thread_count = 0;  // lexing threads (0 -> one per core)
 
 		// lexer helper functions (implementations in Lexer.cpp)
-		Token DFSM_identifier();
-		Token DFSM_int_real();
-		Token check_operator_equals();
-		Token check_operator_less_than();
-		Token check_comment();
+		Token make_token(Token_kind kind, Symbol_id symbol,
+						 const char* lexeme_begin);
+
+		Symbol_id find_keyword(const char* lexeme_begin);
 
-		bool is_white_space(char c);
-		void initialize_sym_table(Symbol_table& table);
+		int analyze_sequential();
+		int analyze_parallel(std::size_t chunk_count);
+		void lex_chunk(const char* chunk_begin, const char* chunk_end,
+					   bool last_chunk, Lexed_chunk& chunk);
+		void lex_pass(bool last_chunk, const Chunk_pass* in_code,
+					  Chunk_pass& pass);
 
 
 	public:
-		Lexer(std::ifstream* input_file_stream);  // constructor
+		Lexer(std::ifstream* input_file_stream);  // reads the rest of the stream
+		Lexer(const char* text_begin, const char* text_end);  // whole buffer
 		Token get_token();  // extract (next) token from input file
 		int get_line_number();  // get position of lexer
 		int Analyze();  // returns -1 if LA error, returns 0 if file is good
+		int Analyze(Token_ring& ring);  // hands the tokens over instead
+		const Token_stream& get_tokens();  // tokens recorded by Analyze()
 		void close_ifs();  // close input file stream
+		void use_scan_kernels(const Scan_kernels& scan_kernels);  // ie. scalar
+		void set_thread_count(unsigned count);  // 1 -> never lex in parallel
 };
 
 #endif
\ No newline at end of file
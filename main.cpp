@@ -1,110 +1,438 @@
 /* ------------------------------- LIBRARIES ------------------------------- */
-#include <fstream>  // input file
+#include <chrono>  // --stats, --compare-vms
+#include <cstdlib>  // system()  atoi()  strtoul()
 #include <iostream>  // console error messages
+#include <iterator>  // istreambuf_iterator (--compare-vms)
 #include <string>  // strings
 
-#include "lexer.h"  // lexer
-#include "syntax_analyzer.h"  // syntax analyzer
+#include "batch.h"  // --batch
+#include "code_generator.h"  // --listing, --binary
+#include "compile_cache.h"  // lexer and syntax analyzer (and --cache)
+#include "input_buffer.h"  // --run (get())
+#include "jit_machine.h"  // --vm jit, --compare-vms
+#include "output_buffer.h"  // output file, --run (put())
+#include "register_machine.h"  // --vm register, --compare-vms
+#include "source_buffer.h"  // memory-mapped input file
+#include "stack_machine.h"  // --run
 
 
-/* -------------------------- FUNCTION PROTOTYPES -------------------------- */
-void skip_BOM_encoding(std::ifstream& ifs);  // handles UTF-8 files with BOM
+// keeps the console window open (only when the user was prompted for files)
+static void pause_console(bool interactive) {
+	if (interactive) {
+		system("pause");
+	}
+}
 
+// writes the listing and the binary form of code to the files that were asked
+// for ("" -> not asked for)
+static bool write_code(const Stack_code& code, const Symbol_table& symbols,
+					   const std::string& listing_file_name,
+					   const std::string& binary_file_name) {
+	if (!listing_file_name.empty()) {
+		Output_buffer listing;
+		if (!listing.open(listing_file_name)) {
+			std::cout << "ERROR: Couldn't create/edit file '"
+				<< listing_file_name << "'\n";
+			return false;
+		}
+		write_listing(code, symbols, listing);
+	}
+	if (!binary_file_name.empty() && !save_code(code, binary_file_name)) {
+		std::cout << "ERROR: Couldn't create/edit file '" << binary_file_name
+			<< "'\n";
+		return false;
+	}
+	return true;
+}
+
+enum Machine { STACK_MACHINE, REGISTER_MACHINE, JIT_MACHINE };  // --vm
+const int MACHINE_COUNT = JIT_MACHINE + 1;
 
+// runs code on machine, and measures how long it took (the register code's
+// translation and compilation included). returns the name of what it ran on
+static const char* timed_run(const Stack_code& code, Machine machine,
+							 Input_buffer* input, Output_buffer* output,
+							 Run_result& result, double& seconds) {
+	std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	const char* name = "stack machine";
+	if (machine == STACK_MACHINE) {
+		result = Stack_Machine(&code).Run(input, output);
+	}
+	else {
+		Register_code register_code;
+		Register_Translator(&code, &register_code).Translate();
+		if (machine == REGISTER_MACHINE) {
+			name = "register machine";
+			result = Register_Machine(&register_code).Run(input, output);
+		}
+		else {
+			Jit_Machine jit(&register_code);
+			result = jit.Run(input, output);
+			name = jit.is_native() ? "JIT"
+				: "JIT (not compiled: ran on the register machine)";
+		}
+	}
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - start;
+	seconds = elapsed.count();
+	return name;
+}
+
+// writes the error that a run ended with (if any), and how fast it ran
+// (stats), to stderr
+static void report_run(const char* machine, const Run_result& result,
+					   double seconds, bool stats) {
+	if (result.status != RUN_FINISHED) {
+		std::cerr << "ERROR: " << run_status_message(result.status)
+			<< " (instruction " << result.instruction + 1 << ")\n";
+	}
+	if (stats && result.executed == 0) {  // (machine code isn't counted)
+		std::cerr << machine << ": ran in " << seconds << " s\n";
+	}
+	else if (stats) {
+		std::cerr << machine << ": " << result.executed << " instructions in "
+			<< seconds << " s (" << result.executed / seconds / 1e6
+			<< " million instructions/s)\n";
+	}
+}
+
+// runs code with get() and put() on the console (see stack_machine.cpp,
+// register_machine.cpp, and jit_machine.cpp). after the file names were
+// prompted for (prompted), get() reads through std::cin, which may already
+// have read past them
+static int run_code(const Stack_code& code, Machine machine, bool stats,
+					bool prompted) {
+	Input_buffer input(prompted ? std::cin.rdbuf() : nullptr);
+	Output_buffer output;
+	output.open_standard_output();
+	Run_result result;
+	double seconds;
+	const char* name = timed_run(code, machine, &input, &output, result,
+								 seconds);
+	report_run(name, result, seconds, stats);
+	return (result.status == RUN_FINISHED) ? 0 : -1;
+}
+
+// writes how often the packrat memo table kept a rule from running again
+// (--packrat with --stats) to stderr
+static void report_memo(const Compile_summary& summary) {
+	if (summary.from_cache) {
+		std::cerr << "packrat: not run (the result came from the cache)\n";
+		return;
+	}
+	const Memo_stats& memo = summary.memo;
+	std::cerr << "packrat: " << memo.lookups << " lookups, " << memo.hits
+		<< " hits, " << memo.stored << " stored, " << memo.dropped
+		<< " dropped\n";
+}
+
+// runs code on every machine, with the same input (all of the console's,
+// read first), writes the stack machine's output to the console, and
+// reports how fast each one ran. -1 if they didn't all do the same (the same
+// output, and the same error at the same instruction)
+static int compare_machines(const Stack_code& code) {
+	std::string input_text((std::istreambuf_iterator<char>(std::cin)),
+						   std::istreambuf_iterator<char>());
+	std::string outputs[MACHINE_COUNT];
+	Run_result results[MACHINE_COUNT];
+	double seconds[MACHINE_COUNT];
+	const char* names[MACHINE_COUNT];
+	for (int machine = 0; machine < MACHINE_COUNT; machine++) {
+		Input_buffer input(input_text);
+		Output_buffer output(&outputs[machine]);
+		names[machine] = timed_run(code, static_cast<Machine>(machine),
+								   &input, &output, results[machine],
+								   seconds[machine]);
+	}
+	Output_buffer console;
+	console.open_standard_output();
+	console << outputs[0];
+	console.close();
+
+	bool same = true;
+	for (int machine = 0; machine < MACHINE_COUNT; machine++) {
+		report_run(names[machine], results[machine], seconds[machine], true);
+		if (machine != STACK_MACHINE) {
+			std::cerr << names[machine] << " speedup: "
+				<< seconds[STACK_MACHINE] / seconds[machine] << "x\n";
+			same = same && outputs[machine] == outputs[STACK_MACHINE]
+				&& results[machine].status == results[STACK_MACHINE].status
+				&& results[machine].instruction
+					== results[STACK_MACHINE].instruction;
+		}
+	}
+	if (!same) {
+		std::cerr << "ERROR: The machines' output differs\n";
+		return -1;
+	}
+	return (results[0].status == RUN_FINISHED) ? 0 : -1;
+}
 
 /*******************************************************************************
 | The main file receives the names of the input and output files that the user |
 | wants to use for syntax analysis of the Rat23S programming language. If the  |
 | user enters a non-existing/invalid input/output file, an error message will  |
 | be printed to the terminal. Otherwise, the file will go through syntax       |
-| analysis. If it fails, an error message will be printed at the end of the    |
-| output file. If it passes, the program will exit with code 0, and the output |
-| file will have a list of all the productions used in the input file.         |
+| analysis. If it fails, an error message for each syntax error will be        |
+| printed in the output file, and the program will exit with code -1. If it    |
+| passes, the program will exit with code 0, and the output file will have a   |
+| list of all the productions used in the input file.                          |
+|                                                                              |
+| usage: main [--no-trace] [--pipeline] [--semantic] [--max-depth N]           |
+|             [--backtracking] [--packrat N] [--listing file] [--binary file]  |
+|             [--compare-vms] [--run [--vm stack|register|jit]] [--stats]      |
+|             [--cache directory] [input_file output_file]                     |
+|        main --batch directory|file_list [--jobs N] [--out-dir directory]     |
+|             [--no-trace] [--semantic] [--max-depth N] [--cache directory]    |
+|        main --run-binary file [--vm stack|register|jit] [--stats]            |
+|             [--compare-vms]                                                  |
+| the file names are prompted for if they aren't given. --no-trace leaves out  |
+| the tokens and productions, so only errors are written to the output file.   |
+| --pipeline lexes the input on a second thread while it is being parsed.      |
+| --semantic also checks that every identifier is declared once, and before    |
+| it is used (see semantic_analyzer.cpp). --max-depth sets how many levels     |
+| deep statements and parentheses can be nested (default: 100000, 0 -> no      |
+| limit). --backtracking tries each alternative of a rule in order until one   |
+| works, instead of picking it by the current token (the output is the same,   |
+| see syntax_analyzer.cpp). --packrat memoizes up to N rules that failed at a  |
+| token, so that backtracking and error recovery never run them there again    |
+| (see syntax_analyzer.cpp), and --stats reports how often that happened.      |
+| --listing and --binary also translate a program that passes into Rat23S      |
+| stack machine code, and write its listing (instructions and symbol table) or |
+| its binary form to a file of their own (see code_generator.cpp), without the |
+| compile cache. --run translates it too, and then runs it, with get() reading |
+| the console and put() writing to it (see stack_machine.cpp). --vm register   |
+| runs it on the register machine instead, which translates the stack code     |
+| first (see register_machine.cpp), and --vm jit compiles that into x86-64     |
+| machine code, and runs it natively (see jit_machine.cpp). --stats then       |
+| reports how many instructions it ran, and how fast. --compare-vms runs it on |
+| all three, with the same input, checks that they print the same (and fail at |
+| the same instruction), and reports how fast each one was. --run-binary runs  |
+| (or compares) a file that --binary wrote, without compiling anything, once   |
+| load_code() has checked it. --batch checks every *.txt file of a directory   |
+| (or every file listed in a text file, one per line) on N threads (default:   |
+| one per core), and prints a summary (see batch.cpp). --cache saves the       |
+| results in a directory, and an input that is already in it isn't analyzed    |
+| again (see compile_cache.cpp).                                               |
 *******************************************************************************/
-int main() {
-	// get input file
-	std::cout << "Enter the name of an input text file: ";
+int main(int argc, char* argv[]) {
+	bool trace = true;
+	bool pipelined = false;
+	std::size_t max_depth = DEFAULT_MAX_DEPTH;
+	std::size_t packrat_entries = 0;
+	Parse_mode mode = PARSE_PREDICTIVE;
+	bool semantic = false;
+	std::string listing_file_name;
+	std::string binary_file_name;
+	std::string run_binary_file_name;
+	bool run = false;
+	bool stats = false;
+	Machine machine = STACK_MACHINE;
+	bool compare_vms = false;
+	bool batch = false;
+	std::string cache_directory;
+	Batch_options batch_options;
 	std::string input_file_name;
-	std::cin >> input_file_name;
-	std::ifstream ifs;
-	ifs.open(input_file_name);
+	std::string output_file_name;
+	int file_names = 0;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		bool has_value = (i + 1 < argc);
+		if (argument == "--no-trace") {
+			trace = false;
+		}
+		else if (argument == "--pipeline") {
+			pipelined = true;
+		}
+		else if (argument == "--semantic") {
+			semantic = true;
+		}
+		else if (argument == "--max-depth" && has_value) {
+			max_depth = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--backtracking") {
+			mode = PARSE_BACKTRACKING;
+		}
+		else if (argument == "--packrat" && has_value) {
+			packrat_entries = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--listing" && has_value) {
+			listing_file_name = argv[++i];
+		}
+		else if (argument == "--binary" && has_value) {
+			binary_file_name = argv[++i];
+		}
+		else if (argument == "--run-binary" && has_value) {
+			run_binary_file_name = argv[++i];
+		}
+		else if (argument == "--run") {
+			run = true;
+		}
+		else if (argument == "--stats") {
+			stats = true;
+		}
+		else if (argument == "--vm" && has_value
+				 && (std::string(argv[i + 1]) == "stack"
+					 || std::string(argv[i + 1]) == "register"
+					 || std::string(argv[i + 1]) == "jit")) {
+			std::string name = argv[++i];
+			machine = (name == "stack") ? STACK_MACHINE
+				: (name == "register") ? REGISTER_MACHINE : JIT_MACHINE;
+		}
+		else if (argument == "--compare-vms") {
+			compare_vms = true;
+		}
+		else if (argument == "--cache" && has_value) {
+			cache_directory = argv[++i];
+		}
+		else if (argument == "--batch" && has_value) {
+			batch = true;
+			batch_options.inputs = argv[++i];
+		}
+		else if (argument == "--jobs" && has_value) {
+			batch_options.thread_count = std::atoi(argv[++i]);
+		}
+		else if (argument == "--out-dir" && has_value) {
+			batch_options.output_directory = argv[++i];
+		}
+		else if (file_names == 0 && argument[0] != '-') {
+			input_file_name = argument;
+			file_names++;
+		}
+		else if (file_names == 1 && argument[0] != '-') {
+			output_file_name = argument;
+			file_names++;
+		}
+		else {
+			std::cout << "usage: " << argv[0]
+				<< " [--no-trace] [--pipeline] [--semantic] [--max-depth N]"
+				<< " [--backtracking] [--packrat N] [--listing file]"
+				<< " [--binary file]"
+				<< " [--run [--vm stack|register|jit]] [--stats]"
+				<< " [--compare-vms]"
+				<< " [--cache directory] [input_file output_file]\n"
+				<< "       " << argv[0] << " --batch directory|file_list"
+				<< " [--jobs N] [--out-dir directory] [--no-trace]"
+				<< " [--semantic] [--max-depth N] [--cache directory]\n"
+				<< "       " << argv[0] << " --run-binary file"
+				<< " [--vm stack|register|jit] [--stats] [--compare-vms]\n";
+			return -1;
+		}
+	}
+	if (batch) {
+		batch_options.trace = trace;
+		batch_options.cache_directory = cache_directory;
+		batch_options.max_depth = max_depth;
+		batch_options.semantic = semantic;
+		return run_batch(batch_options);
+	}
+	if (!run_binary_file_name.empty()) {
+		Stack_code code;
+		if (!load_code(run_binary_file_name, code)) {
+			std::cout << "ERROR: Couldn't load code file '"
+				<< run_binary_file_name << "'\n";
+			return -1;
+		}
+		return compare_vms ? compare_machines(code)
+						   : run_code(code, machine, stats, false);
+	}
+	bool interactive = (file_names < 2);
+
+	// get input file
+	if (interactive) {
+		std::cout << "Enter the name of an input text file: ";
+		std::cin >> input_file_name;
+	}
 
-	// check if input file exists
-	if (!ifs.is_open()) {
+	// check if input file exists. the whole file is mapped into one buffer,
+	// and if the file uses UTF-8 with BOM, the BOM encoding is skipped
+	Source_buffer source;
+	if (!source.open(input_file_name)) {
 		std::cout << "ERROR: Couldn't open file '" << input_file_name << "'\n";
-		system("pause");
+		pause_console(interactive);
 		return -1;
 	}
 
-	// if the input file uses UTF-8 with BOM, skip the BOM encoding
-	skip_BOM_encoding(ifs);  // if not, the function will reset ifs to beginning
-
 
 	// get output file
-	std::cout << "Enter the name of the output file you want to create/edit: ";
-	std::string output_file_name;
-	std::cin >> output_file_name;
-	std::ofstream ofs;
+	if (interactive) {
+		std::cout << "Enter the name of the output file you want to"
+			" create/edit: ";
+		std::cin >> output_file_name;
+	}
+	Output_buffer ofs;
 	ofs.open(output_file_name);
 
 	// check if output file was successfully opened/created
 	if (!ofs.is_open()) {
 		std::cout << "ERROR: Couldn't create/edit file '" << output_file_name
 			<< "'\n";
-		system("pause");
+		pause_console(interactive);
 		return -1;
 	}
-	std::cout << "\n";
+	if (interactive) {
+		std::cout << "\n";
+	}
 
 
-	// Lexical Analysis
-	std::ifstream lexical_ifs;  // separate reader from SA phase
-	lexical_ifs.open(input_file_name);
-	skip_BOM_encoding(lexical_ifs);  // skip BOM then do LA phase
-	Lexer lexical_analyzer(&lexical_ifs);
-	if (lexical_analyzer.Analyze() != 0) {  // LA failed, print error msg
-		std::cout << "ERROR: File failed lexical analysis on line " <<
-			lexical_analyzer.get_line_number() << ".\n";
-		ofs << "ERROR: File failed lexical analysis on line " <<
-			lexical_analyzer.get_line_number() << ".\n";
-		system("pause");
+	// Lexical and Syntax Analysis (the file is only lexed once: its tokens
+	// are recorded and handed to the SA phase)
+	Compile_options options;
+	options.mode = mode;
+	options.trace = trace;
+	options.pipelined = pipelined;
+	options.max_depth = max_depth;
+	options.packrat_entries = packrat_entries;
+	options.semantic = semantic;
+	options.generate = !listing_file_name.empty() || !binary_file_name.empty()
+		|| run || compare_vms;
+	options.output = &ofs;
+	Compile_summary summary;
+	if (options.generate) {  // (the code isn't kept in the cache)
+		Compilation compilation = compile(source.begin(), source.end(),
+										  options);
+		summary.lexed = compilation.lexed();
+		summary.diagnostics = compilation.diagnostics();
+		summary.memo = compilation.memo_stats();
+		if (stats && packrat_entries > 0) {
+			report_memo(summary);
+		}
+		if (compilation.code() && !write_code(*compilation.code(),
+											  *compilation.symbols(),
+											  listing_file_name,
+											  binary_file_name)) {
+			pause_console(interactive);
+			return -1;
+		}
+		if ((run || compare_vms) && compilation.code()) {
+			ofs.close();  // (the output file is complete before it runs)
+			return compare_vms ? compare_machines(*compilation.code())
+							   : run_code(*compilation.code(), machine,
+										  stats, interactive);
+		}
+	}
+	else {
+		Compile_cache cache(cache_directory);  // (never hit without --cache)
+		summary = cache.compile(source.begin(), source.end(), options);
+		if (stats && packrat_entries > 0) {
+			report_memo(summary);
+		}
+	}
+	if (!summary.lexed) {  // LA failed, print error msg
+		const Diagnostic& error = summary.diagnostics.front();
+		std::cout << "ERROR: " << error.message;
+		if (error.line > 0) {  // (0 -> the file was too large to lex)
+			std::cout << " on line " << error.line;
+		}
+		std::cout << ".\n";
+		ofs.close();
+		pause_console(interactive);
+		return -1;
+	}
+	if (!summary.passed()) {
 		return -1;
 	}
-
-	// Syntax Analysis
-	Syntax_Analyzer syntax_analyzer(&ifs, &ofs);
-	syntax_analyzer.Rat23S();
 
 	return 0;
 }
-
-/*******************************************************************************
-| This helper function skips over the BOM encoding (first 3 bytes) of a UTF-8  |
-| file that uses BOM. The encoding has to be overpassed because the .get()     |
-| method of ifstream objects can't tell the difference between a byte used for |
-| encoding vs. a byte used for text. And when the encoding bytes are read by   |
-| the lexer (ie. when isalpha() or isdigit() are called), an error will occur. |
-| Thus, this function will help skip over those encoding bytes (if present).   |
-*******************************************************************************/
-void skip_BOM_encoding(std::ifstream& ifs) {
-	// a UTF-8 file's 3 beginning bytes indicate if it uses BOM
-	if (ifs.get() == 0xEF) {  // byte 1
-		if (ifs.get() == 0xBB) {  // byte 2
-			if (ifs.get() == 0xBF) {  // byte 3
-				return;  // all 3 bytes matched, exit
-			}
-			else {  // only first 2 bytes matched
-				ifs.unget();
-				ifs.unget();
-				ifs.unget();  // reset the 3 bytes that were peeked at
-			}
-		}
-		else {  // only first byte matched
-			ifs.unget();
-			ifs.unget();  // reset the 2 bytes that were peeked at
-		}
-	}
-	else {  // no bytes matched
-		ifs.unget();  // reset the 1 byte that was peeked at
-	}
-}
\ No newline at end of file
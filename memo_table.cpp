@@ -0,0 +1,83 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include "memo_table.h"
+
+/******************************************************************************
+| The table is a flat array of 16-byte entries, found by hashing the key and  |
+| probing the slots after it (linear probing), so a lookup usually reads a    |
+| single cache line. It has twice as many slots as max_entries, which keeps   |
+| the probes short, and it never grows: once max_entries results are stored,  |
+| new ones are dropped (the rule is just run again when it is needed). The    |
+| traces are kept in one array, so storing one doesn't allocate on its own.   |
+******************************************************************************/
+Memo_table::Memo_table(std::size_t max_entries) {
+	resize(max_entries);
+}
+
+void Memo_table::resize(std::size_t new_max_entries) {
+	max_entries = new_max_entries;
+	count = 0;
+	stats = Memo_stats();
+	traces.clear();
+	entries.clear();
+	shift = 64;
+	if (max_entries == 0) {
+		return;
+	}
+
+	unsigned bits = 1;
+	while ((std::size_t(1) << bits) < 2 * max_entries) {
+		bits++;
+	}
+	shift = 64 - bits;
+	entries.assign(std::size_t(1) << bits, Entry());
+}
+
+// Fibonacci hashing: the top bits of key * 2^64 / phi
+std::size_t Memo_table::slot(std::uint64_t key) const {
+	return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+const std::uint8_t* Memo_table::find(std::uint8_t rule, std::size_t position,
+									 std::size_t& length) {
+	stats.lookups++;
+	std::uint64_t key = (static_cast<std::uint64_t>(position) << 8) | rule;
+	std::size_t mask = entries.size() - 1;
+	for (std::size_t i = slot(key); entries[i].key != 0; i = (i + 1) & mask) {
+		if (entries[i].key == key) {
+			stats.hits++;
+			length = entries[i].trace_length;
+			return traces.data() + entries[i].trace_start;
+		}
+	}
+	return nullptr;
+}
+
+// (rule must not be 0, so that no key is 0)
+void Memo_table::store(std::uint8_t rule, std::size_t position,
+					   const std::uint8_t* trace, std::size_t length) {
+	if (count == max_entries || traces.size() + length > UINT32_MAX) {
+		stats.dropped++;
+		return;
+	}
+
+	std::uint64_t key = (static_cast<std::uint64_t>(position) << 8) | rule;
+	std::size_t mask = entries.size() - 1;
+	std::size_t i = slot(key);
+	while (entries[i].key != 0) {
+		if (entries[i].key == key) {  // (already stored)
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+
+	entries[i].key = key;
+	entries[i].trace_start = static_cast<std::uint32_t>(traces.size());
+	entries[i].trace_length = static_cast<std::uint32_t>(length);
+	traces.insert(traces.end(), trace, trace + length);
+	count++;
+	stats.stored++;
+}
+
+const Memo_stats& Memo_table::get_stats() const {
+	return stats;
+}
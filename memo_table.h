@@ -0,0 +1,54 @@
+#pragma once
+#ifndef MEMO_TABLE_H_
+#define MEMO_TABLE_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <cstdint>  // keys, trace ids
+#include <vector>  // entries, traces
+
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+// how much the packrat memo table was used during one analysis
+struct Memo_stats {
+	std::size_t lookups = 0;  // rules that looked for a memoized result
+	std::size_t hits = 0;  // rules that didn't have to run again
+	std::size_t stored = 0;  // results that were memoized
+	std::size_t dropped = 0;  // results that didn't fit (the table was full)
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Memo_table {  // (rule, token position) -> productions of its failure
+	private:
+		struct Entry {
+			std::uint64_t key;  // (position << 8) | rule (0 -> empty)
+			std::uint32_t trace_start;  // index of the trace in traces
+			std::uint32_t trace_length;
+		};
+
+		std::vector<Entry> entries;  // open addressing (power of 2 slots)
+		std::vector<std::uint8_t> traces;  // every trace, one after another
+		std::size_t max_entries = 0;  // 0 -> no memoization
+		std::size_t count = 0;  // entries in use
+		unsigned shift = 64;  // 64 - log2(entries.size())
+		Memo_stats stats;
+
+		std::size_t slot(std::uint64_t key) const;
+
+	public:
+		explicit Memo_table(std::size_t max_entries = 0);
+		Memo_table(const Memo_table&) = delete;
+		Memo_table& operator=(const Memo_table&) = delete;
+
+		bool enabled() const { return max_entries != 0; }
+		void resize(std::size_t max_entries);  // (clears the table)
+		// the trace of rule's failure at position (null if it isn't known)
+		const std::uint8_t* find(std::uint8_t rule, std::size_t position,
+								 std::size_t& length);
+		void store(std::uint8_t rule, std::size_t position,
+				   const std::uint8_t* trace, std::size_t length);
+		const Memo_stats& get_stats() const;
+};
+
+#endif
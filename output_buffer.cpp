@@ -0,0 +1,167 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // min()
+#include <cerrno>  // EINTR
+#include <charconv>  // to_chars()
+#include <cstring>  // memcpy()
+#include <string>
+
+#ifdef _WIN32
+#include <fcntl.h>  // _O_TEXT
+#include <io.h>  // _open()  _write()  _close()  _lseeki64()  _chsize_s()
+#include <sys/stat.h>  // _S_IREAD  _S_IWRITE
+#else
+#include <fcntl.h>  // open()
+#include <unistd.h>  // write()  close()  lseek()  ftruncate()
+#endif
+
+#include "output_buffer.h"
+
+/*****************************************************************************
+| Text is collected in one large buffer and handed to the OS one full buffer |
+| at a time, instead of going through a stream one line at a time. On        |
+| Windows, the file is opened in text mode, so newlines are written as CRLF  |
+| (just like an std::ofstream would write them).                             |
+|                                                                            |
+| An Output_buffer can also write to a string instead of a file (ie. when a  |
+| compilation's output is kept in memory by a program using compiler.h).     |
+*****************************************************************************/
+Output_buffer::Output_buffer(std::size_t capacity) : buffer(capacity) {}
+
+Output_buffer::Output_buffer(std::string* output_text)
+	: output_text(output_text), buffer(64 << 10) {}
+
+Output_buffer::~Output_buffer() {
+	close();
+}
+
+bool Output_buffer::open(const std::string& file_name) {
+	close();
+#ifdef _WIN32
+	fd = _open(file_name.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_TEXT,
+			   _S_IREAD | _S_IWRITE);
+#else
+	fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+	owns_fd = true;
+	return fd >= 0;
+}
+
+bool Output_buffer::open_standard_output() {
+	close();
+	fd = 1;
+	owns_fd = false;
+	return true;
+}
+
+bool Output_buffer::is_open() const {
+	return fd >= 0 || output_text != nullptr;
+}
+
+void Output_buffer::flush() {
+	write_all(buffer.data(), used);
+	used = 0;
+}
+
+void Output_buffer::close() {
+	if (fd < 0) {
+		flush();  // (in memory, there is nothing to close)
+		return;
+	}
+	flush();
+	if (owns_fd) {
+#ifdef _WIN32
+		_close(fd);
+#else
+		::close(fd);
+#endif
+	}
+	fd = -1;
+}
+
+/******************************************************************************
+| position() and truncate() take back text that shouldn't have been written   |
+| (ie. the trace of a pipelined compilation that turned out to have a lexical |
+| error, see compile()). A position is an offset in the file (or the output   |
+| string), so it stays right when Windows turns newlines into CRLF.           |
+******************************************************************************/
+std::size_t Output_buffer::position() {
+	flush();
+	if (output_text != nullptr) {
+		return output_text->size();
+	}
+	if (fd < 0) {
+		return 0;
+	}
+#ifdef _WIN32
+	long long offset = _lseeki64(fd, 0, SEEK_CUR);
+#else
+	off_t offset = lseek(fd, 0, SEEK_CUR);
+#endif
+	return (offset < 0) ? 0 : static_cast<std::size_t>(offset);
+}
+
+void Output_buffer::truncate(std::size_t position) {
+	used = 0;
+	if (output_text != nullptr) {
+		output_text->resize(std::min(position, output_text->size()));
+		return;
+	}
+	if (fd < 0) {
+		return;
+	}
+#ifdef _WIN32
+	_chsize_s(fd, position);
+	_lseeki64(fd, position, SEEK_SET);
+#else
+	if (ftruncate(fd, position) == 0) {
+		lseek(fd, position, SEEK_SET);
+	}
+#endif
+}
+
+Output_buffer& Output_buffer::operator<<(std::string_view text) {
+	if (used + text.size() > buffer.size()) {
+		flush();
+		if (text.size() > buffer.size()) {  // too big to be buffered
+			write_all(text.data(), text.size());
+			return *this;
+		}
+	}
+	std::memcpy(buffer.data() + used, text.data(), text.size());
+	used += text.size();
+	return *this;
+}
+
+Output_buffer& Output_buffer::operator<<(char c) {
+	return *this << std::string_view(&c, 1);
+}
+
+Output_buffer& Output_buffer::operator<<(int number) {
+	char digits[16];
+	std::to_chars_result result = std::to_chars(digits, digits + 16, number);
+	return *this << std::string_view(digits, result.ptr - digits);
+}
+
+// writes all of data to the file (the OS may accept it in several pieces)
+// or appends it to the output string
+void Output_buffer::write_all(const char* data, std::size_t size) {
+	if (output_text != nullptr) {
+		output_text->append(data, size);
+		return;
+	}
+	while (size > 0 && fd >= 0) {
+#ifdef _WIN32
+		int written = _write(fd, data, static_cast<unsigned>(size));
+#else
+		ssize_t written = ::write(fd, data, size);
+#endif
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;  // nothing else can be written (ie. the disk is full)
+		}
+		data += written;
+		size -= written;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef OUTPUT_BUFFER_H_
+#define OUTPUT_BUFFER_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <string>  // file name
+#include <string_view>  // text to write
+#include <vector>  // buffer
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Output_buffer {  // output file that is written in large blocks
+	private:
+		int fd = -1;  // file descriptor of the output file
+		bool owns_fd = true;  // (false -> standard output, never closed)
+		std::string* output_text = nullptr;  // or the string written to
+		std::vector<char> buffer;  // text that hasn't been written yet
+		std::size_t used = 0;  // number of bytes in the buffer
+
+		void write_all(const char* data, std::size_t size);
+
+	public:
+		explicit Output_buffer(std::size_t capacity = 1 << 20);  // 1 MiB
+		explicit Output_buffer(std::string* output_text);  // in memory
+		~Output_buffer();  // flushes and closes the file
+		Output_buffer(const Output_buffer&) = delete;
+		Output_buffer& operator=(const Output_buffer&) = delete;
+
+		bool open(const std::string& file_name);  // create/truncate the file
+		bool open_standard_output();  // (ie. a program's put())
+		bool is_open() const;  // (always true in memory)
+		void flush();  // write the buffered text to the file
+		void close();  // flush and close the file
+		std::size_t position();  // where the next text will be written
+		void truncate(std::size_t position);  // drop the text written after it
+
+		Output_buffer& operator<<(std::string_view text);
+		Output_buffer& operator<<(char c);
+		Output_buffer& operator<<(int number);
+};
+
+#endif
@@ -0,0 +1,557 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // fill()  max()
+
+#include "register_machine.h"
+
+// (registers that aren't memory are numbered by kind until they are assigned)
+const std::uint32_t CONSTANT_REGISTER = 1u << 31;
+const std::uint32_t TEMPORARY_REGISTER = 1u << 30;
+// (the temporaries that operands popped off the operand stack go to)
+const std::uint32_t PULLED_LEFT = TEMPORARY_REGISTER | 0;
+const std::uint32_t PULLED_RIGHT = TEMPORARY_REGISTER | 1;
+const std::uint32_t FIRST_POSITION = 2;  // the temporary of stack value 0
+
+static bool is_temporary(std::uint32_t reg) {
+	return (reg & TEMPORARY_REGISTER) && !(reg & CONSTANT_REGISTER);
+}
+
+std::uint32_t Register_code::register_count() const {
+	return memory_size + static_cast<std::uint32_t>(constants.size())
+		+ temporary_count;
+}
+
+Register_Translator::Register_Translator(const Stack_code* stack_code,
+										 Register_code* register_code)
+	: code(stack_code), result(register_code) {}
+
+std::uint32_t Register_Translator::emit(Register_opcode opcode,
+										std::uint32_t x, std::uint32_t y,
+										std::uint32_t z) {
+	Register_instruction instruction;
+	instruction.opcode = opcode;
+	instruction.x = x;
+	instruction.y = y;
+	instruction.z = z;
+	instruction.source = source;
+	result->instructions.push_back(instruction);
+	return static_cast<std::uint32_t>(result->instructions.size() - 1);
+}
+
+std::uint32_t Register_Translator::constant(std::int32_t value) {
+	auto found = constant_registers.find(value);
+	if (found != constant_registers.end()) {
+		return found->second;
+	}
+	std::uint32_t reg = CONSTANT_REGISTER
+		| static_cast<std::uint32_t>(result->constants.size());
+	result->constants.push_back(value);
+	constant_registers.emplace(value, reg);
+	return reg;
+}
+
+// the temporary that holds the value at position (from the bottom) of the
+// stack values, once it is computed
+std::uint32_t Register_Translator::temporary(std::size_t position) {
+	std::uint32_t index = FIRST_POSITION + static_cast<std::uint32_t>(position);
+	result->temporary_count = std::max(result->temporary_count, index + 1);
+	return TEMPORARY_REGISTER | index;
+}
+
+// the register that holds value: the one it names, or into, which the
+// operation is computed into (as its own stack instruction, wherever that
+// happens, so a division by zero is reported where the stack machine has it).
+// a division is computed after the ones under it, which the stack machine ran
+// first
+std::uint32_t Register_Translator::compute(const Stack_value& value,
+										   std::uint32_t into) {
+	if (value.operation == OP_PUSHM) {
+		return value.left;
+	}
+	if (value.operation == OP_DIV) {
+		compute_divisions(value.source);
+	}
+	std::uint32_t at = emit(static_cast<Register_opcode>(
+								REG_ADD + (value.operation - OP_ADD)),
+							into, value.left, value.right);
+	result->instructions[at].source = value.source;
+	return into;
+}
+
+// the position of a value that is about to be pushed. the value under it is
+// computed first if it reads the temporary of that position
+std::size_t Register_Translator::next_position() {
+	std::size_t position = values.size();
+	if (position > 0) {
+		Stack_value& below = values[position - 1];
+		if (below.operation != OP_PUSHM
+			&& below.right == temporary(position)) {
+			below = { OP_PUSHM, compute(below, temporary(position - 1)), 0,
+					  below.source };
+		}
+	}
+	return position;
+}
+
+// pops a stack value, and returns the register that holds it. with no stack
+// values, the operand stack is popped into pulled_into instead
+std::uint32_t Register_Translator::pop_operand(std::uint32_t pulled_into) {
+	if (values.empty()) {
+		emit(REG_POP, pulled_into, 0);
+		return pulled_into;
+	}
+	std::size_t position = values.size() - 1;
+	std::uint32_t reg = compute(values[position], temporary(position));
+	values.pop_back();
+	return reg;
+}
+
+/******************************************************************************
+| The result of an operation is left on the stack values, not computed yet,   |
+| so that what uses it can take its operands instead: a comparison that JUMPZ |
+| pops becomes a compare-and-branch (REG_JUMPZ_GRT ...), and one that POPM    |
+| pops is computed straight into that memory slot (x = x + 1 is PUSHM, PUSHI, |
+| ADD, POPM: one REG_ADD of a slot and a constant into the slot). Its left    |
+| operand can only be its own temporary, and its right one the temporary      |
+| above it (which next_position() computes it before reusing), or else it is  |
+| computed right away.                                                        |
+******************************************************************************/
+void Register_Translator::push_operation(Opcode operation,
+										 std::uint32_t left,
+										 std::uint32_t right) {
+	Stack_value value = { operation, left, right, source };
+	std::size_t position = next_position();
+	std::uint32_t own = temporary(position);
+	if ((is_temporary(left) && left != own)
+		|| (is_temporary(right) && right != temporary(position + 1))) {
+		value = { OP_PUSHM, compute(value, own), 0, source };
+	}
+	values.push_back(value);
+}
+
+// moves the stack values to the operand stack (where a jump or a call goes,
+// the values are all on the operand stack). a PUSH's source is where its
+// value was pushed, since that is where the stack machine overflows
+void Register_Translator::flush() {
+	for (std::size_t i = 0; i < values.size(); i++) {
+		std::uint32_t at = emit(REG_PUSH, 0, compute(values[i], temporary(i)));
+		result->instructions[at].source = values[i].source;
+	}
+	values.clear();
+}
+
+// computes the stack values that are divisions pushed before stack
+// instruction before (all of them by default), in the order the stack machine
+// ran them, so that one that fails fails there: before output is written or
+// input is read, before the program ends with the values still on the stack,
+// or before a later division (the other operations can't fail)
+void Register_Translator::compute_divisions(std::uint32_t before) {
+	for (std::size_t i = 0; i < values.size(); i++) {
+		if (values[i].operation == OP_DIV && values[i].source < before) {
+			values[i] = { OP_PUSHM, compute(values[i], temporary(i)), 0,
+						  values[i].source };
+		}
+	}
+}
+
+// POPM slot: the stack values that read slot are computed first (they were
+// pushed before it changes)
+void Register_Translator::store(std::uint32_t slot) {
+	if (values.empty()) {
+		emit(REG_POP, slot, 0);
+		return;
+	}
+	Stack_value value = values.back();
+	values.pop_back();
+	for (std::size_t i = 0; i < values.size(); i++) {
+		Stack_value& other = values[i];
+		if (other.left != slot
+			&& (other.operation == OP_PUSHM || other.right != slot)) {
+			continue;
+		}
+		std::uint32_t reg = temporary(i);
+		if (other.operation == OP_PUSHM) {
+			emit(REG_MOVE, reg, slot);
+		}
+		else {
+			compute(other, reg);
+		}
+		other = { OP_PUSHM, reg, 0, other.source };
+	}
+
+	if (value.operation == OP_PUSHM) {
+		emit(REG_MOVE, slot, value.left);
+	}
+	else {
+		compute(value, slot);
+	}
+}
+
+// JUMPZ target (the target is a stack instruction until Translate() ends)
+void Register_Translator::branch(std::uint32_t target) {
+	std::uint32_t jump;
+	if (values.empty()) {
+		emit(REG_POP, PULLED_RIGHT, 0);
+		jump = emit(REG_JUMPZ, 0, PULLED_RIGHT);
+	}
+	else {
+		std::size_t position = values.size() - 1;
+		Stack_value condition = values[position];
+		values.pop_back();
+		flush();  // (doesn't touch the temporaries of condition)
+		if (condition.operation >= OP_GRT && condition.operation <= OP_LEQ) {
+			jump = emit(static_cast<Register_opcode>(
+							REG_JUMPZ_GRT + (condition.operation - OP_GRT)),
+						0, condition.left, condition.right);
+		}
+		else {
+			jump = emit(REG_JUMPZ, 0,
+						compute(condition, temporary(position)));
+		}
+	}
+	result->instructions[jump].target = target;
+}
+
+void Register_Translator::translate(const Instruction& instruction) {
+	std::uint32_t operand = static_cast<std::uint32_t>(instruction.operand);
+	switch (instruction.opcode) {
+		case OP_PUSHI:
+			next_position();
+			values.push_back({ OP_PUSHM, constant(instruction.operand), 0,
+							   source });
+			break;
+		case OP_PUSHM:
+			next_position();
+			values.push_back({ OP_PUSHM, operand, 0, source });
+			break;
+		case OP_POPM:
+			store(operand);
+			break;
+		case OP_SOUT:
+			compute_divisions();
+			emit(REG_WRITE, 0, pop_operand(PULLED_RIGHT));
+			break;
+		case OP_SIN: {
+			compute_divisions();
+			std::uint32_t reg = temporary(next_position());
+			emit(REG_READ, reg, 0);
+			values.push_back({ OP_PUSHM, reg, 0, source });
+			break;
+		}
+		case OP_JUMPZ:
+			branch(operand);
+			break;
+		case OP_JUMP:
+		case OP_CALL:
+			flush();
+			result->instructions[emit((instruction.opcode == OP_JUMP)
+										  ? REG_JUMP : REG_CALL, 0, 0)]
+				.target = operand;
+			break;
+		case OP_LABEL:
+			break;
+		case OP_RETURN:
+			flush();
+			emit(REG_RETURN, 0, 0);
+			break;
+		case OP_HALT:
+			compute_divisions();
+			values.clear();
+			emit(REG_HALT, 0, 0);
+			break;
+		default: {  // OP_ADD ... OP_LEQ
+			std::uint32_t right = pop_operand(PULLED_RIGHT);
+			std::uint32_t left = pop_operand(PULLED_LEFT);
+			push_operation(instruction.opcode, left, right);
+			break;
+		}
+	}
+}
+
+// numbers the constants after the memory, and the temporaries after them
+static std::uint32_t assigned_register(std::uint32_t reg,
+									   std::uint32_t constant_base,
+									   std::uint32_t temporary_base) {
+	if (reg & CONSTANT_REGISTER) {
+		return constant_base + (reg & ~CONSTANT_REGISTER);
+	}
+	if (reg & TEMPORARY_REGISTER) {
+		return temporary_base + (reg & ~TEMPORARY_REGISTER);
+	}
+	return reg;
+}
+
+void Register_Translator::assign_registers() {
+	std::uint32_t constant_base = result->memory_size;
+	std::uint32_t temporary_base = constant_base
+		+ static_cast<std::uint32_t>(result->constants.size());
+	for (Register_instruction& instruction : result->instructions) {
+		instruction.x = assigned_register(instruction.x, constant_base,
+										  temporary_base);
+		instruction.y = assigned_register(instruction.y, constant_base,
+										  temporary_base);
+		instruction.z = assigned_register(instruction.z, constant_base,
+										  temporary_base);
+	}
+}
+
+/******************************************************************************
+| Translate() goes through the stack code once, keeping the values it pushes  |
+| as stack values (registers, or operations on them) instead of emitting      |
+| anything, until an instruction pops them. So the PUSHM and PUSHI of an      |
+| operation become its operands, and only the values that are still there at  |
+| a jump, a call, or the target of one, are moved to the operand stack. The   |
+| temporary of a value is chosen by its position on the stack, which is never |
+| overwritten while the value is still there.                                 |
+******************************************************************************/
+void Register_Translator::Translate() {
+	const std::vector<Instruction>& instructions = code->instructions;
+	std::size_t count = instructions.size();
+	result->instructions.clear();
+	result->instructions.reserve(count);
+	result->memory_size = code->memory_size;
+	result->constants.clear();
+	result->temporary_count = FIRST_POSITION;  // (the pulled ones)
+	constant_registers.clear();
+	values.clear();
+
+	leaders.assign(count + 1, false);
+	starts.assign(count + 1, 0);
+	for (const Instruction& instruction : instructions) {
+		if (instruction.opcode == OP_JUMPZ || instruction.opcode == OP_JUMP
+			|| instruction.opcode == OP_CALL) {
+			leaders[instruction.operand] = true;
+		}
+	}
+
+	for (std::size_t i = 0; i < count; i++) {
+		source = static_cast<std::uint32_t>(i);
+		if (leaders[i]) {
+			flush();
+		}
+		starts[i] = static_cast<std::uint32_t>(result->instructions.size());
+		translate(instructions[i]);
+	}
+	compute_divisions();  // (only on the way out, past the last instruction)
+	values.clear();
+	starts[count] = static_cast<std::uint32_t>(result->instructions.size());
+
+	for (Register_instruction& instruction : result->instructions) {
+		if ((instruction.opcode >= REG_JUMPZ && instruction.opcode <= REG_JUMP)
+			|| instruction.opcode == REG_CALL) {
+			instruction.target = starts[instruction.target];
+		}
+	}
+	assign_registers();
+}
+
+Register_Machine::Register_Machine(const Register_code* register_code,
+								   std::size_t stack_values,
+								   std::size_t max_calls)
+	: code(register_code), registers(register_code->register_count()),
+	  stack_size(stack_values), call_depth(max_calls),
+	  stack(new std::int32_t[stack_values]),
+	  returns(new const Threaded_instruction*[max_calls]) {
+	std::copy(code->constants.begin(), code->constants.end(),
+			  registers.begin() + code->memory_size);
+}
+
+/******************************************************************************
+| Run() is direct-threaded like the stack machine's (see stack_machine.cpp),  |
+| and its registers are resolved into pointers by the same translation. Only  |
+| the memory is reset for each run: nothing writes the constants, and a       |
+| temporary is always written before it is read.                              |
+******************************************************************************/
+#ifdef STACK_MACHINE_THREADED
+#define OPCODE(name) op_##name:
+#define DISPATCH() goto *ip->handler
+#else
+#define OPCODE(name) case REG_##name:
+#define DISPATCH() continue
+#endif
+
+// (executed counts the instructions that were finished)
+#define GO(next_instruction) { \
+	ip = (next_instruction); \
+	executed++; \
+	DISPATCH(); \
+}
+#define NEXT() GO(ip + 1)
+
+#define ARITHMETIC(name, operator) OPCODE(name) \
+	*ip->x = static_cast<std::int32_t>(static_cast<std::uint32_t>(*ip->y) \
+		operator static_cast<std::uint32_t>(*ip->z)); \
+	NEXT();
+
+#define COMPARISON(name, operator) OPCODE(name) \
+	*ip->x = (*ip->y operator *ip->z) ? 1 : 0; \
+	NEXT();
+
+#define BRANCH(name, operator) OPCODE(name) \
+	if (!(*ip->y operator *ip->z)) GO(ip->target); \
+	NEXT();
+
+Run_result Register_Machine::Run(Input_buffer* input, Output_buffer* output) {
+	const int REG_END = REGISTER_OPCODE_COUNT;  // (after the last instruction)
+#ifdef STACK_MACHINE_THREADED
+	static const void* const HANDLERS[REGISTER_OPCODE_COUNT + 1] = {
+		&&op_MOVE, &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_GRT, &&op_LES,
+		&&op_EQU, &&op_NEQ, &&op_GEQ, &&op_LEQ, &&op_JUMPZ, &&op_JUMPZ_GRT,
+		&&op_JUMPZ_LES, &&op_JUMPZ_EQU, &&op_JUMPZ_NEQ, &&op_JUMPZ_GEQ,
+		&&op_JUMPZ_LEQ, &&op_JUMP, &&op_PUSH, &&op_POP, &&op_READ, &&op_WRITE,
+		&&op_CALL, &&op_RETURN, &&op_HALT, &&op_END
+	};
+#endif
+	if (program.empty()) {
+		std::size_t count = code->instructions.size();
+		program.resize(count + 1);
+		std::int32_t* base = registers.data();
+		for (std::size_t i = 0; i <= count; i++) {
+			Register_instruction instruction;
+			if (i < count) {
+				instruction = code->instructions[i];
+			}
+			Threaded_instruction& threaded = program[i];
+			int opcode = (i < count) ? instruction.opcode : REG_END;
+#ifdef STACK_MACHINE_THREADED
+			threaded.handler = HANDLERS[opcode];
+#else
+			threaded.opcode = static_cast<Register_opcode>(opcode);
+#endif
+			threaded.x = base + instruction.x;
+			threaded.y = base + instruction.y;
+			threaded.z = base + instruction.z;
+			threaded.target = program.data() + instruction.target;
+		}
+	}
+	std::fill(registers.begin(), registers.begin() + code->memory_size, 0);
+
+	Run_result result;
+	const Threaded_instruction* ip = program.data();
+	std::int32_t* const stack_begin = stack.get();
+	std::int32_t* const stack_end = stack_begin + stack_size;
+	std::int32_t* sp = stack_begin;  // (the next free value)
+	const Threaded_instruction** const returns_begin = returns.get();
+	const Threaded_instruction** const returns_end = returns_begin
+													 + call_depth;
+	const Threaded_instruction** rp = returns_begin;
+	std::uint64_t executed = 0;
+
+#ifdef STACK_MACHINE_THREADED
+	DISPATCH();
+#else
+	for (;;) switch (static_cast<int>(ip->opcode)) {  // (REG_END isn't one)
+#endif
+	OPCODE(MOVE)
+		*ip->x = *ip->y;
+		NEXT();
+
+	ARITHMETIC(ADD, +)
+	ARITHMETIC(SUB, -)
+	ARITHMETIC(MUL, *)
+
+	OPCODE(DIV)
+		if (*ip->z == 0) {
+			result.status = RUN_DIVIDE_BY_ZERO;
+			goto failed;
+		}
+		if (*ip->z == -1) {  // (the lowest value / -1 overflows)
+			*ip->x = static_cast<std::int32_t>(
+				0u - static_cast<std::uint32_t>(*ip->y));
+		}
+		else {
+			*ip->x = *ip->y / *ip->z;
+		}
+		NEXT();
+
+	COMPARISON(GRT, >)
+	COMPARISON(LES, <)
+	COMPARISON(EQU, ==)
+	COMPARISON(NEQ, !=)
+	COMPARISON(GEQ, >=)
+	COMPARISON(LEQ, <=)
+
+	OPCODE(JUMPZ)
+		if (*ip->y == 0) GO(ip->target);
+		NEXT();
+
+	BRANCH(JUMPZ_GRT, >)
+	BRANCH(JUMPZ_LES, <)
+	BRANCH(JUMPZ_EQU, ==)
+	BRANCH(JUMPZ_NEQ, !=)
+	BRANCH(JUMPZ_GEQ, >=)
+	BRANCH(JUMPZ_LEQ, <=)
+
+	OPCODE(JUMP)
+		GO(ip->target);
+
+	OPCODE(PUSH)
+		if (sp == stack_end) goto overflow;
+		*sp++ = *ip->y;
+		NEXT();
+
+	OPCODE(POP)
+		if (sp == stack_begin) goto underflow;
+		*ip->x = *--sp;
+		NEXT();
+
+	OPCODE(READ)
+		if (!input->buffered()) {
+			output->flush();  // (put() before get() shows up first)
+		}
+		if (!input->read_integer(*ip->x)) {
+			result.status = RUN_BAD_INPUT;
+			goto failed;
+		}
+		NEXT();
+
+	OPCODE(WRITE)
+		*output << static_cast<int>(*ip->y) << '\n';
+		NEXT();
+
+	OPCODE(CALL)
+		if (rp == returns_end) {
+			result.status = RUN_CALL_OVERFLOW;
+			goto failed;
+		}
+		*rp++ = ip + 1;
+		GO(ip->target);
+
+	OPCODE(RETURN)
+		if (rp == returns_begin) {
+			result.status = RUN_RETURN_UNDERFLOW;
+			goto failed;
+		}
+		GO(*--rp);
+
+	OPCODE(HALT)
+		executed++;
+		goto finished;
+
+	OPCODE(END)
+		goto finished;
+#ifndef STACK_MACHINE_THREADED
+	default:
+		goto finished;
+	}
+#endif
+
+overflow:
+	result.status = RUN_STACK_OVERFLOW;
+	goto failed;
+underflow:
+	result.status = RUN_STACK_UNDERFLOW;
+failed:
+	result.instruction = code->instructions[ip - program.data()].source;
+finished:
+	result.executed = executed;
+	output->flush();
+	return result;
+}
+
+#undef OPCODE
+#undef DISPATCH
+#undef GO
+#undef NEXT
+#undef ARITHMETIC
+#undef COMPARISON
+#undef BRANCH
@@ -0,0 +1,151 @@
+#pragma once
+#ifndef REGISTER_MACHINE_H_
+#define REGISTER_MACHINE_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <cstdint>  // registers, counters
+#include <memory>  // fixed-size stacks
+#include <unordered_map>  // constant registers
+#include <vector>  // instructions, registers, symbolic stack
+
+#include "code_generator.h"  // Stack_code, Opcode
+#include "input_buffer.h"  // get()
+#include "output_buffer.h"  // put()
+#include "stack_machine.h"  // Run_result, STACK_MACHINE_THREADED
+
+/******************************************************************************
+| The register machine runs the same programs as the stack machine, but its   |
+| instructions name their operands: every register is a memory slot, a        |
+| constant, or a temporary that holds an intermediate value of an expression. |
+| An operand stack is still there for the values that are live across a jump  |
+| or a call (arguments and return values), which PUSH and POP move to and     |
+| from registers. Its code is translated from Stack_code (see                 |
+| register_machine.cpp), so it runs side by side with the stack machine.      |
+******************************************************************************/
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+enum Register_opcode : std::uint8_t {
+	REG_MOVE,  // x = y
+	REG_ADD,  // x = y + z
+	REG_SUB,  // x = y - z
+	REG_MUL,  // x = y * z
+	REG_DIV,  // x = y / z
+	REG_GRT,  // x = y > z
+	REG_LES,  // x = y < z
+	REG_EQU,  // x = y == z
+	REG_NEQ,  // x = y != z
+	REG_GEQ,  // x = y >= z
+	REG_LEQ,  // x = y <= z
+	REG_JUMPZ,  // jump to target if y is 0
+	REG_JUMPZ_GRT,  // jump to target unless y > z
+	REG_JUMPZ_LES,  // ... unless y < z
+	REG_JUMPZ_EQU,  // ... unless y == z
+	REG_JUMPZ_NEQ,  // ... unless y != z
+	REG_JUMPZ_GEQ,  // ... unless y >= z
+	REG_JUMPZ_LEQ,  // ... unless y <= z
+	REG_JUMP,  // jump to target
+	REG_PUSH,  // push y on the operand stack
+	REG_POP,  // pop the operand stack into x
+	REG_READ,  // read an integer into x
+	REG_WRITE,  // print y
+	REG_CALL,  // jump to target, and come back after RETURN
+	REG_RETURN,  // jump back to the instruction after the last CALL
+	REG_HALT  // stop the program
+};
+const int REGISTER_OPCODE_COUNT = REG_HALT + 1;
+
+struct Register_instruction {
+	Register_opcode opcode;
+	std::uint32_t x = 0;  // the register written (REG_MOVE ... REG_LEQ,
+	std::uint32_t y = 0;  // REG_POP, REG_READ), and the ones read
+	std::uint32_t z = 0;
+	std::uint32_t target = 0;  // instruction index (jumps, REG_CALL)
+	std::uint32_t source = 0;  // the stack instruction it was translated from
+};
+
+struct Register_code {  // a whole program for the register machine
+	std::vector<Register_instruction> instructions;
+	std::uint32_t memory_size = 0;  // registers [0, memory_size) are memory,
+	std::vector<std::int32_t> constants;  // then come the constants,
+	std::uint32_t temporary_count = 0;  // and then the temporaries
+
+	std::uint32_t register_count() const;
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Register_Translator {  // translates Stack_code into Register_code
+	private:
+		// a value on the stack that hasn't been computed yet:
+		// operation(left, right), or just the register left (OP_PUSHM)
+		struct Stack_value {
+			Opcode operation;
+			std::uint32_t left;
+			std::uint32_t right;
+			std::uint32_t source = 0;  // the stack instruction that pushed it
+		};
+
+		const Stack_code* code;
+		Register_code* result;
+		std::vector<Stack_value> values;  // the top of the operand stack
+		std::vector<bool> leaders;  // (by stack instruction) a block starts
+		std::vector<std::uint32_t> starts;  // where each one was translated to
+		std::unordered_map<std::int32_t, std::uint32_t> constant_registers;
+		std::uint32_t source = 0;  // the stack instruction being translated
+
+		std::uint32_t emit(Register_opcode opcode, std::uint32_t x,
+						   std::uint32_t y, std::uint32_t z = 0);
+		std::uint32_t constant(std::int32_t value);
+		std::uint32_t temporary(std::size_t position);
+		std::uint32_t compute(const Stack_value& value, std::uint32_t into);
+		std::size_t next_position();
+		std::uint32_t pop_operand(std::uint32_t pulled_into);
+		void push_operation(Opcode operation, std::uint32_t left,
+							std::uint32_t right);
+		void flush();
+		void compute_divisions(std::uint32_t before = UINT32_MAX);
+		void store(std::uint32_t slot);
+		void branch(std::uint32_t target);
+		void translate(const Instruction& instruction);
+		void assign_registers();
+
+	public:
+		Register_Translator(const Stack_code* stack_code,
+							Register_code* register_code);
+		void Translate();
+};
+
+class Register_Machine {  // runs Register_code (see register_machine.cpp)
+	private:
+		struct Threaded_instruction {
+#ifdef STACK_MACHINE_THREADED
+			const void* handler;  // the label of its opcode in Run()
+#else
+			Register_opcode opcode;
+#endif
+			std::int32_t* x;
+			const std::int32_t* y;
+			const std::int32_t* z;
+			const Threaded_instruction* target;
+		};
+
+		const Register_code* code;
+		std::vector<Threaded_instruction> program;  // (made by the 1st Run())
+		std::vector<std::int32_t> registers;
+		std::size_t stack_size;
+		std::size_t call_depth;
+		std::unique_ptr<std::int32_t[]> stack;
+		std::unique_ptr<const Threaded_instruction*[]> returns;
+
+	public:
+		explicit Register_Machine(const Register_code* register_code,
+								  std::size_t stack_values = DEFAULT_STACK_SIZE,
+								  std::size_t max_calls = DEFAULT_CALL_DEPTH);
+
+		// runs the program from the start, with every memory slot set to 0.
+		// Run_result::instruction is the index of a stack instruction
+		Run_result Run(Input_buffer* input, Output_buffer* output);
+};
+
+#endif
@@ -0,0 +1,206 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <utility>  // move()
+
+#include "semantic_analyzer.h"
+
+Semantic_Analyzer::Semantic_Analyzer(Symbol_table* symbol_table,
+									 Output_buffer* output_file)
+	: symbols(symbol_table), ofs(output_file) {}
+
+/******************************************************************************
+| Analyze() checks that every identifier is declared once per scope, and      |
+| before it is used, in the order the program is written: functions first     |
+| (each one is declared before its own body, so it can call itself), then the |
+| global declarations, then the main body. A function's parameters and        |
+| declarations share one scope, nested in the global one, so they can hide a  |
+| global name but not each other (Rat23S has no declarations inside           |
+| statements, so no other scopes are needed). Every error is written to the   |
+| output file and returned, and the analysis always goes on to the end. Every |
+| name in the AST is given the symbol it refers to (NO_SYMBOL if it is an     |
+| error).                                                                     |
+******************************************************************************/
+std::vector<Diagnostic> Semantic_Analyzer::Analyze(Program_node* program) {
+	for (Function_node* function = program->functions; function;
+		 function = function->next) {
+		function->symbol = declare(function->name, DECLARED_FUNCTION,
+								   SYMBOL_NONE, function->line);
+		symbols->enter_scope();
+		declare_list(function->parameters, DECLARED_PARAMETER);
+		declare_list(function->declarations, DECLARED_VARIABLE);
+		check_statements(function->body);
+		symbols->exit_scope();
+	}
+
+	declare_list(program->declarations, DECLARED_VARIABLE);
+	check_statements(program->statements);
+
+	if (ofs != nullptr) {
+		ofs->flush();
+	}
+	return std::move(diagnostics);
+}
+
+std::uint32_t Semantic_Analyzer::declare(std::string_view name,
+										 Declared_kind kind, Symbol_id type,
+										 int line) {
+	Name_id id = symbols->intern(name);
+	std::uint32_t declared = symbols->declare(id, kind, type, line);
+	if (declared == NO_SYMBOL) {
+		const Symbol& first = symbols->symbol(symbols->lookup(id));
+		report_error(line, "Identifier '" + std::string(name) + "' is already"
+					 " declared in this scope (on line "
+					 + std::to_string(first.line) + ")");
+	}
+	return declared;
+}
+
+void Semantic_Analyzer::declare_list(Declaration_node* list,
+									 Declared_kind kind) {
+	for (; list; list = list->next) {
+		for (Identifier_node* id = list->ids; id; id = id->next) {
+			id->symbol = declare(id->name, kind, list->qualifier, id->line);
+		}
+	}
+}
+
+// an identifier that is assigned, read, or passed to a function
+std::uint32_t Semantic_Analyzer::use_variable(std::string_view name,
+											  int line) {
+	std::uint32_t found = symbols->lookup(symbols->intern(name));
+	if (found == NO_SYMBOL) {
+		report_error(line, "Identifier '" + std::string(name)
+					 + "' is used before it is declared");
+	}
+	else if (symbols->symbol(found).kind == DECLARED_FUNCTION) {
+		report_error(line, "Function '" + std::string(name)
+					 + "' is used as a variable");
+		found = NO_SYMBOL;
+	}
+	return found;
+}
+
+// the name of a function that is called
+std::uint32_t Semantic_Analyzer::use_function(std::string_view name,
+											  int line) {
+	std::uint32_t found = symbols->lookup(symbols->intern(name));
+	if (found == NO_SYMBOL) {
+		report_error(line, "Function '" + std::string(name)
+					 + "' is called before it is declared");
+	}
+	else if (symbols->symbol(found).kind != DECLARED_FUNCTION) {
+		report_error(line, "Identifier '" + std::string(name)
+					 + "' is called but is not a function");
+		found = NO_SYMBOL;
+	}
+	return found;
+}
+
+/******************************************************************************
+| Statements and expressions can be nested as deeply as the syntax analyzer   |
+| allows (see Syntax_Analyzer::set_max_depth()), so they are walked with      |
+| explicit stacks instead of recursion. What is pushed last is checked first, |
+| so the parts of a statement are pushed in reverse (its next statement       |
+| first), which keeps the errors in the order of the program.                 |
+******************************************************************************/
+void Semantic_Analyzer::check_statements(Statement_node* list) {
+	statements.clear();
+	if (list) {
+		statements.push_back(list);
+	}
+	while (!statements.empty()) {
+		Statement_node* statement = statements.back();
+		statements.pop_back();
+		if (statement->next) {
+			statements.push_back(statement->next);
+		}
+
+		switch (statement->kind) {
+			case STATEMENT_COMPOUND:
+				if (statement->body) {
+					statements.push_back(statement->body);
+				}
+				break;
+
+			case STATEMENT_ASSIGN:
+				statement->target_symbol = use_variable(statement->target,
+														statement->line);
+				check_expression(statement->expression);
+				break;
+
+			case STATEMENT_IF:
+			case STATEMENT_WHILE:
+				check_expression(statement->condition.left);
+				check_expression(statement->condition.right);
+				if (statement->else_body) {
+					statements.push_back(statement->else_body);
+				}
+				if (statement->body) {
+					statements.push_back(statement->body);
+				}
+				break;
+
+			case STATEMENT_RETURN:
+			case STATEMENT_PRINT:
+				check_expression(statement->expression);  // (maybe null)
+				break;
+
+			case STATEMENT_SCAN:
+				for (Identifier_node* id = statement->ids; id; id = id->next) {
+					id->symbol = use_variable(id->name, id->line);
+				}
+				break;
+
+			case STATEMENT_ERROR:  // (never in an AST that passed)
+				break;
+		}
+	}
+}
+
+void Semantic_Analyzer::check_expression(Expression_node* expression) {
+	expressions.clear();
+	if (expression) {
+		expressions.push_back(expression);
+	}
+	while (!expressions.empty()) {
+		Expression_node* e = expressions.back();
+		expressions.pop_back();
+		switch (e->kind) {
+			case EXPRESSION_IDENTIFIER:
+				e->symbol = use_variable(e->lexeme, e->line);
+				break;
+
+			case EXPRESSION_CALL:
+				e->symbol = use_function(e->lexeme, e->line);
+				for (Identifier_node* id = e->arguments; id; id = id->next) {
+					id->symbol = use_variable(id->name, id->line);
+				}
+				break;
+
+			case EXPRESSION_NEGATE:
+				expressions.push_back(e->left);
+				break;
+
+			case EXPRESSION_BINARY:
+				expressions.push_back(e->right);
+				expressions.push_back(e->left);
+				break;
+
+			default:  // (literals)
+				break;
+		}
+	}
+}
+
+// writes the error to the output file (the same way as the syntax analyzer,
+// but without a token: it is about a declaration, not the token after it)
+void Semantic_Analyzer::report_error(int line, std::string err_msg) {
+	if (ofs != nullptr) {
+		*ofs << line << ": ERROR - " << err_msg << "\n";
+	}
+
+	Diagnostic diagnostic;
+	diagnostic.line = line;
+	diagnostic.message = std::move(err_msg);
+	diagnostic.token = NO_TOKEN;
+	diagnostics.push_back(std::move(diagnostic));
+}
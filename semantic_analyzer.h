@@ -0,0 +1,43 @@
+#pragma once
+#ifndef SEMANTIC_ANALYZER_H_
+#define SEMANTIC_ANALYZER_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstdint>  // symbols
+#include <string>  // error messages
+#include <string_view>  // identifiers
+#include <vector>  // diagnostics, explicit stacks
+
+#include "ast.h"  // Program_node
+#include "output_buffer.h"  // output file
+#include "symbol_table.h"  // Symbol_table
+#include "syntax_analyzer.h"  // Diagnostic
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Semantic_Analyzer {  // checks the declarations of a program's AST
+	private:
+		Symbol_table* symbols;  // filled in by Analyze()
+		Output_buffer* ofs;  // write to output file (if there is one)
+		std::vector<Diagnostic> diagnostics;  // errors found so far
+		std::vector<Statement_node*> statements;  // (explicit stack)
+		std::vector<Expression_node*> expressions;  // (explicit stack)
+
+		// (these return the symbol, or NO_SYMBOL after an error)
+		std::uint32_t declare(std::string_view name, Declared_kind kind,
+							  Symbol_id type, int line);
+		void declare_list(Declaration_node* list, Declared_kind kind);
+		std::uint32_t use_variable(std::string_view name, int line);
+		std::uint32_t use_function(std::string_view name, int line);
+		void check_statements(Statement_node* list);
+		void check_expression(Expression_node* expression);
+		void report_error(int line, std::string err_msg);
+
+	public:
+		Semantic_Analyzer(Symbol_table* symbol_table,
+						  Output_buffer* output_file);  // constructor
+		// (fills in the symbols of program's names)
+		std::vector<Diagnostic> Analyze(Program_node* program);
+};
+
+#endif
@@ -0,0 +1,250 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include "simd_scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_SCAN_X86 1
+#include <emmintrin.h>  // SSE2 (always available on x86-64)
+#if defined(__GNUC__)
+#define SIMD_SCAN_AVX2 1
+#include <immintrin.h>  // AVX2 (only used if the CPU supports it)
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>  // __popcnt()  _BitScanForward()
+#endif
+
+/* ---------------------------- BIT OPERATIONS ---------------------------- */
+// number of set bits in a byte mask (ie. newlines in a block)
+static inline int count_bits(unsigned mask) {
+#if defined(_MSC_VER)
+	return static_cast<int>(__popcnt(mask));
+#else
+	return __builtin_popcount(mask);
+#endif
+}
+
+// index of the lowest set bit in a non-zero byte mask
+static inline int first_bit(unsigned mask) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// the lexer's whitespaces (see the CLASS_SPACE and CLASS_NEWLINE classes)
+static inline bool is_scan_white_space(char c) {
+	return c == ' ' || c == '\t' || c == '\v' || c == '\r' || c == '\n';
+}
+
+/* ----------------------------- SCALAR KERNELS ----------------------------- */
+static const char* scalar_skip_white_space(const char* p, const char* end,
+										   int* newlines) {
+	int lines = 0;
+	while (p != end && is_scan_white_space(*p)) {
+		lines += (*p == '\n');
+		p++;
+	}
+	*newlines += lines;
+	return p;
+}
+
+static const char* scalar_find_comment_end(const char* p, const char* end,
+										   int* newlines) {
+	int lines = 0;
+	while (p != end) {
+		if (*p == '*' && p + 1 != end && p[1] == ']') {
+			break;
+		}
+		lines += (*p == '\n');
+		p++;
+	}
+	*newlines += lines;
+	return p;
+}
+
+/******************************************************************************
+| The SIMD kernels compare a whole block of bytes (16 for SSE2, 32 for AVX2)  |
+| at once and turn the results into bit masks, with one bit per byte. The     |
+| first byte that stops the scan is the lowest set bit of its mask, and the   |
+| newlines skipped over are counted with a popcount of the newline mask up to |
+| that byte. Blocks that don't stop the scan add their whole newline count.   |
+| The last partial block is finished by the scalar kernels.                   |
+******************************************************************************/
+#ifdef SIMD_SCAN_X86
+static const char* sse2_skip_white_space(const char* p, const char* end,
+										 int* newlines) {
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i vertical_tab = _mm_set1_epi8('\v');
+	const __m128i carriage_return = _mm_set1_epi8('\r');
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	int lines = 0;
+	while (end - p >= 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i is_newline = _mm_cmpeq_epi8(bytes, newline);
+		__m128i is_white_space = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(bytes, space),
+						 _mm_cmpeq_epi8(bytes, tab)),
+			_mm_or_si128(_mm_cmpeq_epi8(bytes, vertical_tab),
+						 _mm_cmpeq_epi8(bytes, carriage_return)));
+		is_white_space = _mm_or_si128(is_white_space, is_newline);
+
+		unsigned other_mask = ~_mm_movemask_epi8(is_white_space) & 0xFFFFu;
+		unsigned newline_mask = _mm_movemask_epi8(is_newline);
+		if (other_mask != 0) {  // a token starts inside this block
+			int stop = first_bit(other_mask);
+			*newlines += lines + count_bits(newline_mask & ((1u << stop) - 1));
+			return p + stop;
+		}
+		lines += count_bits(newline_mask);
+		p += 16;
+	}
+	*newlines += lines;
+	return scalar_skip_white_space(p, end, newlines);
+}
+
+static const char* sse2_find_comment_end(const char* p, const char* end,
+										 int* newlines) {
+	const __m128i star = _mm_set1_epi8('*');
+	const __m128i right_bracket = _mm_set1_epi8(']');
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	int lines = 0;
+	while (end - p >= 17) {  // the ] of a "*]" can be one byte past the block
+		const __m128i* block = reinterpret_cast<const __m128i*>(p);
+		const __m128i* next = reinterpret_cast<const __m128i*>(p + 1);
+		__m128i bytes = _mm_loadu_si128(block);
+		__m128i closes = _mm_and_si128(
+			_mm_cmpeq_epi8(bytes, star),
+			_mm_cmpeq_epi8(_mm_loadu_si128(next), right_bracket));
+
+		unsigned close_mask = _mm_movemask_epi8(closes);
+		unsigned newline_mask =
+			_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline));
+		if (close_mask != 0) {
+			int stop = first_bit(close_mask);
+			*newlines += lines + count_bits(newline_mask & ((1u << stop) - 1));
+			return p + stop;
+		}
+		lines += count_bits(newline_mask);
+		p += 16;
+	}
+	*newlines += lines;
+	return scalar_find_comment_end(p, end, newlines);
+}
+#endif
+
+#ifdef SIMD_SCAN_AVX2
+__attribute__((target("avx2,popcnt")))
+static const char* avx2_skip_white_space(const char* p, const char* end,
+										 int* newlines) {
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i vertical_tab = _mm256_set1_epi8('\v');
+	const __m256i carriage_return = _mm256_set1_epi8('\r');
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	int lines = 0;
+	while (end - p >= 32) {
+		__m256i bytes =
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		__m256i is_newline = _mm256_cmpeq_epi8(bytes, newline);
+		__m256i is_white_space = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(bytes, space),
+							_mm256_cmpeq_epi8(bytes, tab)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(bytes, vertical_tab),
+							_mm256_cmpeq_epi8(bytes, carriage_return)));
+		is_white_space = _mm256_or_si256(is_white_space, is_newline);
+
+		unsigned other_mask = ~static_cast<unsigned>(
+			_mm256_movemask_epi8(is_white_space));
+		unsigned newline_mask =
+			static_cast<unsigned>(_mm256_movemask_epi8(is_newline));
+		if (other_mask != 0) {  // a token starts inside this block
+			int stop = __builtin_ctz(other_mask);
+			unsigned before = (stop == 0) ? 0u : (~0u >> (32 - stop));
+			*newlines += lines + __builtin_popcount(newline_mask & before);
+			return p + stop;
+		}
+		lines += __builtin_popcount(newline_mask);
+		p += 32;
+	}
+	*newlines += lines;
+	return sse2_skip_white_space(p, end, newlines);
+}
+
+__attribute__((target("avx2,popcnt")))
+static const char* avx2_find_comment_end(const char* p, const char* end,
+										 int* newlines) {
+	const __m256i star = _mm256_set1_epi8('*');
+	const __m256i right_bracket = _mm256_set1_epi8(']');
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	int lines = 0;
+	while (end - p >= 33) {  // the ] of a "*]" can be one byte past the block
+		const __m256i* block = reinterpret_cast<const __m256i*>(p);
+		const __m256i* next = reinterpret_cast<const __m256i*>(p + 1);
+		__m256i bytes = _mm256_loadu_si256(block);
+		__m256i closes = _mm256_and_si256(
+			_mm256_cmpeq_epi8(bytes, star),
+			_mm256_cmpeq_epi8(_mm256_loadu_si256(next), right_bracket));
+
+		unsigned close_mask =
+			static_cast<unsigned>(_mm256_movemask_epi8(closes));
+		unsigned newline_mask = static_cast<unsigned>(
+			_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+		if (close_mask != 0) {
+			int stop = __builtin_ctz(close_mask);
+			unsigned before = (stop == 0) ? 0u : (~0u >> (32 - stop));
+			*newlines += lines + __builtin_popcount(newline_mask & before);
+			return p + stop;
+		}
+		lines += __builtin_popcount(newline_mask);
+		p += 32;
+	}
+	*newlines += lines;
+	return sse2_find_comment_end(p, end, newlines);
+}
+#endif
+
+/******************************************************************************
+| best_scan_kernels() picks the widest kernels that the CPU supports the      |
+| first time it is called: AVX2 if the CPU reports it at runtime, then SSE2   |
+| (part of every x86-64 CPU), and the scalar kernels everywhere else.         |
+******************************************************************************/
+static const Scan_kernels SCALAR_KERNELS = {
+	"scalar", scalar_skip_white_space, scalar_find_comment_end
+};
+
+static const Scan_kernels& choose_scan_kernels() {
+#ifdef SIMD_SCAN_AVX2
+	static const Scan_kernels AVX2_KERNELS = {
+		"AVX2", avx2_skip_white_space, avx2_find_comment_end
+	};
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+		return AVX2_KERNELS;
+	}
+#endif
+#ifdef SIMD_SCAN_X86
+	static const Scan_kernels SSE2_KERNELS = {
+		"SSE2", sse2_skip_white_space, sse2_find_comment_end
+	};
+	return SSE2_KERNELS;
+#else
+	return SCALAR_KERNELS;
+#endif
+}
+
+const Scan_kernels& best_scan_kernels() {
+	static const Scan_kernels& best = choose_scan_kernels();
+	return best;
+}
+
+const Scan_kernels& scalar_scan_kernels() {
+	return SCALAR_KERNELS;
+}
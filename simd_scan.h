@@ -0,0 +1,26 @@
+#pragma once
+#ifndef SIMD_SCAN_H_
+#define SIMD_SCAN_H_
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+// kernels that skip over large runs of bytes the lexer doesn't tokenize.
+// both kernels scan [p, end) and add the number of newlines that they skip
+// over to *newlines
+struct Scan_kernels {
+	const char* name;  // "scalar", "SSE2", or "AVX2"
+
+	// returns the first byte that isn't a whitespace (or end)
+	const char* (*skip_white_space)(const char* p, const char* end,
+									int* newlines);
+
+	// returns the * of the first "*]" (or end, if the comment never closes)
+	const char* (*find_comment_end)(const char* p, const char* end,
+									int* newlines);
+};
+
+
+/* -------------------------- FUNCTION PROTOTYPES -------------------------- */
+const Scan_kernels& best_scan_kernels();  // fastest kernels this CPU runs
+const Scan_kernels& scalar_scan_kernels();  // portable byte-at-a-time kernels
+
+#endif
@@ -0,0 +1,119 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <fstream>  // fallback file reader
+#include <iterator>  // istreambuf_iterator
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>  // open()
+#include <sys/mman.h>  // mmap()  munmap()
+#include <sys/stat.h>  // fstat()
+#include <unistd.h>  // close()
+#endif
+
+#include "source_buffer.h"
+
+/******************************************************************************
+| open() makes the entire input file available as one contiguous buffer. When |
+| possible, the file is memory-mapped, so the lexer reads straight out of the |
+| page cache. Files that can't be mapped (empty files, pipes, or platforms    |
+| without mmap) are read into memory once instead. Returns false if the file  |
+| couldn't be opened.                                                         |
+******************************************************************************/
+bool Source_buffer::open(const std::string& file_name) {
+	release();
+	if (!map_file(file_name) && !read_file(file_name)) {
+		return false;
+	}
+	skip_BOM_encoding();
+	return true;
+}
+
+Source_buffer::~Source_buffer() {
+	release();
+}
+
+// first character of the text (BOM encoding is never included)
+const char* Source_buffer::begin() const {
+	return data;
+}
+
+// one past the last character of the text
+const char* Source_buffer::end() const {
+	return data + size;
+}
+
+/*****************************************************************************
+| map_file() memory-maps a regular, non-empty file. It returns false without |
+| printing anything if mapping isn't possible, so that open() can fall back  |
+| to read_file().                                                            |
+*****************************************************************************/
+bool Source_buffer::map_file(const std::string& file_name) {
+#ifdef _WIN32
+	(void)file_name;
+	return false;  // no mmap -> always read the file into memory
+#else
+	int fd = ::open(file_name.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* region = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);  // the mapping stays valid after the descriptor is closed
+	if (region == MAP_FAILED) {
+		return false;
+	}
+	madvise(region, info.st_size, MADV_SEQUENTIAL);  // lexer reads front-to-back
+
+	mapping = region;
+	mapping_size = info.st_size;
+	data = static_cast<const char*>(region);
+	size = mapping_size;
+	return true;
+#endif
+}
+
+// reads the whole file into storage (binary mode, so nothing is translated)
+bool Source_buffer::read_file(const std::string& file_name) {
+	std::ifstream ifs(file_name, std::ios::binary);
+	if (!ifs.is_open()) {
+		return false;
+	}
+	storage.assign(std::istreambuf_iterator<char>(ifs),
+				   std::istreambuf_iterator<char>());
+	data = storage.data();
+	size = storage.size();
+	return true;
+}
+
+/******************************************************************************
+| A UTF-8 file's first 3 bytes may be a BOM encoding. Those bytes aren't part |
+| of the program's text, so the buffer is moved past them (if present).       |
+******************************************************************************/
+void Source_buffer::skip_BOM_encoding() {
+	if (size >= 3 && static_cast<unsigned char>(data[0]) == 0xEF
+		&& static_cast<unsigned char>(data[1]) == 0xBB
+		&& static_cast<unsigned char>(data[2]) == 0xBF) {
+		data += 3;
+		size -= 3;
+	}
+}
+
+// unmaps/frees the current file (if any)
+void Source_buffer::release() {
+#ifndef _WIN32
+	if (mapping != nullptr) {
+		munmap(mapping, mapping_size);
+	}
+#endif
+	mapping = nullptr;
+	mapping_size = 0;
+	storage.clear();
+	data = nullptr;
+	size = 0;
+}
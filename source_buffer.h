@@ -0,0 +1,36 @@
+#pragma once
+#ifndef SOURCE_BUFFER_H_
+#define SOURCE_BUFFER_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <string>  // file name, fallback storage
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Source_buffer {  // contiguous, read-only view of an entire input file
+	private:
+		const char* data = nullptr;  // first byte of the text (after any BOM)
+		std::size_t size = 0;  // number of bytes of text
+
+		void* mapping = nullptr;  // memory-mapped file (if mmap was used)
+		std::size_t mapping_size = 0;
+		std::string storage;  // file contents (if the file couldn't be mapped)
+
+		bool map_file(const std::string& file_name);
+		bool read_file(const std::string& file_name);
+		void skip_BOM_encoding();
+		void release();
+
+	public:
+		Source_buffer() = default;
+		~Source_buffer();
+		Source_buffer(const Source_buffer&) = delete;
+		Source_buffer& operator=(const Source_buffer&) = delete;
+
+		bool open(const std::string& file_name);  // false if file can't be read
+		const char* begin() const;  // first character of the text
+		const char* end() const;  // one past the last character of the text
+};
+
+#endif
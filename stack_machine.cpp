@@ -0,0 +1,246 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <algorithm>  // fill()
+
+#include "stack_machine.h"
+
+// (the opcode of the instruction after the last one, which ends the program)
+const Opcode OP_END = static_cast<Opcode>(OPCODE_COUNT);
+
+Stack_Machine::Stack_Machine(const Stack_code* stack_code,
+							 std::size_t stack_values, std::size_t max_calls)
+	: code(stack_code), memory(stack_code->memory_size),
+	  stack_size(stack_values), call_depth(max_calls),
+	  stack(new std::int32_t[stack_values]),
+	  returns(new const Threaded_instruction*[max_calls]) {}
+
+const std::vector<std::int32_t>& Stack_Machine::get_memory() const {
+	return memory;
+}
+
+/******************************************************************************
+| Run() is direct-threaded: the first time it runs, the code is translated    |
+| into Threaded_instructions that hold the address of their opcode's handler  |
+| (a label inside Run()), and every handler ends by jumping straight to the   |
+| next instruction's handler, so there is no loop or switch between two       |
+| instructions, and every handler's indirect jump is predicted on its own.    |
+| The operands are resolved by the translation too: a memory slot becomes a   |
+| pointer to the value, and a jump target a pointer to the instruction.       |
+|                                                                             |
+| The operand stack and the call stack have a fixed size, and are only        |
+| checked where they grow or shrink (a full stack ends the program with an    |
+| error instead of growing). Values are 32 bits, and arithmetic wraps around  |
+| like the machine's (the overflows are done unsigned). A compiler without    |
+| computed goto gets the same handlers as the cases of a switch instead.      |
+******************************************************************************/
+#ifdef STACK_MACHINE_THREADED
+#define OPCODE(name) op_##name:
+#define DISPATCH() goto *ip->handler
+#else
+#define OPCODE(name) case OP_##name:
+#define DISPATCH() continue
+#endif
+
+// (executed counts the instructions that were finished)
+#define GO(next_instruction) { \
+	ip = (next_instruction); \
+	executed++; \
+	DISPATCH(); \
+}
+#define NEXT() GO(ip + 1)
+
+#define ARITHMETIC(name, operator) OPCODE(name) \
+	if (sp - stack_begin < 2) goto underflow; \
+	sp--; \
+	sp[-1] = static_cast<std::int32_t>(static_cast<std::uint32_t>(sp[-1]) \
+		operator static_cast<std::uint32_t>(sp[0])); \
+	NEXT();
+
+#define COMPARISON(name, operator) OPCODE(name) \
+	if (sp - stack_begin < 2) goto underflow; \
+	sp--; \
+	sp[-1] = (sp[-1] operator sp[0]) ? 1 : 0; \
+	NEXT();
+
+Run_result Stack_Machine::Run(Input_buffer* input, Output_buffer* output) {
+#ifdef STACK_MACHINE_THREADED
+	static const void* const HANDLERS[OPCODE_COUNT + 1] = {
+		&&op_PUSHI, &&op_PUSHM, &&op_POPM, &&op_SOUT, &&op_SIN, &&op_ADD,
+		&&op_SUB, &&op_MUL, &&op_DIV, &&op_GRT, &&op_LES, &&op_EQU, &&op_NEQ,
+		&&op_GEQ, &&op_LEQ, &&op_JUMPZ, &&op_JUMP, &&op_LABEL, &&op_CALL,
+		&&op_RETURN, &&op_HALT, &&op_END
+	};
+#endif
+	if (program.empty()) {
+		std::size_t count = code->instructions.size();
+		program.resize(count + 1);
+		for (std::size_t i = 0; i <= count; i++) {
+			Instruction instruction = (i < count) ? code->instructions[i]
+												  : Instruction{ OP_END, 0 };
+			Threaded_instruction& threaded = program[i];
+#ifdef STACK_MACHINE_THREADED
+			threaded.handler = HANDLERS[instruction.opcode];
+#else
+			threaded.opcode = instruction.opcode;
+#endif
+			switch (instruction.opcode) {
+				case OP_PUSHM:
+				case OP_POPM:
+					threaded.slot = memory.data() + instruction.operand;
+					break;
+				case OP_JUMPZ:
+				case OP_JUMP:
+				case OP_CALL:
+					threaded.target = program.data() + instruction.operand;
+					break;
+				default:
+					threaded.value = instruction.operand;
+					break;
+			}
+		}
+	}
+	std::fill(memory.begin(), memory.end(), 0);
+
+	Run_result result;
+	const Threaded_instruction* ip = program.data();
+	std::int32_t* const stack_begin = stack.get();
+	std::int32_t* const stack_end = stack_begin + stack_size;
+	std::int32_t* sp = stack_begin;  // (the next free value)
+	const Threaded_instruction** const returns_begin = returns.get();
+	const Threaded_instruction** const returns_end = returns_begin
+													 + call_depth;
+	const Threaded_instruction** rp = returns_begin;
+	std::uint64_t executed = 0;
+
+#ifdef STACK_MACHINE_THREADED
+	DISPATCH();
+#else
+	for (;;) switch (static_cast<int>(ip->opcode)) {  // (OP_END isn't one)
+#endif
+	OPCODE(PUSHI)
+		if (sp == stack_end) goto overflow;
+		*sp++ = ip->value;
+		NEXT();
+
+	OPCODE(PUSHM)
+		if (sp == stack_end) goto overflow;
+		*sp++ = *ip->slot;
+		NEXT();
+
+	OPCODE(POPM)
+		if (sp == stack_begin) goto underflow;
+		*ip->slot = *--sp;
+		NEXT();
+
+	OPCODE(SOUT)
+		if (sp == stack_begin) goto underflow;
+		*output << static_cast<int>(*--sp) << '\n';
+		NEXT();
+
+	OPCODE(SIN)
+		if (sp == stack_end) goto overflow;
+		if (!input->buffered()) {
+			output->flush();  // (put() before get() shows up first)
+		}
+		if (!input->read_integer(*sp)) {
+			result.status = RUN_BAD_INPUT;
+			goto failed;
+		}
+		sp++;
+		NEXT();
+
+	ARITHMETIC(ADD, +)
+	ARITHMETIC(SUB, -)
+	ARITHMETIC(MUL, *)
+
+	OPCODE(DIV)
+		if (sp - stack_begin < 2) goto underflow;
+		if (sp[-1] == 0) {
+			result.status = RUN_DIVIDE_BY_ZERO;
+			goto failed;
+		}
+		sp--;
+		if (sp[0] == -1) {  // (the lowest value / -1 overflows)
+			sp[-1] = static_cast<std::int32_t>(
+				0u - static_cast<std::uint32_t>(sp[-1]));
+		}
+		else {
+			sp[-1] = sp[-1] / sp[0];
+		}
+		NEXT();
+
+	COMPARISON(GRT, >)
+	COMPARISON(LES, <)
+	COMPARISON(EQU, ==)
+	COMPARISON(NEQ, !=)
+	COMPARISON(GEQ, >=)
+	COMPARISON(LEQ, <=)
+
+	OPCODE(JUMPZ)
+		if (sp == stack_begin) goto underflow;
+		if (*--sp == 0) GO(ip->target);
+		NEXT();
+
+	OPCODE(JUMP)
+		GO(ip->target);
+
+	OPCODE(LABEL)
+		NEXT();
+
+	OPCODE(CALL)
+		if (rp == returns_end) {
+			result.status = RUN_CALL_OVERFLOW;
+			goto failed;
+		}
+		*rp++ = ip + 1;
+		GO(ip->target);
+
+	OPCODE(RETURN)
+		if (rp == returns_begin) {
+			result.status = RUN_RETURN_UNDERFLOW;
+			goto failed;
+		}
+		GO(*--rp);
+
+	OPCODE(HALT)
+		executed++;
+		goto finished;
+
+	OPCODE(END)
+		goto finished;
+#ifndef STACK_MACHINE_THREADED
+	default:
+		goto finished;
+	}
+#endif
+
+overflow:
+	result.status = RUN_STACK_OVERFLOW;
+	goto failed;
+underflow:
+	result.status = RUN_STACK_UNDERFLOW;
+failed:
+	result.instruction = static_cast<std::uint32_t>(ip - program.data());
+finished:
+	result.executed = executed;
+	output->flush();
+	return result;
+}
+
+#undef OPCODE
+#undef DISPATCH
+#undef GO
+#undef NEXT
+#undef ARITHMETIC
+#undef COMPARISON
+
+const char* run_status_message(Run_status status) {
+	switch (status) {
+		case RUN_FINISHED: return "The program finished";
+		case RUN_DIVIDE_BY_ZERO: return "Division by zero";
+		case RUN_BAD_INPUT: return "get() didn't find an integer to read";
+		case RUN_STACK_OVERFLOW: return "The operand stack is full";
+		case RUN_STACK_UNDERFLOW: return "Popped an empty operand stack";
+		case RUN_CALL_OVERFLOW: return "Calls are nested too deeply";
+		default: return "RETURN without a CALL";  // RUN_RETURN_UNDERFLOW
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef STACK_MACHINE_H_
+#define STACK_MACHINE_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <cstdint>  // values, counters
+#include <memory>  // fixed-size stacks
+#include <vector>  // threaded code, memory
+
+#include "code_generator.h"  // Stack_code, Opcode
+#include "input_buffer.h"  // get()
+#include "output_buffer.h"  // put()
+
+#if defined(__GNUC__)
+#define STACK_MACHINE_THREADED 1  // computed goto (a GCC/Clang extension)
+#endif
+
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+const std::size_t DEFAULT_STACK_SIZE = 1 << 20;  // operand stack (values)
+const std::size_t DEFAULT_CALL_DEPTH = 1 << 16;  // nested calls
+
+enum Run_status : std::uint8_t {
+	RUN_FINISHED,  // ran past the last instruction, or HALT
+	RUN_DIVIDE_BY_ZERO,
+	RUN_BAD_INPUT,  // get() didn't find an integer
+	RUN_STACK_OVERFLOW,  // the operand stack is full
+	RUN_STACK_UNDERFLOW,  // popped an empty stack (not generated code)
+	RUN_CALL_OVERFLOW,  // calls nested deeper than the call stack
+	RUN_RETURN_UNDERFLOW  // RETURN without a CALL (not generated code)
+};
+
+struct Run_result {
+	Run_status status = RUN_FINISHED;
+	std::uint32_t instruction = 0;  // index of the one that failed (if any)
+	std::uint64_t executed = 0;  // number of instructions run
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Stack_Machine {  // runs Stack_code (see stack_machine.cpp)
+	private:
+		struct Threaded_instruction {
+#ifdef STACK_MACHINE_THREADED
+			const void* handler;  // the label of its opcode in Run()
+#else
+			Opcode opcode;
+#endif
+			union {
+				std::int32_t value;  // PUSHI
+				std::int32_t* slot;  // PUSHM, POPM
+				const Threaded_instruction* target;  // JUMPZ, JUMP, CALL
+			};
+		};
+
+		const Stack_code* code;
+		std::vector<Threaded_instruction> program;  // (made by the 1st Run())
+		std::vector<std::int32_t> memory;
+		std::size_t stack_size;
+		std::size_t call_depth;
+		std::unique_ptr<std::int32_t[]> stack;
+		std::unique_ptr<const Threaded_instruction*[]> returns;
+
+	public:
+		// (the code has to be valid: generated, or checked by load_code())
+		explicit Stack_Machine(const Stack_code* stack_code,
+							   std::size_t stack_values = DEFAULT_STACK_SIZE,
+							   std::size_t max_calls = DEFAULT_CALL_DEPTH);
+
+		// runs the program from the start, with every memory slot set to 0
+		Run_result Run(Input_buffer* input, Output_buffer* output);
+		const std::vector<std::int32_t>& get_memory() const;  // after Run()
+};
+
+
+/* -------------------------- FUNCTION PROTOTYPES -------------------------- */
+const char* run_status_message(Run_status status);  // ie. for an error
+
+#endif
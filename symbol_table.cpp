@@ -0,0 +1,153 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include "symbol_table.h"
+
+/******************************************************************************
+| Identifiers are interned: each different name (Rat23S isn't case sensitive, |
+| so 'Total' and 'TOTAL' are the same name) gets a Name_id, the index of its  |
+| folded text in characters. The names are found through a flat array of      |
+| 8-byte slots (a hash of the folded name, and its id), by probing the slots  |
+| after its hash (linear probing), so a lookup usually reads a single cache   |
+| line, and the text is only compared when the hashes match. There are at     |
+| least twice as many slots as names, so the probes stay short.               |
+|                                                                             |
+| A scope doesn't have a table of its own: each name has one innermost symbol |
+| (the declaration that is visible), and a symbol remembers the one it hides. |
+| Declaring and looking up a name are then O(1) no matter how many scopes are |
+| open, and closing a scope puts back what its symbols hid.                   |
+******************************************************************************/
+Symbol_table::Symbol_table() {
+	slots.assign(1024, Name_slot{ 0, NO_SYMBOL });
+	scope_starts.push_back(0);  // (global)
+}
+
+static char fold(char c) {
+	return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+// FNV-1a of the folded name
+static std::uint32_t name_hash(std::string_view identifier) {
+	std::uint32_t hash = 2166136261u;
+	for (char c : identifier) {
+		hash = (hash ^ static_cast<unsigned char>(fold(c))) * 16777619u;
+	}
+	return hash;
+}
+
+Name_id Symbol_table::intern(std::string_view identifier) {
+	std::uint32_t hash = name_hash(identifier);
+	std::size_t mask = slots.size() - 1;
+	std::size_t i = hash & mask;
+	for (; slots[i].name != NO_SYMBOL; i = (i + 1) & mask) {
+		if (slots[i].hash != hash) {
+			continue;
+		}
+		std::string_view known = name(slots[i].name);
+		if (known.size() != identifier.size()) {
+			continue;
+		}
+		std::size_t c = 0;
+		while (c < known.size() && known[c] == fold(identifier[c])) {
+			c++;
+		}
+		if (c == known.size()) {
+			return slots[i].name;
+		}
+	}
+
+	Name_id id = static_cast<Name_id>(names.size());
+	Name added;
+	added.start = static_cast<std::uint32_t>(characters.size());
+	added.length = static_cast<std::uint32_t>(identifier.size());
+	added.innermost = NO_SYMBOL;
+	names.push_back(added);
+	for (char c : identifier) {
+		characters.push_back(fold(c));
+	}
+	slots[i].hash = hash;
+	slots[i].name = id;
+	if (2 * names.size() > slots.size()) {
+		grow();
+	}
+	return id;
+}
+
+// (the hashes are kept, so the names are never hashed again)
+void Symbol_table::grow() {
+	std::vector<Name_slot> old;
+	old.swap(slots);
+	slots.assign(2 * old.size(), Name_slot{ 0, NO_SYMBOL });
+	std::size_t mask = slots.size() - 1;
+	for (const Name_slot& slot : old) {
+		if (slot.name != NO_SYMBOL) {
+			std::size_t i = slot.hash & mask;
+			while (slots[i].name != NO_SYMBOL) {
+				i = (i + 1) & mask;
+			}
+			slots[i] = slot;
+		}
+	}
+}
+
+std::string_view Symbol_table::name(Name_id name) const {
+	return std::string_view(characters.data() + names[name].start,
+							names[name].length);
+}
+
+std::size_t Symbol_table::name_count() const {
+	return names.size();
+}
+
+void Symbol_table::enter_scope() {
+	scope_starts.push_back(open.size());
+}
+
+void Symbol_table::exit_scope() {
+	while (open.size() > scope_starts.back()) {
+		const Symbol& hidden = symbols[open.back()];
+		names[hidden.name].innermost = hidden.shadowed;
+		open.pop_back();
+	}
+	scope_starts.pop_back();
+}
+
+std::uint32_t Symbol_table::scope_depth() const {
+	return static_cast<std::uint32_t>(scope_starts.size() - 1);
+}
+
+std::uint32_t Symbol_table::declare(Name_id name, Declared_kind kind,
+									Symbol_id type, int line) {
+	std::uint32_t visible = names[name].innermost;
+	if (visible != NO_SYMBOL && symbols[visible].scope == scope_depth()) {
+		return NO_SYMBOL;
+	}
+
+	Symbol symbol;
+	symbol.name = name;
+	symbol.kind = kind;
+	symbol.type = type;
+	symbol.scope = scope_depth();
+	symbol.address = (kind == DECLARED_FUNCTION) ? 0 : variable_count++;
+	symbol.line = line;
+	symbol.shadowed = visible;
+	std::uint32_t index = static_cast<std::uint32_t>(symbols.size());
+	symbols.push_back(symbol);
+	open.push_back(index);
+	names[name].innermost = index;
+	return index;
+}
+
+std::uint32_t Symbol_table::lookup(Name_id name) const {
+	return names[name].innermost;
+}
+
+const Symbol& Symbol_table::symbol(std::uint32_t index) const {
+	return symbols[index];
+}
+
+std::size_t Symbol_table::symbol_count() const {
+	return symbols.size();
+}
+
+std::uint32_t Symbol_table::get_variable_count() const {
+	return variable_count;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef SYMBOL_TABLE_H_
+#define SYMBOL_TABLE_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <cstddef>  // size_t
+#include <cstdint>  // ids, hashes
+#include <string_view>  // identifiers
+#include <vector>  // slots, names, symbols
+
+#include "lexer.h"  // Symbol_id (types)
+
+
+/* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
+typedef std::uint32_t Name_id;  // an interned identifier (see intern())
+const std::uint32_t NO_SYMBOL = UINT32_MAX;  // (index into the symbols)
+
+enum Declared_kind : std::uint8_t {
+	DECLARED_VARIABLE,  // in a <Declaration>
+	DECLARED_PARAMETER,  // in a function's <Parameter>
+	DECLARED_FUNCTION
+};
+
+// one declaration of an identifier
+struct Symbol {
+	Name_id name;
+	Declared_kind kind;
+	Symbol_id type;  // KEYWORD_INT/BOOL/REAL (SYMBOL_NONE for a function)
+	std::uint32_t scope;  // depth of its scope (0 -> global)
+	std::uint32_t address;  // (variables and parameters) its memory slot
+	int line;  // where it was declared
+	std::uint32_t shadowed;  // the one it hides in an outer scope (or none)
+};
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Symbol_table {  // identifiers, and what each one is declared as
+	private:
+		struct Name_slot {
+			std::uint32_t hash;  // (of the folded name)
+			Name_id name;  // NO_SYMBOL -> empty
+		};
+
+		struct Name {  // (by Name_id)
+			std::uint32_t start;  // its first character in characters
+			std::uint32_t length;
+			std::uint32_t innermost;  // its visible symbol (or none)
+		};
+
+		std::vector<Name_slot> slots;  // open addressing (power of 2 slots)
+		std::vector<char> characters;  // every folded name, one after another
+		std::vector<Name> names;
+		std::vector<Symbol> symbols;  // every declaration, in order
+		std::vector<std::uint32_t> open;  // symbols of the open scopes
+		std::vector<std::size_t> scope_starts;  // where each scope is in open
+		std::uint32_t variable_count = 0;  // addresses given out
+
+		void grow();  // twice as many slots
+
+	public:
+		Symbol_table();  // the global scope is open
+
+		Name_id intern(std::string_view identifier);  // case-insensitive
+		std::string_view name(Name_id name) const;  // (folded to lowercase)
+		std::size_t name_count() const;
+
+		void enter_scope();
+		void exit_scope();  // (its symbols stay in symbol())
+		std::uint32_t scope_depth() const;  // 0 -> global
+
+		// the new symbol, or NO_SYMBOL if the name is already declared in the
+		// current scope (lookup() finds that declaration)
+		std::uint32_t declare(Name_id name, Declared_kind kind, Symbol_id type,
+							  int line);
+		std::uint32_t lookup(Name_id name) const;  // NO_SYMBOL if undeclared
+		const Symbol& symbol(std::uint32_t index) const;
+		std::size_t symbol_count() const;
+		std::uint32_t get_variable_count() const;  // (addresses 0 .. count-1)
+};
+
+#endif
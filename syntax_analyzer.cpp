@@ -1,65 +1,507 @@
 /* ------------------------------- LIBRARIES ------------------------------- */
-#include <fstream>  // input file
-#include <cstring>  // tolower
-#include <string>  // substring
+#include <cstdint>  // uint8_t
+#include <string>
 
 #include "lexer.h"
 #include "syntax_analyzer.h"
 
+/* ------------------------------ THE GRAMMAR ------------------------------ */
+// the nonterminals of the Rat23S grammar (one per production function). they
+// are numbered after the Symbol_ids, so a grammar symbol is either one
+enum Nonterminal : std::uint8_t {
+	NT_RAT23S = 64,
+	NT_OPT_FUNCTION_DEFINITIONS,
+	NT_FUNCTION_DEFINITIONS_START,
+	NT_FUNCTION_DEFINITIONS_CONT,
+	NT_FUNCTION,
+	NT_OPT_PARAMETER_LIST,
+	NT_PARAMETER_LIST_START,
+	NT_PARAMETER_LIST_CONT,
+	NT_PARAMETER,
+	NT_QUALIFIER,
+	NT_BODY,
+	NT_OPT_DECLARATION_LIST,
+	NT_DECLARATION_LIST_START,
+	NT_DECLARATION_LIST_CONT,
+	NT_DECLARATION,
+	NT_IDS_START,
+	NT_IDS_CONT,
+	NT_STATEMENT_LIST_START,
+	NT_STATEMENT_LIST_CONT,
+	NT_STATEMENT,
+	NT_COMPOUND,
+	NT_ASSIGN,
+	NT_IF_START,
+	NT_IF_CONT,
+	NT_RETURN_START,
+	NT_RETURN_CONT,
+	NT_PRINT,
+	NT_SCAN,
+	NT_WHILE,
+	NT_CONDITION,
+	NT_RELOP,
+	NT_EXPRESSION_START,
+	NT_EXPRESSION_CONT,
+	NT_TERM_START,
+	NT_TERM_CONT,
+	NT_FACTOR,
+	NT_PRIMARY_START,
+	NT_PRIMARY_CONT,
+	NT_END
+};
+static constexpr int NONTERMINAL_COUNT = NT_END - NT_RAT23S;
+
+static constexpr bool is_terminal(std::uint8_t grammar_symbol) {
+	return grammar_symbol < NT_RAT23S;
+}
+
+// one alternative of a nonterminal. the right-hand side ends at the first
+// SYMBOL_NONE, so an alternative without any symbols is <Empty>
+struct Grammar_rule {
+	Nonterminal lhs;
+	std::uint8_t rhs[8];
+};
+
+static constexpr Grammar_rule GRAMMAR[] = {
+	{ NT_RAT23S, { NT_OPT_FUNCTION_DEFINITIONS, SEPARATOR_HASH,
+				   NT_OPT_DECLARATION_LIST, SEPARATOR_HASH,
+				   NT_STATEMENT_LIST_START, SYMBOL_EOF } },
+	{ NT_OPT_FUNCTION_DEFINITIONS, { NT_FUNCTION_DEFINITIONS_START } },
+	{ NT_OPT_FUNCTION_DEFINITIONS, {} },
+	{ NT_FUNCTION_DEFINITIONS_START, { NT_FUNCTION,
+									   NT_FUNCTION_DEFINITIONS_CONT } },
+	{ NT_FUNCTION_DEFINITIONS_CONT, { NT_FUNCTION_DEFINITIONS_START } },
+	{ NT_FUNCTION_DEFINITIONS_CONT, {} },
+	{ NT_FUNCTION, { KEYWORD_FUNCTION, SYMBOL_IDENTIFIER, SEPARATOR_LEFT_PAREN,
+					 NT_OPT_PARAMETER_LIST, SEPARATOR_RIGHT_PAREN,
+					 NT_OPT_DECLARATION_LIST, NT_BODY } },
+	{ NT_OPT_PARAMETER_LIST, { NT_PARAMETER_LIST_START } },
+	{ NT_OPT_PARAMETER_LIST, {} },
+	{ NT_PARAMETER_LIST_START, { NT_PARAMETER, NT_PARAMETER_LIST_CONT } },
+	{ NT_PARAMETER_LIST_CONT, { SEPARATOR_COMMA, NT_PARAMETER_LIST_START } },
+	{ NT_PARAMETER_LIST_CONT, {} },
+	{ NT_PARAMETER, { NT_IDS_START, NT_QUALIFIER } },
+	{ NT_QUALIFIER, { KEYWORD_INT } },
+	{ NT_QUALIFIER, { KEYWORD_BOOL } },
+	{ NT_QUALIFIER, { KEYWORD_REAL } },
+	{ NT_BODY, { SEPARATOR_LEFT_BRACE, NT_STATEMENT_LIST_START,
+				 SEPARATOR_RIGHT_BRACE } },
+	{ NT_OPT_DECLARATION_LIST, { NT_DECLARATION_LIST_START } },
+	{ NT_OPT_DECLARATION_LIST, {} },
+	{ NT_DECLARATION_LIST_START, { NT_DECLARATION, SEPARATOR_SEMICOLON,
+								   NT_DECLARATION_LIST_CONT } },
+	{ NT_DECLARATION_LIST_CONT, { NT_DECLARATION_LIST_START } },
+	{ NT_DECLARATION_LIST_CONT, {} },
+	{ NT_DECLARATION, { NT_QUALIFIER, NT_IDS_START } },
+	{ NT_IDS_START, { SYMBOL_IDENTIFIER, NT_IDS_CONT } },
+	{ NT_IDS_CONT, { SEPARATOR_COMMA, NT_IDS_START } },
+	{ NT_IDS_CONT, {} },
+	{ NT_STATEMENT_LIST_START, { NT_STATEMENT, NT_STATEMENT_LIST_CONT } },
+	{ NT_STATEMENT_LIST_CONT, { NT_STATEMENT_LIST_START } },
+	{ NT_STATEMENT_LIST_CONT, {} },
+	{ NT_STATEMENT, { NT_COMPOUND } },
+	{ NT_STATEMENT, { NT_ASSIGN } },
+	{ NT_STATEMENT, { NT_IF_START } },
+	{ NT_STATEMENT, { NT_RETURN_START } },
+	{ NT_STATEMENT, { NT_PRINT } },
+	{ NT_STATEMENT, { NT_SCAN } },
+	{ NT_STATEMENT, { NT_WHILE } },
+	{ NT_COMPOUND, { SEPARATOR_LEFT_BRACE, NT_STATEMENT_LIST_START,
+					 SEPARATOR_RIGHT_BRACE } },
+	{ NT_ASSIGN, { SYMBOL_IDENTIFIER, OPERATOR_ASSIGN, NT_EXPRESSION_START,
+				   SEPARATOR_SEMICOLON } },
+	{ NT_IF_START, { KEYWORD_IF, SEPARATOR_LEFT_PAREN, NT_CONDITION,
+					 SEPARATOR_RIGHT_PAREN, NT_STATEMENT, NT_IF_CONT } },
+	{ NT_IF_CONT, { KEYWORD_ELSE, NT_STATEMENT, KEYWORD_FI } },
+	{ NT_IF_CONT, { KEYWORD_FI } },
+	{ NT_RETURN_START, { KEYWORD_RETURN, NT_RETURN_CONT } },
+	{ NT_RETURN_CONT, { NT_EXPRESSION_START, SEPARATOR_SEMICOLON } },
+	{ NT_RETURN_CONT, { SEPARATOR_SEMICOLON } },
+	{ NT_PRINT, { KEYWORD_PUT, SEPARATOR_LEFT_PAREN, NT_EXPRESSION_START,
+				  SEPARATOR_RIGHT_PAREN, SEPARATOR_SEMICOLON } },
+	{ NT_SCAN, { KEYWORD_GET, SEPARATOR_LEFT_PAREN, NT_IDS_START,
+				 SEPARATOR_RIGHT_PAREN, SEPARATOR_SEMICOLON } },
+	{ NT_WHILE, { KEYWORD_WHILE, SEPARATOR_LEFT_PAREN, NT_CONDITION,
+				  SEPARATOR_RIGHT_PAREN, NT_STATEMENT, KEYWORD_ENDWHILE } },
+	{ NT_CONDITION, { NT_EXPRESSION_START, NT_RELOP, NT_EXPRESSION_START } },
+	{ NT_RELOP, { OPERATOR_EQUAL } },
+	{ NT_RELOP, { OPERATOR_NOT_EQUAL } },
+	{ NT_RELOP, { OPERATOR_GREATER } },
+	{ NT_RELOP, { OPERATOR_LESS } },
+	{ NT_RELOP, { OPERATOR_LESS_EQUAL } },
+	{ NT_RELOP, { OPERATOR_GREATER_EQUAL } },
+	{ NT_EXPRESSION_START, { NT_TERM_START, NT_EXPRESSION_CONT } },
+	{ NT_EXPRESSION_CONT, { OPERATOR_PLUS, NT_TERM_START,
+							NT_EXPRESSION_CONT } },
+	{ NT_EXPRESSION_CONT, { OPERATOR_MINUS, NT_TERM_START,
+							NT_EXPRESSION_CONT } },
+	{ NT_EXPRESSION_CONT, {} },
+	{ NT_TERM_START, { NT_FACTOR, NT_TERM_CONT } },
+	{ NT_TERM_CONT, { OPERATOR_MULTIPLY, NT_FACTOR, NT_TERM_CONT } },
+	{ NT_TERM_CONT, { OPERATOR_DIVIDE, NT_FACTOR, NT_TERM_CONT } },
+	{ NT_TERM_CONT, {} },
+	{ NT_FACTOR, { OPERATOR_MINUS, NT_PRIMARY_START } },
+	{ NT_FACTOR, { NT_PRIMARY_START } },
+	{ NT_PRIMARY_START, { SYMBOL_IDENTIFIER, NT_PRIMARY_CONT } },
+	{ NT_PRIMARY_START, { SYMBOL_INTEGER } },
+	{ NT_PRIMARY_START, { SEPARATOR_LEFT_PAREN, NT_EXPRESSION_START,
+						  SEPARATOR_RIGHT_PAREN } },
+	{ NT_PRIMARY_START, { SYMBOL_REAL } },
+	{ NT_PRIMARY_START, { KEYWORD_TRUE } },
+	{ NT_PRIMARY_START, { KEYWORD_FALSE } },
+	{ NT_PRIMARY_CONT, { SEPARATOR_LEFT_PAREN, NT_IDS_START,
+						 SEPARATOR_RIGHT_PAREN } },
+	{ NT_PRIMARY_CONT, {} }
+};
+
+static constexpr Symbol_set symbol_set(Symbol_id symbol) {
+	return Symbol_set(1) << symbol;
+}
+
+struct First_sets {
+	Symbol_set first[NONTERMINAL_COUNT];  // tokens that can begin each one
+	bool nullable[NONTERMINAL_COUNT];  // true if it can derive <Empty>
+	bool predictive;  // true if no two alternatives share a first token
+};
+
+// FIRST set of a rule's right-hand side (nullable is set if it can be empty)
+static constexpr Symbol_set rule_first(const First_sets& sets,
+									   const Grammar_rule& rule,
+									   bool& nullable) {
+	Symbol_set first = 0;
+	nullable = true;
+	for (int i = 0; i < 8 && rule.rhs[i] != SYMBOL_NONE && nullable; i++) {
+		if (is_terminal(rule.rhs[i])) {
+			first |= symbol_set(static_cast<Symbol_id>(rule.rhs[i]));
+			nullable = false;
+		}
+		else {
+			first |= sets.first[rule.rhs[i] - NT_RAT23S];
+			nullable = sets.nullable[rule.rhs[i] - NT_RAT23S];
+		}
+	}
+	return first;
+}
+
 /*****************************************************************************
-| The constructor creates a lexer (to get tokens from the input file) using  |
-| the given input file stream. It also initializes ofs with the given output |
-| file stream.                                                               |
+| compute_first_sets finds the FIRST set of every nonterminal at compile     |
+| time: the rules are applied over and over until no set grows anymore (a    |
+| fixed point). It then checks that the alternatives of each nonterminal     |
+| begin with different tokens, so the current token always selects the one   |
+| alternative that the backtracking parser would end up using.               |
 *****************************************************************************/
-Syntax_Analyzer::Syntax_Analyzer(std::ifstream* input_file_stream,
-								 std::ofstream* output_file_stream) {
-	lexer = new Lexer(input_file_stream);
-	ofs = output_file_stream;
+static constexpr First_sets compute_first_sets() {
+	First_sets sets = {};
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (const Grammar_rule& rule : GRAMMAR) {
+			bool nullable = false;
+			Symbol_set first = rule_first(sets, rule, nullable);
+			int lhs = rule.lhs - NT_RAT23S;
+			if ((sets.first[lhs] | first) != sets.first[lhs]
+				|| (nullable && !sets.nullable[lhs])) {
+				sets.first[lhs] |= first;
+				sets.nullable[lhs] = sets.nullable[lhs] || nullable;
+				changed = true;
+			}
+		}
+	}
+
+	sets.predictive = true;
+	for (const Grammar_rule& a : GRAMMAR) {
+		for (const Grammar_rule& b : GRAMMAR) {
+			bool nullable = false;
+			if (&a != &b && a.lhs == b.lhs && (rule_first(sets, a, nullable)
+				& rule_first(sets, b, nullable)) != 0) {
+				sets.predictive = false;
+			}
+		}
+	}
+	return sets;
+}
+
+static constexpr First_sets FIRST_SETS = compute_first_sets();
+static_assert(FIRST_SETS.predictive, "alternatives must not share a token");
+
+// tokens that can begin the given nonterminal
+static constexpr Symbol_set FIRST(Nonterminal nonterminal) {
+	return FIRST_SETS.first[nonterminal - NT_RAT23S];
+}
+
+// tokens that the analyzer resumes at after a broken statement: the ones that
+// can begin a statement (except identifiers, which are also in expressions)
+// or come right after one
+static constexpr Symbol_set STATEMENT_SYNC =
+	(FIRST(NT_STATEMENT) & ~symbol_set(SYMBOL_IDENTIFIER))
+	| symbol_set(SEPARATOR_SEMICOLON) | symbol_set(SEPARATOR_RIGHT_BRACE)
+	| symbol_set(KEYWORD_FI) | symbol_set(KEYWORD_ELSE)
+	| symbol_set(KEYWORD_ENDWHILE) | symbol_set(SEPARATOR_HASH)
+	| symbol_set(KEYWORD_FUNCTION);
+
+/******************************************************************************
+| The text of every production, indexed by Production_id. The parser only     |
+| records ids: the text is looked up when the productions are printed.        |
+******************************************************************************/
+static const char* const PRODUCTION_TEXT[] = {
+	"<Rat23S> -> <Opt Function Definitions> # <Opt Declaration List> "
+		"# <Statement List Start>",
+	"<Opt Function Definitions> -> <Function Definitions Start>",
+	"<Opt Function Definitions> -> <Empty>",
+	"<Function Definitions Start> -> <Function> <Function Definitions "
+		"Cont>",
+	"<Function Definitions Cont> -> <Function Definitions Start>",
+	"<Function Definitions Cont> -> <Empty>",
+	"<Function> -> function <Identifier> ( <Opt Parameter List> ) "
+		"<Opt Declaration List> <Body>",
+	"<Opt Parameter List> -> <Parameter List Start>",
+	"<Opt Parameter List> -> <Empty>",
+	"<Parameter List Start> -> <Parameter> <Parameter List Cont>",
+	"<Parameter List Cont> -> , <Parameter List Start>",
+	"<Parameter List Cont> -> <Empty>",
+	"<Parameter> -> <IDs Start> <Qualifier>",
+	"<Qualifier> -> int",
+	"<Qualifier> -> bool",
+	"<Qualifier> -> real",
+	"<Qualifier> -> int | bool | real",
+	"<Body> -> { <Statement List Start> }",
+	"<Opt Declaration List> -> <Declaration List Start>",
+	"<Opt Declaration List> -> <Empty>",
+	"<Declaration List Start> -> <Declaration> ; <Declaration List "
+		"Cont>",
+	"<Declaration List Cont> -> <Declaration List Start>",
+	"<Declaration List Cont> -> <Empty>",
+	"<Declaration> -> <Qualifier> <IDs Start>",
+	"<IDs Start> -> <Identifer> <IDs Cont>",
+	"<IDs Cont> -> , <IDs Start>",
+	"<IDs Cont> -> <Empty>",
+	"<Statement List Start> -> <Statement> <Statement List Cont>",
+	"<Statement List Cont> -> <Statement List Start>",
+	"<Statement List Cont> -> <Empty>",
+	"<Statement> -> <Compound>",
+	"<Statement> -> <Assign>",
+	"<Statement> -> <If Start>",
+	"<Statement> -> <Return Start>",
+	"<Statement> -> <Print>",
+	"<Statement> -> <Scan>",
+	"<Statement> -> <While>",
+	"<Statement> -> <Compound> | <Assign> | <If Start> | <Return "
+		"Start> | <Print> | <Scan> | <While>",
+	"<Compound> -> { <Statement List Start> }",
+	"<Assign> -> <Identifier> = <Expression Start> ;",
+	"<If Start> -> if ( <Condition> ) <Statement> <If Cont>",
+	"<If Cont> -> else <Statement> fi",
+	"<If Cont> -> fi",
+	"<If Cont> -> fi | else <Statement> fi",
+	"<Return Start> -> return <Return Cont>",
+	"<Return Cont> -> <Expression Start> ;",
+	"<Return Cont> -> ;",
+	"<Return Cont> -> <Expression Start> ; | ;",
+	"<Print> -> put ( <Expression Start> ) ;",
+	"<Scan> -> get ( <IDs Start> ) ;",
+	"<While> -> while ( <Condition> ) <Statement> endwhile",
+	"<Condition> -> <Expression Start> <Relop> <Expression Start>",
+	"<Relop> -> ==",
+	"<Relop> -> !=",
+	"<Relop> -> >",
+	"<Relop> -> <",
+	"<Relop> -> <=",
+	"<Relop> -> =>",
+	"<Relop> -> == | != | > | < | <= | =>",
+	"<Expression Start> -> <Term Start> <Expression Cont>",
+	"<Expression Cont> -> + <Term Start> <Expression Cont>",
+	"<Expression Cont> -> - <Term Start> <Expression Cont>",
+	"<Expression Cont> -> <Empty>",
+	"<Term Start> -> <Factor> <Term Cont>",
+	"<Term Cont> -> * <Factor> <Term Cont>",
+	"<Term Cont> -> / <Factor> <Term Cont>",
+	"<Term Cont> -> <Empty>",
+	"<Factor> -> - <Primary Start>",
+	"<Factor> -> <Primary Start>",
+	"<Factor> -> - <Primary Start> | <Primary Start>",
+	"<Primary Start> -> <Identifier> <Primary Cont>",
+	"<Primary Start> -> <Integer>",
+	"<Primary Start> -> ( <Expression Start> )",
+	"<Primary Start> -> <Real>",
+	"<Primary Start> -> true",
+	"<Primary Start> -> false",
+	"<Primary Start> -> <Identifier> <Primary Cont> | <Integer> | ( "
+		"<Expression Start> ) | <Real> | true | false",
+	"<Primary Cont> -> ( <IDs Start> )",
+	"<Primary Cont> -> <Empty>"
+};
+static_assert(sizeof(PRODUCTION_TEXT) / sizeof(PRODUCTION_TEXT[0])
+			  == PRODUCTION_COUNT, "every Production_id needs its text");
+
+// thrown by print_error() to unwind the analysis to the function, declaration,
+// or statement that the error is in, which then recovers from it
+struct Syntax_error {};
+
+/******************************************************************************
+| The constructor receives the tokens that the lexer recorded during the LA   |
+| phase (so the input file is only lexed once). It also initializes ofs with  |
+| the given output file (null -> nothing is printed, only recorded).          |
+******************************************************************************/
+Syntax_Analyzer::Syntax_Analyzer(const Token_stream* token_stream,
+								 Output_buffer* output_file) {
+	tokens = token_stream;
+	ofs = output_file;
+}
+
+/******************************************************************************
+| The pipelined constructor receives the tokens from a lexer that is still    |
+| running on another thread (see Lexer::Analyze(Token_ring&)). Each token is  |
+| taken out of the ring when the analysis first needs it, and kept, so        |
+| everything else works the same as with recorded tokens. [text_begin,        |
+| text_end) is the input buffer that the lexer is reading.                    |
+******************************************************************************/
+Syntax_Analyzer::Syntax_Analyzer(Token_ring* token_ring,
+								 const char* text_begin, const char* text_end,
+								 Output_buffer* output_file) {
+	ring = token_ring;
+	received.text = text_begin;
+	received.tokens.reserve((text_end - text_begin) / 4 + 1);  // (as the LA)
+	tokens = &received;
+	ofs = output_file;
+}
+
+/******************************************************************************
+| PARSE_PREDICTIVE (the default) picks each alternative by looking at the     |
+| current token. PARSE_BACKTRACKING tries every alternative in order until    |
+| one of them works. Both produce the same productions and error messages.    |
+******************************************************************************/
+void Syntax_Analyzer::set_parse_mode(Parse_mode parse_mode) {
+	mode = parse_mode;
+}
+
+/******************************************************************************
+| With the trace turned off, the tokens and their productions aren't printed, |
+| so the output file only holds the error message (and the unexpected token)  |
+| if the file fails. A file that passes leaves the output file empty.         |
+******************************************************************************/
+void Syntax_Analyzer::set_trace(bool enabled) {
+	trace = enabled;
+}
+
+/******************************************************************************
+| Packrat mode memoizes every rule that fails at a token, so it never runs    |
+| twice at the same token (ie. when error recovery or backtracking comes back |
+| to it). max_entries bounds the memory used (about 40 bytes per entry), and  |
+| results that don't fit are just not memoized. Rat23S() returns how many     |
+| rules didn't have to run again (Syntax_result::memo).                       |
+******************************************************************************/
+void Syntax_Analyzer::set_packrat(std::size_t max_entries) {
+	memo.resize(max_entries);
+}
+
+/******************************************************************************
+| Statements ({ }, if, and while) and parentheses can be nested up to depth   |
+| levels deep each (default: DEFAULT_MAX_DEPTH). They are read on explicit    |
+| stacks, so the limit isn't there to protect the analyzer, but whatever uses |
+| the AST. A file that goes deeper gets one error, and the rest of it isn't   |
+| analyzed.                                                                   |
+******************************************************************************/
+void Syntax_Analyzer::set_max_depth(std::size_t depth) {
+	max_depth = depth;
+}
+
+/******************************************************************************
+| The AST of the input file, or null if Rat23S() hasn't finished. Its nodes   |
+| are owned by the analyzer (and its lexemes by the input buffer), so it can  |
+| only be used while both of them exist.                                      |
+******************************************************************************/
+const Program_node* Syntax_Analyzer::get_program() const {
+	return program;
+}
+
+// every token read so far (all of them, once Rat23S() has finished)
+const Token_stream& Syntax_Analyzer::get_tokens() const {
+	return *tokens;
+}
+
+// takes the rest of the tokens out of the ring, up to EOF (so the lexer isn't
+// left waiting if Rat23S() stopped early). throws Lexical_error if the lexer
+// stopped at an error
+void Syntax_Analyzer::receive_rest() {
+	while (ring != nullptr && (received.tokens.empty()
+							   || received.tokens.back().kind != TOKEN_EOF)) {
+		receive_token();
+	}
 }
 
 /******************************************************************************
 | Rat23S(), the "main" method of the Syntax Analyzer, represents the starting |
 | production <Rat23S>. It essentially reads the entire input file and checks  |
 | whether it passes the Syntax Analysis phase or not. When the program        |
-| finishes (either passing or failing), it closes all file streams. Each      |
+| finishes (either passing or failing), the output is flushed. Each           |
 | production rule has its own function.                                       |
+|                                                                             |
+| A syntax error doesn't stop the analysis: the rest of the file is still     |
+| checked (see print_error()), and every error is returned in the result.     |
+| The AST is only returned if there weren't any errors.                       |
 ******************************************************************************/
-void Syntax_Analyzer::Rat23S() {
+Syntax_result Syntax_Analyzer::Rat23S() {
 	// add <Rat23S> to list of productions
-	Productions.push_back("\t<Rat23S> -> <Opt Function Definitions> #"
-						  " <Opt Declaration List> # <Statement List Start>");
+	Productions.push_back(PROD_RAT23S);
+	Program_node* root = arena.make<Program_node>();
 
-	// <Rat23S> -> <Opt Function Definitions> # <Opt Declaration List> #
-	//             <Statement List> $
-	Opt_Function_Definitions();
+	try {
+		// <Rat23S> -> <Opt Function Definitions> # <Opt Declaration List> #
+		//             <Statement List> $
+		root->functions = Opt_Function_Definitions();
+
+		// a missing '#' is reported, and the analysis goes on from the next
+		// '#' (or from the first token that can begin the part after it)
+		if (!check_symbol(SEPARATOR_HASH)) {
+			report_error("Missing '#' or 'function' between optional function"
+						 " definitions and an optional declaration list");
+			skip_to(symbol_set(SEPARATOR_HASH)
+					| FIRST(NT_DECLARATION_LIST_START));
+			skip_symbol(SEPARATOR_HASH);
+		}
 
-	try { check_symbol("#"); }
-	catch (int err) {
-		print_error("Missing '#' or 'function' between optional function"
-					" definitions and an optional declaration list");
-	}
+		root->declarations = Opt_Declaration_List();
 
-	Opt_Declaration_List();
+		if (!check_symbol(SEPARATOR_HASH)) {
+			report_error("Missing '#' between an optional declaration list and"
+						 " the list of program statements (main body)");
+			skip_to(symbol_set(SEPARATOR_HASH)
+					| FIRST(NT_STATEMENT_LIST_START));
+			skip_symbol(SEPARATOR_HASH);
+		}
 
-	try { check_symbol("#"); }
-	catch (int err) {
-		print_error("Missing '#' between an optional declaration list and the"
-					" list of program statements (main body)");
-	}
+		root->statements = Statement_List_Start();
+		if (!root->statements) {
+			report_error("Missing statement(s) for program's main body");
+		}
 
-	try { Statement_List_Start(); }
-	catch (int err) {
-		print_error("Missing statement(s) for program's main body");
+		// anything else before the end of the file is reported, skipped until
+		// a statement can begin, and checked as more statements of the main
+		// body
+		while (!check_symbol(SYMBOL_EOF)) {
+			report_error("File should reach end after main body's statements");
+			current_token = NO_TOKEN;  // (skip the unexpected token)
+			skip_to(FIRST(NT_STATEMENT_LIST_START));
+			Statement_List_Start();
+		}
+	}
+	catch (Nesting_error&) {
+		// (reported by nesting_error(), the rest of the file is skipped)
 	}
 
-	try { check_symbol("EOF"); }
-	catch (int err) {
-		print_error("File should reach end after main body's statements");
+	// write everything that is left in the output buffer
+	if (ofs != nullptr) {
+		ofs->flush();
 	}
 
-	// close file streams
-	lexer->close_ifs();
-	ofs->close();
+	if (diagnostics.empty()) {
+		program = root;
+	}
+	Syntax_result result;
+	result.program = program;
+	result.diagnostics = std::move(diagnostics);
+	result.memo = memo.get_stats();
+	return result;
 }
 
 /*****************************************************************************
@@ -67,1144 +509,1550 @@ void Syntax_Analyzer::Rat23S() {
 | rule(s) used within it. In this case, since <Opt Function Definitions> ->  |
 | <Function Definitions Start>, the function Opt_Function_Definitions() will |
 | call the function Function_Definitions_Start().                            |
+|                                                                            |
+| Each function also returns the part of the AST that it built (ie. a list   |
+| of functions), or null if its production couldn't be used.                 |
 *****************************************************************************/
-void Syntax_Analyzer::Opt_Function_Definitions() {
+Function_node* Syntax_Analyzer::Opt_Function_Definitions() {
 	// when a production has multiple rules (ie. E -> A | B | C), an
-	// initial_list is created to save the list of productions used up to
-	// this point. When one case doesn't work (ie. E -> A), the
-	// initial_list will restore the list of Productions to its starting
-	// point (for backtracking and testing the other cases).
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+	// initial checkpoint is created to save the list of productions used up
+	// to this point. When one case doesn't work (ie. E -> A), rolling back
+	// to the initial checkpoint will restore the list of Productions to its
+	// starting point (for backtracking and testing the other cases).
+	Checkpoint initial = checkpoint();
 
 	// Case 1: <Opt Function Definitions> -> <Function Definitions Start>
-	try {  // add Case 1 to list of productions and try it
-		Productions.push_back("\t<Opt Function Definitions> ->"
-							  " <Function Definitions Start>");
-		Function_Definitions_Start();
-		return;
-	}
-	catch (int err) {  // if Case 1 didn't work -> revert to initial_list
-		copy_list(initial_list, Productions);
+	// (can_start() skips a case whose first token can't be the current one)
+	if (can_start(FIRST(NT_FUNCTION_DEFINITIONS_START))) {
+		// add Case 1 to list of productions and try it
+		Productions.push_back(PROD_OPT_FUNCTION_DEFINITIONS);
+		if (Function_node* functions = Function_Definitions_Start()) {
+			return functions;
+		}
+		rollback(initial);  // Case 1 didn't work -> revert
 	}
-	
+
 	// Case 2: <Opt Function Definitions> -> <Empty>
-	Productions.push_back("\t<Opt Function Definitions> -> <Empty>");
+	Productions.push_back(PROD_OPT_FUNCTION_DEFINITIONS_EMPTY);
+	return nullptr;
 }
 
 
-void Syntax_Analyzer::Function_Definitions_Start() {
-	Productions.push_back("\t<Function Definitions Start> -> <Function>"
-						  " <Function Definitions Cont>");
+Function_node* Syntax_Analyzer::Function_Definitions_Start() {
+	// <Function Definitions Cont> -> <Function Definitions Start> is a loop
+	// here instead of a recursive call, so a long list of functions doesn't
+	// use up the stack (the productions are the same)
+	Function_node* functions = nullptr;
+	Function_node** link = &functions;  // where the next function goes
+	Checkpoint initial;  // (before each <Function Definitions Cont>)
+	while (true) {
+		// <Function Definitions Start> will try to use <Function>. If
+		// Function() doesn't work, it returns null. If <Function> cannot be
+		// used, <Function Definitions Start> will not work either.
+		// Therefore, it also returns null to the function that calls it.
+		// (This "algorithm" is present for a lot of productions involved in
+		// backtracking).
+		Function_node* function = nullptr;
+		Rule_start start;
+		if (!recall_failure(NT_FUNCTION_DEFINITIONS_START, start)) {
+			Productions.push_back(PROD_FUNCTION_DEFINITIONS_START);
+			Arena_mark nodes = arena.mark();
+			try {
+				function = Function();
+			}
+			catch (Syntax_error&) {
+				// skip the rest of the broken function (up to the next
+				// function or the '#' after the function definitions)
+				skip_to(symbol_set(KEYWORD_FUNCTION) |
+						symbol_set(SEPARATOR_HASH));
+				arena.reset(nodes);
+				function = arena.make<Function_node>();
+			}
+			if (!function) {
+				remember_failure(start);
+			}
+		}
+		if (!function) {
+			if (!functions) {
+				return nullptr;
+			}
+			rollback(initial);  // (Case 1 of <Function Definitions Cont>)
+			break;
+		}
+		*link = function;
+		link = &function->next;
 
-	// <Function Definitions Start> will try to use <Function>. If Function()
-	// doesn't work, it will throw an error, and this error will be caught.
-	// If <Function> cannot be used, <Function Definitions Start> will not
-	// work either. Therefore, it will also throw an error to the
-	// function that calls it. (This try-catch "algorithm" is present
-	// for a lot of productions involved in backtracking).
-	try { Function(); }
-	catch (int err) { throw -1; }
+		// Case 1: <Function Definitions Cont> -> <Function Definitions Start>
+		initial = checkpoint();
+		if (!can_start(FIRST(NT_FUNCTION_DEFINITIONS_START))) {
+			break;
+		}
+		Productions.push_back(PROD_FUNCTION_DEFINITIONS_CONT);
+	}
 
-	Function_Definitions_Cont();
+	// Case 2: <Function Definitions Cont> -> <Empty>
+	Productions.push_back(PROD_FUNCTION_DEFINITIONS_CONT_EMPTY);
+	return functions;
 	// some production rules have functions
 }
 
 
-void Syntax_Analyzer::Function_Definitions_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	// Case 1: <Function Definitions Cont> -> <Function Definitions Start>
-	try {
-		Productions.push_back("\t<Function Definitions Cont> ->"
-							  " <Function Definitions Start>");
-		Function_Definitions_Start();
-		return;
+Function_node* Syntax_Analyzer::Function() {
+	Rule_start start;
+	if (recall_failure(NT_FUNCTION, start)) {
+		return nullptr;
 	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
-
-	// Case 2: <Function Definitions Cont> -> <Empty>
-	Productions.push_back("\t<Function Definitions Cont> -> <Empty>");
-}
-
 
-void Syntax_Analyzer::Function() {
 	// if 'function' is not present, then <Function> will not be used in the
-	// list of productions (throw exception -1)
-	try {
-		Productions.push_back("\t<Function> -> function <Identifier> ("
-							  " <Opt Parameter List> ) <Opt Declaration List>"
-							  " <Body>");
-		check_symbol("function");
+	// list of productions (return null)
+	Productions.push_back(PROD_FUNCTION);
+	if (!check_symbol(KEYWORD_FUNCTION)) {
+		remember_failure(start);
+		return nullptr;
 	}
-	catch (int err) { throw -1; }
+	Function_node* function = arena.make<Function_node>();
+	function->line = matched_token.line;
 
 	// however, if 'function' IS present, then <Function> will be used.
 	// Therefore, the rest of the production MUST work (or else <Function>
 	// will have improper syntax, and the Syntax Analysis will fail):
 	// in this case, <Identifier>, '(', <Opt Parameter List>, ')',
 	// <Opt Declaration List>, and <Body> must come after 'function'
-	try { check_symbol("<identifier>"); }
-	catch (int err) {
-		// if something is missing/out of place, an exception will be caught
-		// and an error message will be printed
+	if (!check_symbol(SYMBOL_IDENTIFIER)) {
+		// if something is missing/out of place, an error message is printed
 		print_error("Missing identifier: function needs a name");
 	}
+	function->name = matched_lexeme();
 
-	try { check_symbol("("); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_LEFT_PAREN)) {
 		print_error("Missing '(' for function's parameters");
 	}
 
-	Opt_Parameter_List();
+	function->parameters = Opt_Parameter_List();
 
-	try { check_symbol(")"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_RIGHT_PAREN)) {
 		print_error("Missing identifier(s) or ')' for function's parameters");
 	}
 
-	Opt_Declaration_List();
-	Body();
-	// note: some functions do not throw exceptions because they will either
+	function->declarations = Opt_Declaration_List();
+	function->body = Body();
+	return function;
+	// note: some functions never return null because they will either
 	// work all the time (such as with production rules that use <Empty>), OR
 	// the function call will handle the error. For example, Body() accounts
-	// for all of its own exceptions errors
+	// for all of its own errors
 }
 
 
-void Syntax_Analyzer::Opt_Parameter_List() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+Declaration_node* Syntax_Analyzer::Opt_Parameter_List() {
+	Checkpoint initial = checkpoint();
 
-	try {  // Case 1: <Opt Parameter List> -> <Parameter List Start>
-		Productions.push_back("\t<Opt Parameter List> ->"
-							  " <Parameter List Start>");
-		Parameter_List_Start();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	// Case 1: <Opt Parameter List> -> <Parameter List Start>
+	if (can_start(FIRST(NT_PARAMETER_LIST_START))) {
+		Productions.push_back(PROD_OPT_PARAMETER_LIST);
+		if (Declaration_node* parameters = Parameter_List_Start()) {
+			return parameters;
+		}
+		rollback(initial);
 	}
 
 	// Case 2: <Opt Parameter List> -> <Empty>
-	Productions.push_back("\t<Opt Parameter List> -> <Empty>");
-}
-
-
-void Syntax_Analyzer::Parameter_List_Start() {
-	Productions.push_back("\t<Parameter List Start> -> <Parameter>"
-						  " <Parameter List Cont>");
-
-	try { Parameter(); }
-	catch (int err) { throw -1; }
-
-	Parameter_List_Cont();
+	Productions.push_back(PROD_OPT_PARAMETER_LIST_EMPTY);
+	return nullptr;
 }
 
 
-void Syntax_Analyzer::Parameter_List_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	try {  // Case 1: <Parameter List Cont> -> , <Parameter List Start>
-		Productions.push_back("\t<Parameter List Cont> -> ,"
-							  " <Parameter List Start>");
-		check_symbol(",");
-		try { Parameter_List_Start(); }
-		catch (int err) {
+Declaration_node* Syntax_Analyzer::Parameter_List_Start() {
+	// <Parameter List Cont> -> , <Parameter List Start> is a loop here (see
+	// Function_Definitions_Start())
+	Declaration_node* parameters = nullptr;
+	Declaration_node** link = &parameters;
+	std::size_t count = 0;
+	while (true) {
+		Declaration_node* parameter = nullptr;
+		Rule_start start;
+		if (!recall_failure(NT_PARAMETER_LIST_START, start)) {
+			Productions.push_back(PROD_PARAMETER_LIST_START);
+			parameter = Parameter();
+			if (!parameter) {
+				remember_failure(start);
+			}
+		}
+		if (!parameter) {
+			if (!parameters) {
+				return nullptr;
+			}
 			print_error("Missing parameter(s) after ',' in parameter list");
 		}
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		*link = parameter;
+		link = &parameter->next;
+		count++;
+
+		// Case 1: <Parameter List Cont> -> , <Parameter List Start>
+		Checkpoint initial = checkpoint();
+		if (!can_start(symbol_set(SEPARATOR_COMMA))) {
+			break;
+		}
+		Productions.push_back(PROD_PARAMETER_LIST_CONT);
+		if (!check_symbol(SEPARATOR_COMMA)) {
+			rollback(initial);
+			break;
+		}
 	}
 
-	// Case 2: <Parameter List Cont> -> <Empty>
-	Productions.push_back("\t<Parameter List Cont> -> <Empty>");
+	// Case 2: <Parameter List Cont> -> <Empty> (it is still added after
+	// Case 1 works, so once for each parameter)
+	for (std::size_t i = 0; i < count; i++) {
+		Productions.push_back(PROD_PARAMETER_LIST_CONT_EMPTY);
+	}
+	return parameters;
 }
 
 
-void Syntax_Analyzer::Parameter() {
-	Productions.push_back("\t<Parameter> -> <IDs Start> <Qualifier>");
+Declaration_node* Syntax_Analyzer::Parameter() {
+	Rule_start start;
+	if (recall_failure(NT_PARAMETER, start)) {
+		return nullptr;
+	}
+
+	Productions.push_back(PROD_PARAMETER);
 
-	try { IDs_Start(); }
-	catch (int err) { throw -1; }
+	Identifier_node* ids = IDs_Start();
+	if (!ids) {
+		remember_failure(start);
+		return nullptr;
+	}
 
-	try { Qualifier(); }
-	catch (int err) {
+	Declaration_node* parameter = arena.make<Declaration_node>();
+	parameter->ids = ids;
+	parameter->line = ids->line;
+	parameter->qualifier = Qualifier();
+	if (parameter->qualifier == SYMBOL_NONE) {
 		print_error("Parameter(s) missing qualifier: 'int', 'bool', or 'real'");
 	}
+	return parameter;
 }
 
 
-void Syntax_Analyzer::Qualifier() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	try {  // Case 1: <Qualifier> -> int
-		Productions.push_back("\t<Qualifier> -> int");
-		check_symbol("int");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+Symbol_id Syntax_Analyzer::Qualifier() {
+	Rule_start start;
+	if (recall_failure(NT_QUALIFIER, start)) {
+		return SYMBOL_NONE;
 	}
 
-	try {  // Case 2: <Qualifier> -> bool
-		Productions.push_back("\t<Qualifier> -> bool");
-		check_symbol("bool");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	Checkpoint initial = checkpoint();
+
+	if (can_start(symbol_set(KEYWORD_INT))) {  // Case 1: <Qualifier> -> int
+		Productions.push_back(PROD_QUALIFIER_INT);
+		if (check_symbol(KEYWORD_INT)) {
+			return KEYWORD_INT;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 3: <Qualifier> -> real
-		Productions.push_back("\t<Qualifier> -> real");
-		check_symbol("real");
-		return;
+	if (can_start(symbol_set(KEYWORD_BOOL))) {  // Case 2: <Qualifier> -> bool
+		Productions.push_back(PROD_QUALIFIER_BOOL);
+		if (check_symbol(KEYWORD_BOOL)) {
+			return KEYWORD_BOOL;
+		}
+		rollback(initial);
 	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+
+	if (can_start(symbol_set(KEYWORD_REAL))) {  // Case 3: <Qualifier> -> real
+		Productions.push_back(PROD_QUALIFIER_REAL);
+		if (check_symbol(KEYWORD_REAL)) {
+			return KEYWORD_REAL;
+		}
+		rollback(initial);
 	}
 
 	// No matches
-	Productions.push_back("\t<Qualifier> -> int | bool | real");
-	throw -1;
+	Productions.push_back(PROD_QUALIFIER_NO_MATCH);
+	remember_failure(start);
+	return SYMBOL_NONE;
 }
 
 
-void Syntax_Analyzer::Body() {
-	Productions.push_back("\t<Body> -> { <Statement List Start> }");
+Statement_node* Syntax_Analyzer::Body() {
+	Productions.push_back(PROD_BODY);
 
-	try { check_symbol("{"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_LEFT_BRACE)) {
 		print_error("Missing '{' for beginning of function's body");
 	}
 
-	try { Statement_List_Start(); }
-	catch (int err) {
+	Statement_node* statements = Statement_List_Start();
+	if (!statements) {
 		print_error("Function body does not have any statements");
 	}
 
-	try { check_symbol("}"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_RIGHT_BRACE)) {
 		print_error("Missing '}' for ending of function's body");
 	}
+	return statements;
 
-	// note: no exceptions are thrown because Body() is always expected to work.
-	// some functions follow this behavior (such as If_Cont and Return_Cont)
+	// note: Body() never returns null because it is always expected to
+	// work. some functions follow this behavior (such as Return_Cont, which
+	// returns null only for its shorter alternative)
 }
 
 
-void Syntax_Analyzer::Opt_Declaration_List() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+Declaration_node* Syntax_Analyzer::Opt_Declaration_List() {
+	Checkpoint initial = checkpoint();
 
-	try {  // Case 1: <Opt Declaration List> -> <Declaration List Start>
-		Productions.push_back("\t<Opt Declaration List> ->"
-							  " <Declaration List Start>");
-		Declaration_List_Start();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	// Case 1: <Opt Declaration List> -> <Declaration List Start>
+	if (can_start(FIRST(NT_DECLARATION_LIST_START))) {
+		Productions.push_back(PROD_OPT_DECLARATION_LIST);
+		if (Declaration_node* declarations = Declaration_List_Start()) {
+			return declarations;
+		}
+		rollback(initial);
 	}
 
 	// Case 2: <Opt Declaration List> -> <Empty>
-	Productions.push_back("\t<Opt Declaration List> -> <Empty>");
+	Productions.push_back(PROD_OPT_DECLARATION_LIST_EMPTY);
+	return nullptr;
 }
 
 
-void Syntax_Analyzer::Declaration_List_Start() {
-	Productions.push_back("\t<Declaration List Start> -> <Declaration> ;"
-						  " <Declaration List Cont>");
-
-	try { Declaration(); }
-	catch (int err) { throw -1; }
+Declaration_node* Syntax_Analyzer::Declaration_List_Start() {
+	// <Declaration List Cont> -> <Declaration List Start> is a loop here
+	// (see Function_Definitions_Start())
+	Declaration_node* declarations = nullptr;
+	Declaration_node** link = &declarations;
+	Checkpoint initial;  // (before each <Declaration List Cont>)
+	while (true) {
+		Declaration_node* declaration = nullptr;
+		Rule_start start;
+		if (!recall_failure(NT_DECLARATION_LIST_START, start)) {
+			Productions.push_back(PROD_DECLARATION_LIST_START);
+
+			Arena_mark nodes = arena.mark();
+			try {
+				declaration = Declaration();
+				if (!declaration) {
+					remember_failure(start);
+				}
+				else if (!check_symbol(SEPARATOR_SEMICOLON)) {
+					print_error("Missing ';' at end of declaration");
+				}
+			}
+			catch (Syntax_error&) {
+				// skip the rest of the broken declaration (up to its ';',
+				// the next declaration, the function's body, or the '#'
+				// after the list)
+				skip_to(symbol_set(SEPARATOR_SEMICOLON) | FIRST(NT_DECLARATION)
+						| symbol_set(SEPARATOR_LEFT_BRACE)
+						| symbol_set(SEPARATOR_HASH));
+				skip_symbol(SEPARATOR_SEMICOLON);
+				arena.reset(nodes);
+				declaration = arena.make<Declaration_node>();
+			}
+		}
+		if (!declaration) {
+			if (!declarations) {
+				return nullptr;
+			}
+			rollback(initial);  // (Case 1 of <Declaration List Cont>)
+			break;
+		}
+		*link = declaration;
+		link = &declaration->next;
 
-	try { check_symbol(";"); }
-	catch (int err) {
-		print_error("Missing ';' at end of declaration");
+		// Case 1: <Declaration List Cont> -> <Declaration List Start>
+		initial = checkpoint();
+		if (!can_start(FIRST(NT_DECLARATION_LIST_START))) {
+			break;
+		}
+		Productions.push_back(PROD_DECLARATION_LIST_CONT);
 	}
 
-	Declaration_List_Cont();
+	// Case 2: <Declaration List Cont> -> <Empty>
+	Productions.push_back(PROD_DECLARATION_LIST_CONT_EMPTY);
+	return declarations;
 }
 
 
-void Syntax_Analyzer::Declaration_List_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	try {  // Case 1: <Declaration List Cont> -> <Declaration List Start>
-		Productions.push_back("\t<Declaration List Cont> ->"
-							  " <Declaration List Start>");
-		Declaration_List_Start();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+Declaration_node* Syntax_Analyzer::Declaration() {
+	Rule_start start;
+	if (recall_failure(NT_DECLARATION, start)) {
+		return nullptr;
 	}
 
-	// Case 2: <Declaration List Cont> -> <Empty>
-	Productions.push_back("\t<Declaration List Cont> -> <Empty>");
-}
-
+	Productions.push_back(PROD_DECLARATION);
 
-void Syntax_Analyzer::Declaration() {
-	Productions.push_back("\t<Declaration> -> <Qualifier> <IDs Start>");
-
-	try { Qualifier(); }
-	catch (int err) { throw -1; }
+	Symbol_id qualifier = Qualifier();
+	if (qualifier == SYMBOL_NONE) {
+		remember_failure(start);
+		return nullptr;
+	}
 
-	try { IDs_Start(); }
-	catch (int err) {
+	Declaration_node* declaration = arena.make<Declaration_node>();
+	declaration->qualifier = qualifier;
+	declaration->line = matched_token.line;
+	declaration->ids = IDs_Start();
+	if (!declaration->ids) {
 		print_error("Missing identifier(s) in declaration (after qualifier)");
 	}
+	return declaration;
 }
 
 
-void Syntax_Analyzer::IDs_Start() {
-	Productions.push_back("\t<IDs Start> -> <Identifer> <IDs Cont>");
-
-	try { check_symbol("<identifier>"); }
-	catch (int err) {
-		throw -1;
+Identifier_node* Syntax_Analyzer::IDs_Start() {
+	// <IDs Cont> -> , <IDs Start> is a loop here (see
+	// Function_Definitions_Start())
+	Identifier_node* ids = nullptr;
+	Identifier_node** link = &ids;
+	while (true) {
+		Rule_start start;
+		bool matched = false;
+		if (!recall_failure(NT_IDS_START, start)) {
+			Productions.push_back(PROD_IDS_START);
+			matched = check_symbol(SYMBOL_IDENTIFIER);
+			if (!matched) {
+				remember_failure(start);
+			}
+		}
+		if (!matched) {
+			if (!ids) {
+				return nullptr;
+			}
+			print_error("Missing identifier(s) after ','");
+		}
+		Identifier_node* id = arena.make<Identifier_node>();
+		id->name = matched_lexeme();
+		id->line = matched_token.line;
+		*link = id;
+		link = &id->next;
+
+		// Case 1: <IDs Cont> -> , <IDs Start>
+		Checkpoint initial = checkpoint();
+		if (!can_start(symbol_set(SEPARATOR_COMMA))) {
+			break;
+		}
+		Productions.push_back(PROD_IDS_CONT);
+		if (!check_symbol(SEPARATOR_COMMA)) {
+			rollback(initial);
+			break;
+		}
 	}
 
-	IDs_Cont();
+	// Case 2: <IDs Cont> -> <Empty> (only after the last identifier)
+	Productions.push_back(PROD_IDS_CONT_EMPTY);
+	return ids;
 }
 
 
-void Syntax_Analyzer::IDs_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	try {  // Case 1: <IDs Cont> -> , <IDs Start>
-		Productions.push_back("\t<IDs Cont> -> , <IDs Start>");
-		check_symbol(",");
-		try { IDs_Start(); }
-		catch (int err) {
-			print_error("Missing identifier(s) after ','");
+/******************************************************************************
+| Statements can be nested in each other ({ }, if, and while), so they aren't |
+| read by functions that call each other (which used a native stack frame for |
+| every level, and crashed on input that was nested thousands of levels       |
+| deep). Instead, one loop runs them on an explicit stack of Statement_frames |
+| (on the heap): one for each statement list, and one for each compound/if/   |
+| while statement that has begun (its first token was matched by Statement(), |
+| see begin_statement()). The frame on top does one step at a time: a step    |
+| either starts a nested list or statement, which goes on top, or is the last |
+| one of its frame, whose statement is then given to the frame below it       |
+| (value). Other statements are still read by function calls, since they      |
+| can't be nested. The productions, errors, and AST are the same as those of  |
+| the recursive productions: each one is added at the same token.             |
+******************************************************************************/
+Statement_node* Syntax_Analyzer::Statement_List_Start() {
+	std::vector<Statement_frame>& frames = statement_frames;
+	frames.clear();  // (never used by more than one list at a time)
+	statement_depth = 0;
+	frames.push_back(Statement_frame());
+	frames.back().step = STEP_LIST_START;
+
+	Statement_node* value = nullptr;  // what the frame on top was given
+	while (!frames.empty()) {
+		Statement_frame& frame = frames.back();
+		try {
+			switch (frame.step) {
+				// <Statement List Start> -> <Statement> <Statement List Cont>
+				case STEP_LIST_START:
+					frame.step = STEP_LIST_STATEMENT;
+					if (recall_failure(NT_STATEMENT_LIST_START, frame.start)) {
+						value = nullptr;
+						break;
+					}
+					Productions.push_back(PROD_STATEMENT_LIST_START);
+					value = Statement();  // (might push its frame on top)
+					if (!value) {
+						remember_failure(frame.start);
+					}
+					break;
+
+				case STEP_LIST_STATEMENT:
+					if (!value) {  // (nothing was read by <Statement>)
+						if (frame.node) {
+							rollback(frame.initial);
+							Productions.push_back(
+								PROD_STATEMENT_LIST_CONT_EMPTY);
+						}
+						value = frame.node;
+						frames.pop_back();
+						break;
+					}
+					if (frame.node) {
+						frame.last->next = value;
+					}
+					else {
+						frame.node = value;
+					}
+					frame.last = value;
+
+					// Case 1: <Statement List Cont> -> <Statement List Start>
+					frame.initial = checkpoint();
+					if (can_start(FIRST(NT_STATEMENT_LIST_START))) {
+						Productions.push_back(PROD_STATEMENT_LIST_CONT);
+						frame.step = STEP_LIST_START;
+						break;
+					}
+
+					// Case 2: <Statement List Cont> -> <Empty>
+					Productions.push_back(PROD_STATEMENT_LIST_CONT_EMPTY);
+					value = frame.node;
+					frames.pop_back();
+					break;
+
+				// <Compound> -> { <Statement List Start> }
+				case STEP_COMPOUND_START:
+					frame.step = STEP_COMPOUND_BODY;
+					frames.push_back(Statement_frame());
+					frames.back().step = STEP_LIST_START;
+					break;
+
+				case STEP_COMPOUND_BODY:
+					frame.node->body = value;
+					if (!value) {
+						print_error("Compound statement is missing inside"
+									" statement(s)");
+					}
+					if (!check_symbol(SEPARATOR_RIGHT_BRACE)) {
+						print_error("Missing '}' at end of Compound statement");
+					}
+					value = end_statement();
+					break;
+
+				// <If Start> -> if ( <Condition> ) <Statement> <If Cont>
+				case STEP_IF_START:
+					frame.step = STEP_IF_BODY;
+					value = Statement();
+					break;
+
+				case STEP_IF_BODY:
+					frame.node->body = value;
+					if (!value) {
+						print_error("Missing statement for satisfied if"
+									" condition");
+					}
+					if (!If_Cont()) {
+						value = end_statement();
+						break;
+					}
+					frame.step = STEP_IF_ELSE;
+					value = Statement();
+					break;
+
+				// <If Cont> -> else <Statement> fi
+				case STEP_IF_ELSE:
+					frame.node->else_body = value;
+					if (!value) {
+						print_error("Missing statement for satisfied else"
+									" condition of if statement");
+					}
+					if (!check_symbol(KEYWORD_FI)) {
+						print_error("Missing 'fi' at end of if statement");
+					}
+					value = end_statement();
+					break;
+
+				// <While> -> while ( <Condition> ) <Statement> endwhile
+				case STEP_WHILE_START:
+					frame.step = STEP_WHILE_BODY;
+					value = Statement();
+					break;
+
+				case STEP_WHILE_BODY:
+					frame.node->body = value;
+					if (!value) {
+						print_error("Missing statement(s) inside of while"
+									" loop");
+					}
+					if (!check_symbol(KEYWORD_ENDWHILE)) {
+						print_error("Missing 'endwhile' at end of while"
+									" statement");
+					}
+					value = end_statement();
+					break;
+			}
+		}
+		catch (Syntax_error&) {
+			// only the steps of a compound/if/while statement print errors
+			// (Statement() catches the ones of the statements it reads), so
+			// the statement on top is the broken one
+			Checkpoint initial = frames.back().initial;
+			end_statement();
+			value = recover_statement(initial);
 		}
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
 	}
-
-	// Case 2: <IDs Cont> -> <Empty>
-	Productions.push_back("\t<IDs Cont> -> <Empty>");
+	return value;
 }
 
 
-void Syntax_Analyzer::Statement_List_Start() {
-	Productions.push_back("\t<Statement List Start> -> <Statement>"
-						  " <Statement List Cont>");
-
-	try { Statement(); }
-	catch (int err) { throw -1; }
-
-	Statement_List_Cont();
-}
-
+Statement_node* Syntax_Analyzer::Statement() {
+	Rule_start start;
+	if (recall_failure(NT_STATEMENT, start)) {
+		return nullptr;
+	}
 
-void Syntax_Analyzer::Statement_List_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+	Checkpoint initial = checkpoint();
+	try {
+		// Case 1: <Statement> -> <Compound>
+		if (can_start(FIRST(NT_COMPOUND))) {
+			Productions.push_back(PROD_STATEMENT_COMPOUND);
+			if (Statement_node* statement = Compound()) {
+				begin_statement(statement, STEP_COMPOUND_START, initial);
+				return statement;
+			}
+			rollback(initial);
+		}
 
-	try {  // Case 1: <Statement List Cont> -> <Statement List Start>
-		Productions.push_back("\t<Statement List Cont> ->"
-							  " <Statement List Start>");
-		Statement_List_Start();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
+		if (can_start(FIRST(NT_ASSIGN))) {  // Case 2: <Statement> -> <Assign>
+			Productions.push_back(PROD_STATEMENT_ASSIGN);
+			if (Statement_node* statement = Assign()) {
+				return statement;
+			}
+			rollback(initial);
+		}
 
-	// Case 2: <Statement List Cont> -> <Empty>
-	Productions.push_back("\t<Statement List Cont> -> <Empty>");
-}
+		// Case 3: <Statement> -> <If Start>
+		if (can_start(FIRST(NT_IF_START))) {
+			Productions.push_back(PROD_STATEMENT_IF);
+			if (Statement_node* statement = If_Start()) {
+				begin_statement(statement, STEP_IF_START, initial);
+				return statement;
+			}
+			rollback(initial);
+		}
 
+		// Case 4: <Statement> -> <Return Start>
+		if (can_start(FIRST(NT_RETURN_START))) {
+			Productions.push_back(PROD_STATEMENT_RETURN);
+			if (Statement_node* statement = Return_Start()) {
+				return statement;
+			}
+			rollback(initial);
+		}
 
-void Syntax_Analyzer::Statement() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+		if (can_start(FIRST(NT_PRINT))) {  // Case 5: <Statement> -> <Print>
+			Productions.push_back(PROD_STATEMENT_PRINT);
+			if (Statement_node* statement = Print()) {
+				return statement;
+			}
+			rollback(initial);
+		}
 
-	try {  // Case 1: <Statement> -> <Compound>
-		Productions.push_back("\t<Statement> -> <Compound>");
-		Compound();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
+		if (can_start(FIRST(NT_SCAN))) {  // Case 6: <Statement> -> <Scan>
+			Productions.push_back(PROD_STATEMENT_SCAN);
+			if (Statement_node* statement = Scan()) {
+				return statement;
+			}
+			rollback(initial);
+		}
 
-	try {  // Case 2: <Statement> -> <Assign>
-		Productions.push_back("\t<Statement> -> <Assign>");
-		Assign();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
+		if (can_start(FIRST(NT_WHILE))) {  // Case 7: <Statement> -> <While>
+			Productions.push_back(PROD_STATEMENT_WHILE);
+			if (Statement_node* statement = While()) {
+				begin_statement(statement, STEP_WHILE_START, initial);
+				return statement;
+			}
+			rollback(initial);
+		}
 
-	try {  // Case 3: <Statement> -> <If Start>
-		Productions.push_back("\t<Statement> -> <If Start>");
-		If_Start();
-		return;
+		// No matches
+		Productions.push_back(PROD_STATEMENT_NO_MATCH);
+		remember_failure(start);
+		return nullptr;
 	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	catch (Syntax_error&) {
+		return recover_statement(initial);
 	}
+}
 
-	try {  // Case 4: <Statement> -> <Return Start>
-		Productions.push_back("\t<Statement> -> <Return Start>");
-		Return_Start();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
 
-	try {  // Case 5: <Statement> -> <Print>
-		Productions.push_back("\t<Statement> -> <Print>");
-		Print();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+Statement_node* Syntax_Analyzer::Compound() {
+	Rule_start start;
+	if (recall_failure(NT_COMPOUND, start)) {
+		return nullptr;
 	}
 
-	try {  // Case 6: <Statement> -> <Scan>
-		Productions.push_back("\t<Statement> -> <Scan>");
-		Scan();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
+	Productions.push_back(PROD_COMPOUND);
 
-	try {  // Case 7: <Statement> -> <While>
-		Productions.push_back("\t<Statement> -> <While>");
-		While();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (!check_symbol(SEPARATOR_LEFT_BRACE)) {
+		remember_failure(start);
+		return nullptr;
 	}
-
-	// No matches
-	Productions.push_back("\t<Statement> -> <Compound> | <Assign> |"
-						  " <If Start> | <Return Start> | <Print> | <Scan>"
-						  " | <While>");
-	throw -1;
+	Statement_node* compound = arena.make<Statement_node>();
+	compound->kind = STATEMENT_COMPOUND;
+	compound->line = matched_token.line;
+	return compound;
+	// (its statements and '}' are read by Statement_List_Start())
 }
 
 
-void Syntax_Analyzer::Compound() {
-	Productions.push_back("\t<Compound> -> { <Statement List Start> }");
-
-	try { check_symbol("{"); }
-	catch (int err) { throw -1; }
-
-	try { Statement_List_Start(); }
-	catch (int err) {
-		print_error("Compound statement is missing inside statement(s)");
-	}
-
-	try { check_symbol("}"); }
-	catch (int err) {
-		print_error("Missing '}' at end of Compound statement");
+Statement_node* Syntax_Analyzer::Assign() {
+	Rule_start start;
+	if (recall_failure(NT_ASSIGN, start)) {
+		return nullptr;
 	}
-}
 
+	Productions.push_back(PROD_ASSIGN);
 
-void Syntax_Analyzer::Assign() {
-	Productions.push_back("\t<Assign> -> <Identifier> = <Expression Start> ;");
-
-	try { check_symbol("<identifier>"); }
-	catch (int err) { throw -1; }
+	if (!check_symbol(SYMBOL_IDENTIFIER)) {
+		remember_failure(start);
+		return nullptr;
+	}
+	Statement_node* assign = arena.make<Statement_node>();
+	assign->kind = STATEMENT_ASSIGN;
+	assign->line = matched_token.line;
+	assign->target = matched_lexeme();
 
-	try { check_symbol("="); }
-	catch (int err) {
+	if (!check_symbol(OPERATOR_ASSIGN)) {
 		print_error("Missing '=' for assign statement");
 	}
 
-	try { Expression_Start(); }
-	catch (int err) {
+	assign->expression = Expression_Start();
+	if (!assign->expression) {
 		print_error("Missing expression for assign statement");
 	}
 
-	try { check_symbol(";"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_SEMICOLON)) {
 		print_error("Missing ';' at end of assign statement");
 	}
+	return assign;
 }
 
 
-void Syntax_Analyzer::If_Start() {
-	Productions.push_back("\t<If Start> -> if ( <Condition> ) <Statement>"
-						  " <If Cont>");
-
-	try { check_symbol("if"); }
-	catch (int err) {
-		throw -1;
+Statement_node* Syntax_Analyzer::If_Start() {
+	Rule_start start;
+	if (recall_failure(NT_IF_START, start)) {
+		return nullptr;
 	}
 
-	try { check_symbol("("); }
-	catch (int err) {
-		print_error("Missing '(' before condition of if statement");
+	Productions.push_back(PROD_IF_START);
+
+	if (!check_symbol(KEYWORD_IF)) {
+		remember_failure(start);
+		return nullptr;
 	}
+	Statement_node* if_statement = arena.make<Statement_node>();
+	if_statement->kind = STATEMENT_IF;
+	if_statement->line = matched_token.line;
 
-	Condition();
+	try {
+		if (!check_symbol(SEPARATOR_LEFT_PAREN)) {
+			print_error("Missing '(' before condition of if statement");
+		}
 
-	try { check_symbol(")"); }
-	catch (int err) {
-		print_error("Missing ')' after condition of if statement");
-	}
+		if_statement->condition = Condition();
 
-	try { Statement(); }
-	catch (int err) {
-		print_error("Missing statement for satisfied if condition");
+		if (!check_symbol(SEPARATOR_RIGHT_PAREN)) {
+			print_error("Missing ')' after condition of if statement");
+		}
 	}
-
-	If_Cont();
+	catch (Syntax_error&) {
+		skip_condition();  // go on with the statement after the condition
+	}
+	return if_statement;
+	// (its statement and <If Cont> are read by Statement_List_Start())
 }
 
 
-void Syntax_Analyzer::If_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+bool Syntax_Analyzer::If_Cont() {
+	Checkpoint initial = checkpoint();
 
-	try {  // Case 1: <If Cont> -> else <Statement> fi
-		Productions.push_back("\t<If Cont> -> else <Statement> fi");
-		check_symbol("else");
-		try { Statement(); }
-		catch (int err) {
-			print_error("Missing statement for"
-						" satisfied else condition of if statement");
-		}
-		try { check_symbol("fi"); }
-		catch (int err) {
-			print_error("Missing 'fi' at end of if statement");
+	// Case 1: <If Cont> -> else <Statement> fi
+	if (can_start(symbol_set(KEYWORD_ELSE))) {
+		Productions.push_back(PROD_IF_CONT_ELSE);
+		if (check_symbol(KEYWORD_ELSE)) {
+			return true;  // (the rest is read by Statement_List_Start())
 		}
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		rollback(initial);
 	}
 
-	try {  // Case 2: <If Cont> -> fi
-		Productions.push_back("\t<If Cont> -> fi");
-		check_symbol("fi");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (can_start(symbol_set(KEYWORD_FI))) {  // Case 2: <If Cont> -> fi
+		Productions.push_back(PROD_IF_CONT_FI);
+		if (check_symbol(KEYWORD_FI)) {
+			return false;
+		}
+		rollback(initial);
 	}
 
 	// No matches
-	Productions.push_back("\t<If Cont> -> fi | else <Statement> fi");
+	Productions.push_back(PROD_IF_CONT_NO_MATCH);
 	print_error("if statement is missing 'fi' or 'else' statement 'fi' at end");
+	return false;
 }
 
 
-void Syntax_Analyzer::Return_Start() {
-	Productions.push_back("\t<Return Start> -> return <Return Cont>");
+Statement_node* Syntax_Analyzer::Return_Start() {
+	Rule_start start;
+	if (recall_failure(NT_RETURN_START, start)) {
+		return nullptr;
+	}
+
+	Productions.push_back(PROD_RETURN_START);
 
-	try { check_symbol("return"); }
-	catch (int err) { throw -1; }
+	if (!check_symbol(KEYWORD_RETURN)) {
+		remember_failure(start);
+		return nullptr;
+	}
+	Statement_node* return_statement = arena.make<Statement_node>();
+	return_statement->kind = STATEMENT_RETURN;
+	return_statement->line = matched_token.line;
 
-	Return_Cont();
+	return_statement->expression = Return_Cont();
+	return return_statement;
 }
 
 
-void Syntax_Analyzer::Return_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+Expression_node* Syntax_Analyzer::Return_Cont() {
+	Checkpoint initial = checkpoint();
 
-	try {  // Case 1: <Return Cont> -> <Expression Start> ;
-		Productions.push_back("\t<Return Cont> -> <Expression Start> ;");
-		Expression_Start();
-		try { check_symbol(";"); }
-		catch (int err) {
-			print_error("Missing ';' at end of return statement's expression");
+	// Case 1: <Return Cont> -> <Expression Start> ;
+	if (can_start(FIRST(NT_EXPRESSION_START))) {
+		Productions.push_back(PROD_RETURN_CONT_EXPRESSION);
+		if (Expression_node* expression = Expression_Start()) {
+			if (!check_symbol(SEPARATOR_SEMICOLON)) {
+				print_error("Missing ';' at end of return statement's"
+							" expression");
+			}
+			return expression;
 		}
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		rollback(initial);
 	}
 
-	try {  // Case 2: <Return Cont> -> ;
-		Productions.push_back("\t<Return Cont> -> ;");
-		check_symbol(";");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	// Case 2: <Return Cont> -> ;
+	if (can_start(symbol_set(SEPARATOR_SEMICOLON))) {
+		Productions.push_back(PROD_RETURN_CONT_SEMICOLON);
+		if (check_symbol(SEPARATOR_SEMICOLON)) {
+			return nullptr;
+		}
+		rollback(initial);
 	}
-	
+
 	// No matches
-	Productions.push_back("\t<Return Cont> -> <Expression Start> ; | ;");
+	Productions.push_back(PROD_RETURN_CONT_NO_MATCH);
 	print_error("Missing ';' or expression and ';' at end of return statement");
+	return nullptr;
 }
 
 
-void Syntax_Analyzer::Print() {
-	Productions.push_back("\t<Print> -> put ( <Expression Start> ) ;");
+Statement_node* Syntax_Analyzer::Print() {
+	Rule_start start;
+	if (recall_failure(NT_PRINT, start)) {
+		return nullptr;
+	}
 
-	try { check_symbol("put"); }
-	catch (int err) { throw -1; }
+	Productions.push_back(PROD_PRINT);
 
-	try { check_symbol("("); }
-	catch (int err) {
+	if (!check_symbol(KEYWORD_PUT)) {
+		remember_failure(start);
+		return nullptr;
+	}
+	Statement_node* print = arena.make<Statement_node>();
+	print->kind = STATEMENT_PRINT;
+	print->line = matched_token.line;
+
+	if (!check_symbol(SEPARATOR_LEFT_PAREN)) {
 		print_error("Missing '(' after 'put' of print statement");
 	}
 
-	try { Expression_Start(); }
-	catch (int err) {
+	print->expression = Expression_Start();
+	if (!print->expression) {
 		print_error("Missing expression inside print statement");
 	}
 
-	try { check_symbol(")"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_RIGHT_PAREN)) {
 		print_error("Missing ')' after expression of print statement");
 	}
 
-	try { check_symbol(";"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_SEMICOLON)) {
 		print_error("Missing ';' at end of print statement");
 	}
+	return print;
 }
 
 
-void Syntax_Analyzer::Scan() {
-	Productions.push_back("\t<Scan> -> get ( <IDs Start> ) ;");
+Statement_node* Syntax_Analyzer::Scan() {
+	Rule_start start;
+	if (recall_failure(NT_SCAN, start)) {
+		return nullptr;
+	}
 
-	try { check_symbol("get"); }
-	catch (int err) { throw -1; }
+	Productions.push_back(PROD_SCAN);
 
-	try { check_symbol("("); }
-	catch (int err) {
+	if (!check_symbol(KEYWORD_GET)) {
+		remember_failure(start);
+		return nullptr;
+	}
+	Statement_node* scan = arena.make<Statement_node>();
+	scan->kind = STATEMENT_SCAN;
+	scan->line = matched_token.line;
+
+	if (!check_symbol(SEPARATOR_LEFT_PAREN)) {
 		print_error("Missing '(' after 'get' of scan statement");
 	}
 
-	try { IDs_Start(); }
-	catch (int err) {
+	scan->ids = IDs_Start();
+	if (!scan->ids) {
 		print_error("Missing identifier(s) inside scan statement");
 	}
 
-	try { check_symbol(")"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_RIGHT_PAREN)) {
 		print_error("Missing ')' after identifier(s) of scan statement");
 	}
 
-	try { check_symbol(";"); }
-	catch (int err) {
+	if (!check_symbol(SEPARATOR_SEMICOLON)) {
 		print_error("Missing ';' at end of scan statement");
 	}
+	return scan;
 }
 
 
-void Syntax_Analyzer::While() {
-	Productions.push_back("\t<While> -> while ( <Condition> )"
-						  " <Statement> endwhile");
+Statement_node* Syntax_Analyzer::While() {
+	Rule_start start;
+	if (recall_failure(NT_WHILE, start)) {
+		return nullptr;
+	}
 
-	try { check_symbol("while"); }
-	catch (int err) { throw -1; }
+	Productions.push_back(PROD_WHILE);
 
-	try { check_symbol("("); }
-	catch (int err) {
-		print_error("Missing '(' before condition of while statement");
+	if (!check_symbol(KEYWORD_WHILE)) {
+		remember_failure(start);
+		return nullptr;
 	}
+	Statement_node* while_statement = arena.make<Statement_node>();
+	while_statement->kind = STATEMENT_WHILE;
+	while_statement->line = matched_token.line;
 
-	Condition();
+	try {
+		if (!check_symbol(SEPARATOR_LEFT_PAREN)) {
+			print_error("Missing '(' before condition of while statement");
+		}
 
-	try { check_symbol(")"); }
-	catch (int err) {
-		print_error("Missing ')' after condition of while statement");
-	}
+		while_statement->condition = Condition();
 
-	try { Statement(); }
-	catch (int err) {
-		print_error("Missing statement(s) inside of while loop");
+		if (!check_symbol(SEPARATOR_RIGHT_PAREN)) {
+			print_error("Missing ')' after condition of while statement");
+		}
 	}
-
-	try { check_symbol("endwhile"); }
-	catch (int err) {
-		print_error("Missing 'endwhile' at end of while statement");
+	catch (Syntax_error&) {
+		skip_condition();
 	}
+	return while_statement;
+	// (its statement and 'endwhile' are read by Statement_List_Start())
 }
 
 
-void Syntax_Analyzer::Condition() {
-	Productions.push_back("\t<Condition> -> <Expression Start> <Relop>"
-						  " <Expression Start>");
+Condition_node Syntax_Analyzer::Condition() {
+	Productions.push_back(PROD_CONDITION);
+	Condition_node condition = {};
 
-	try { Expression_Start(); }
-	catch (int err) {
+	condition.left = Expression_Start();
+	if (!condition.left) {
 		print_error("Missing LHS expression for condition");
 	}
 
-	Relop();
+	condition.relop = Relop();
 
-	try { Expression_Start(); }
-	catch (int err) {
+	condition.right = Expression_Start();
+	if (!condition.right) {
 		print_error("Missing RHS expression for condition");
 	}
+	return condition;
 }
 
 
-void Syntax_Analyzer::Relop() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+Symbol_id Syntax_Analyzer::Relop() {
+	Checkpoint initial = checkpoint();
 
-	try {  // Case 1: ==
-		Productions.push_back("\t<Relop> -> ==");
-		check_symbol("==");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (can_start(symbol_set(OPERATOR_EQUAL))) {  // Case 1: ==
+		Productions.push_back(PROD_RELOP_EQUAL);
+		if (check_symbol(OPERATOR_EQUAL)) {
+			return OPERATOR_EQUAL;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 2: !=
-		Productions.push_back("\t<Relop> -> !=");
-		check_symbol("!=");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (can_start(symbol_set(OPERATOR_NOT_EQUAL))) {  // Case 2: !=
+		Productions.push_back(PROD_RELOP_NOT_EQUAL);
+		if (check_symbol(OPERATOR_NOT_EQUAL)) {
+			return OPERATOR_NOT_EQUAL;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 3: >
-		Productions.push_back("\t<Relop> -> >");
-		check_symbol(">");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (can_start(symbol_set(OPERATOR_GREATER))) {  // Case 3: >
+		Productions.push_back(PROD_RELOP_GREATER);
+		if (check_symbol(OPERATOR_GREATER)) {
+			return OPERATOR_GREATER;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 4: <
-		Productions.push_back("\t<Relop> -> <");
-		check_symbol("<");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (can_start(symbol_set(OPERATOR_LESS))) {  // Case 4: <
+		Productions.push_back(PROD_RELOP_LESS);
+		if (check_symbol(OPERATOR_LESS)) {
+			return OPERATOR_LESS;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 5: <=
-		Productions.push_back("\t<Relop> -> <=");
-		check_symbol("<=");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (can_start(symbol_set(OPERATOR_LESS_EQUAL))) {  // Case 5: <=
+		Productions.push_back(PROD_RELOP_LESS_EQUAL);
+		if (check_symbol(OPERATOR_LESS_EQUAL)) {
+			return OPERATOR_LESS_EQUAL;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 6: =>
-		Productions.push_back("\t<Relop> -> =>");
-		check_symbol("=>");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	if (can_start(symbol_set(OPERATOR_GREATER_EQUAL))) {  // Case 6: =>
+		Productions.push_back(PROD_RELOP_GREATER_EQUAL);
+		if (check_symbol(OPERATOR_GREATER_EQUAL)) {
+			return OPERATOR_GREATER_EQUAL;
+		}
+		rollback(initial);
 	}
 
 	// No matches
-	Productions.push_back("\t<Relop> -> == | != | > | < | <= | =>");
+	Productions.push_back(PROD_RELOP_NO_MATCH);
 	print_error("Missing relational operator for condition");
+	return SYMBOL_NONE;
 }
 
 
-void Syntax_Analyzer::Expression_Start() {
-	Productions.push_back("\t<Expression Start> -> <Term Start> <Expression"
-						  " Cont>");
-
-	try { Term_Start(); }
-	catch (int err) { throw -1; }
-
-	Expression_Cont();
-}
-
-
-void Syntax_Analyzer::Expression_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	try {  // Case 1: <Expression Cont> -> + <Term Start> <Expression Cont>
-		Productions.push_back("\t<Expression Cont> -> + <Term Start>"
-							  " <Expression Cont>");
-
-		check_symbol("+");
-
-		try { Term_Start(); }
-		catch (int err) {
-			print_error("Missing Term after '+'");
-		}
-
-		Expression_Cont();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
-
-	try {  // Case 2: <Expression Cont> -> - <Term Start> <Expression Cont>
-		Productions.push_back("\t<Expression Cont> -> - <Term Start>"
-							  " <Expression Cont>");
-
-		check_symbol("-");
-
-		try { Term_Start(); }
-		catch (int err) {
-			print_error("Missing Term after '-'");
+/******************************************************************************
+| <Expression Start> -> <Term Start> <Expression Cont> and <Term Start> ->    |
+| <Factor> <Term Cont> are two levels of binary operators: + and - bind less  |
+| tightly than * and /. Instead of calling <Expression Cont> and <Term Cont>  |
+| again for every operator (which recursed once per operand), the operators   |
+| are read by one loop (precedence climbing), so a long expression doesn't    |
+| use more stack than a short one.                                            |
+******************************************************************************/
+struct Binary_operator {
+	Symbol_id symbol;
+	Production_id production;  // ie. <Expression Cont> -> + <Term Start> ...
+	const char* missing_operand;  // error if nothing follows the operator
+};
+
+struct Operator_level {
+	Production_id start;  // <Expression Start> or <Term Start>
+	Production_id empty;  // its <Cont> -> <Empty>
+	Binary_operator operators[2];
+};
+
+static const Operator_level OPERATOR_LEVELS[] = {  // lowest precedence first
+	{ PROD_EXPRESSION_START, PROD_EXPRESSION_CONT_EMPTY,
+	  { { OPERATOR_PLUS, PROD_EXPRESSION_CONT_PLUS, "Missing Term after '+'" },
+		{ OPERATOR_MINUS, PROD_EXPRESSION_CONT_MINUS,
+		  "Missing Term after '-'" } } },
+	{ PROD_TERM_START, PROD_TERM_CONT_EMPTY,
+	  { { OPERATOR_MULTIPLY, PROD_TERM_CONT_MULTIPLY,
+		  "Missing Factor after '*'" },
+		{ OPERATOR_DIVIDE, PROD_TERM_CONT_DIVIDE,
+		  "Missing Factor after '/'" } } }
+};
+static_assert(sizeof(OPERATOR_LEVELS) / sizeof(OPERATOR_LEVELS[0])
+			  == OPERATOR_LEVEL_COUNT, "one Expression_frame value per level");
+
+// the operator of the given level that the symbol is (null if it isn't one)
+static const Binary_operator* find_operator(std::size_t level,
+											Symbol_id symbol) {
+	for (const Binary_operator& op : OPERATOR_LEVELS[level].operators) {
+		if (op.symbol == symbol) {
+			return &op;
 		}
-
-		Expression_Cont();
-		return;
 	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
-
-	// Case 3: <Expression Cont> -> <Empty>
-	Productions.push_back("\t<Expression Cont> -> <Empty>");
-}
-
-
-void Syntax_Analyzer::Term_Start() {
-	Productions.push_back("\t<Term Start> -> <Factor> <Term Cont>");
-
-	try { Factor(); }
-	catch (int err) { throw -1; }
-
-	Term_Cont();
+	return nullptr;
 }
 
+/******************************************************************************
+| Each level that is open has a value: the expression on the left of its next |
+| operator (a - b - c is built as (a - b) - c). After an operator, the levels |
+| above it are opened again, and the operand (a <Factor>) is read. A level is |
+| closed (<Cont> -> <Empty>) when the current token isn't one of its          |
+| operators, and its value becomes the right side of the operator below it.   |
+| The productions, errors, and AST are the same as those of the recursive     |
+| <Expression Cont> and <Term Cont>: each one is added at the same token.     |
+| The operators are picked by the current token in both parse modes (trying   |
+| the other ones would only add productions that are rolled back again).      |
+******************************************************************************/
+Expression_node* Syntax_Analyzer::Expression_Start() {
+	// an expression inside ( ) is a new <Expression Start>, which gets a frame
+	// of its own on top of the one it is in (instead of a recursive call), so
+	// deeply nested parentheses don't use up the native stack
+	std::vector<Expression_frame>& frames = expression_frames;
+	frames.clear();  // (never used by more than one expression at a time)
+	frames.push_back(Expression_frame());
+
+	bool begin = true;  // (the frame on top is a new <Expression Start>)
+	Expression_node* operand = nullptr;  // (the operand was given by ')')
+	bool closed = false;  // the one on top is done, and its value is operand
+	while (true) {
+		Expression_frame& frame = frames.back();
+		if (begin) {
+			begin = false;
+			if (recall_failure(NT_EXPRESSION_START, frame.start)) {
+				operand = nullptr;
+				closed = true;
+			}
+		}
 
-void Syntax_Analyzer::Term_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	try {  // Case 1: <Term Cont> -> * <Factor> <Term Cont>
-		Productions.push_back("\t<Term Cont> -> * <Factor> <Term Cont>");
-
-		check_symbol("*");
+		if (!closed && !operand) {
+			for (std::size_t open = frame.level; open < OPERATOR_LEVEL_COUNT;
+				 open++) {
+				Productions.push_back(OPERATOR_LEVELS[open].start);
+			}
 
-		try { Factor(); }
-		catch (int err) {
-			print_error("Missing Factor after '*'");
+			bool opened = false;
+			operand = Factor(opened);
+			if (opened) {  // <Primary Start> -> ( <Expression Start> )
+				if (frames.size() > max_depth && max_depth != 0) {
+					nesting_error("Parentheses");
+				}
+				frame.negative = operand;
+				frames.push_back(Expression_frame());
+				begin = true;
+				operand = nullptr;
+				continue;
+			}
+			if (!operand) {
+				if (frame.op == nullptr) {  // (not even one operand)
+					remember_failure(frame.start);
+					closed = true;
+				}
+				else {
+					print_error(frame.op->missing_operand);
+				}
+			}
 		}
 
-		Term_Cont();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
-	}
-
-	try {  // Case 2: <Term Cont> -> / <Factor> <Term Cont>
-		Productions.push_back("\t<Term Cont> -> / <Factor> <Term Cont>");
+		if (!closed) {
+			std::size_t level = OPERATOR_LEVEL_COUNT - 1;
+			if (frame.value[level]) {  // (the right side of an operator)
+				frame.value[level]->right = operand;
+			}
+			else {
+				frame.value[level] = operand;
+			}
+			operand = nullptr;
+
+			// close levels until the current token is an operator of one
+			read_token();
+			while (true) {
+				frame.op = find_operator(level, current_token.symbol);
+				if (frame.op) {
+					break;
+				}
+				Productions.push_back(OPERATOR_LEVELS[level].empty);
+				if (level == 0) {
+					break;
+				}
+				if (frame.value[level - 1]) {
+					frame.value[level - 1]->right = frame.value[level];
+				}
+				else {
+					frame.value[level - 1] = frame.value[level];
+				}
+				frame.value[level--] = nullptr;
+			}
 
-		check_symbol("/");
+			if (frame.op) {
+				Productions.push_back(frame.op->production);
+				check_symbol(frame.op->symbol);
+				frame.value[level] = make_binary(frame.op->symbol,
+												 frame.value[level]);
+				frame.level = level + 1;
+				continue;
+			}
+			operand = frame.value[0];
+		}
 
-		try { Factor(); }
-		catch (int err) {
-			print_error("Missing Factor after '/'");
+		// the expression on top is done (operand is its value, null if there
+		// wasn't one)
+		closed = false;
+		frames.pop_back();
+		if (frames.empty()) {
+			return operand;
 		}
 
-		Term_Cont();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		// the rest of <Primary Start> -> ( <Expression Start> ), and of
+		// <Factor> -> - <Primary Start> if it was negative
+		if (!operand) {
+			print_error("Missing expression between parantheses");
+		}
+		if (!check_symbol(SEPARATOR_RIGHT_PAREN)) {
+			print_error("Missing ')' to close expression");
+		}
+		Expression_frame& outer = frames.back();
+		if (outer.negative) {
+			outer.negative->left = operand;
+			operand = outer.negative;
+			outer.negative = nullptr;
+		}
 	}
-
-	// Case 3: <Term Cont> -> <Empty>
-	Productions.push_back("\t<Term Cont> -> <Empty>");
 }
 
 
-void Syntax_Analyzer::Factor() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+Expression_node* Syntax_Analyzer::Factor(bool& opened) {
+	Rule_start start;
+	if (recall_failure(NT_FACTOR, start)) {
+		return nullptr;
+	}
 
-	try {  // Case 1: <Factor> -> - <Primary>
-		Productions.push_back("\t<Factor> -> - <Primary Start>");
+	Checkpoint initial = checkpoint();
 
-		check_symbol("-");
+	// Case 1: <Factor> -> - <Primary>
+	if (can_start(symbol_set(OPERATOR_MINUS))) {
+		Productions.push_back(PROD_FACTOR_NEGATIVE);
 
-		try { Primary_Start(); }
-		catch (int err) {
-			print_error("Missing Primary expression after '-'");
-		}
+		if (check_symbol(OPERATOR_MINUS)) {
+			Expression_node* negative = make_expression(EXPRESSION_NEGATE);
+			negative->left = Primary_Start(opened);
+			if (!negative->left && !opened) {
+				print_error("Missing Primary expression after '-'");
+			}
 
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+			return negative;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 2: <Factor> -> <Primary>
-		Productions.push_back("\t<Factor> -> <Primary Start>");
+	// Case 2: <Factor> -> <Primary>
+	if (can_start(FIRST(NT_PRIMARY_START))) {
+		Productions.push_back(PROD_FACTOR_PRIMARY);
 
-		Primary_Start();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		Expression_node* primary = Primary_Start(opened);
+		if (primary || opened) {
+			return primary;
+		}
+		rollback(initial);
 	}
 
 	// No matches
-	Productions.push_back("\t<Factor> -> - <Primary Start> | <Primary Start>");
-	throw -1;
+	Productions.push_back(PROD_FACTOR_NO_MATCH);
+	remember_failure(start);
+	return nullptr;
 }
 
 
-void Syntax_Analyzer::Primary_Start() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
-
-	try {  // Case 1: <Primary Start> -> <Identifier> <Primary Cont>
-		Productions.push_back("\t<Primary Start> -> <Identifier> <Primary"
-							  " Cont>");
-
-		check_symbol("<identifier>");
-		Primary_Cont();
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+Expression_node* Syntax_Analyzer::Primary_Start(bool& opened) {
+	Rule_start start;
+	if (recall_failure(NT_PRIMARY_START, start)) {
+		return nullptr;
 	}
 
-	try {  // Case 2: <Primary Start> -> <Integer>
-		Productions.push_back("\t<Primary Start> -> <Integer>");
+	Checkpoint initial = checkpoint();
 
-		check_symbol("<integer>");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+	// Case 1: <Primary Start> -> <Identifier> <Primary Cont>
+	if (can_start(symbol_set(SYMBOL_IDENTIFIER))) {
+		Productions.push_back(PROD_PRIMARY_IDENTIFIER);
+
+		if (check_symbol(SYMBOL_IDENTIFIER)) {
+			Expression_node* identifier =
+				make_expression(EXPRESSION_IDENTIFIER);
+			identifier->arguments = Primary_Cont();
+			if (identifier->arguments) {
+				identifier->kind = EXPRESSION_CALL;
+			}
+			return identifier;
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 3: <Primary Start> -> ( <Expression Start> )
-		Productions.push_back("\t<Primary Start> -> ( <Expression Start> )");
-		check_symbol("(");
+	// Case 2: <Primary Start> -> <Integer>
+	if (can_start(symbol_set(SYMBOL_INTEGER))) {
+		Productions.push_back(PROD_PRIMARY_INTEGER);
 
-		try { Expression_Start(); }
-		catch (int err) {
-			print_error("Missing expression between parantheses");
+		if (check_symbol(SYMBOL_INTEGER)) {
+			return make_expression(EXPRESSION_INTEGER);
 		}
+		rollback(initial);
+	}
 
-		try { check_symbol(")"); }
-		catch (int err) {
-			print_error("Missing ')' to close expression");
+	// Case 3: <Primary Start> -> ( <Expression Start> )
+	if (can_start(symbol_set(SEPARATOR_LEFT_PAREN))) {
+		Productions.push_back(PROD_PRIMARY_PARENTHESES);
+		if (check_symbol(SEPARATOR_LEFT_PAREN)) {
+			// the rest is read by Expression_Start(), which tells a '(' apart
+			// from a failure by opened
+			opened = true;
+			return nullptr;
 		}
-
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		rollback(initial);
 	}
 
-	try {  // Case 4: <Primary Start> -> <Real>
-		Productions.push_back("\t<Primary Start> -> <Real>");
+	// Case 4: <Primary Start> -> <Real>
+	if (can_start(symbol_set(SYMBOL_REAL))) {
+		Productions.push_back(PROD_PRIMARY_REAL);
 
-		check_symbol("<real>");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		if (check_symbol(SYMBOL_REAL)) {
+			return make_expression(EXPRESSION_REAL);
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 5: <Primary Start> -> true
-		Productions.push_back("\t<Primary Start> -> true");
+	// Case 5: <Primary Start> -> true
+	if (can_start(symbol_set(KEYWORD_TRUE))) {
+		Productions.push_back(PROD_PRIMARY_TRUE);
 
-		check_symbol("true");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		if (check_symbol(KEYWORD_TRUE)) {
+			return make_expression(EXPRESSION_TRUE);
+		}
+		rollback(initial);
 	}
 
-	try {  // Case 6: <Primary Start> -> false
-		Productions.push_back("\t<Primary Start> -> false");
+	// Case 6: <Primary Start> -> false
+	if (can_start(symbol_set(KEYWORD_FALSE))) {
+		Productions.push_back(PROD_PRIMARY_FALSE);
 
-		check_symbol("false");
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		if (check_symbol(KEYWORD_FALSE)) {
+			return make_expression(EXPRESSION_FALSE);
+		}
+		rollback(initial);
 	}
 
 	// No matches
-	Productions.push_back("\t<Primary Start> -> <Identifier> <Primary"
-						  " Cont> | <Integer> | ( <Expression Start> ) |"
-						  " <Real> | true | false");
-	throw -1;
+	Productions.push_back(PROD_PRIMARY_NO_MATCH);
+	remember_failure(start);
+	return nullptr;
 }
 
 
-void Syntax_Analyzer::Primary_Cont() {
-	Rule_list initial_list;
-	copy_list(Productions, initial_list);
+Identifier_node* Syntax_Analyzer::Primary_Cont() {
+	Checkpoint initial = checkpoint();
 
-	try {  // Case 1: <Primary Cont> -> ( <IDs Start> )
-		Productions.push_back("\t<Primary Cont> -> ( <IDs Start> )");
+	// Case 1: <Primary Cont> -> ( <IDs Start> )
+	if (can_start(symbol_set(SEPARATOR_LEFT_PAREN))) {
+		Productions.push_back(PROD_PRIMARY_CONT);
 
-		check_symbol("(");
+		if (check_symbol(SEPARATOR_LEFT_PAREN)) {
+			Identifier_node* arguments = IDs_Start();
+			if (!arguments) {
+				print_error("Missing identifier(s) for Primary function()"
+							" call");
+			}
 
-		try { IDs_Start(); }
-		catch (int err) {
-			print_error("Missing identifier(s) for Primary function() call");
-		}
+			if (!check_symbol(SEPARATOR_RIGHT_PAREN)) {
+				print_error("Missing ')' for Primary function() call");
+			}
 
-		try { check_symbol(")"); }
-		catch (int err) {
-			print_error("Missing ')' for Primary function() call");
+			return arguments;
 		}
-
-		return;
-	}
-	catch (int err) {
-		copy_list(initial_list, Productions);
+		rollback(initial);
 	}
 
 	// Case 2: <Primary Cont> -> <Empty>
-	Productions.push_back("\t<Primary Cont> -> <Empty>");
+	Productions.push_back(PROD_PRIMARY_CONT_EMPTY);
+	return nullptr;
 }
 
 /*******************************************************************************
 | check_symbol checks if the current token matches a terminal symbol (id, int, |
-| real, keyword, sep, op). if it doesn't, it will throw an exception of -1.    |
-| otherwise, if the current token matches the terminal symbol, then the token  |
-| and the list of productions it uses will be printed.                         |
+| real, keyword, sep, op). if it doesn't, it returns false (and nothing is     |
+| read). otherwise, if the current token matches the terminal symbol, then the |
+| token and the list of productions it uses will be printed.                   |
 |                                                                              |
 | in the event that the matched symbol appears on a new line, err_line_number  |
 | is updated to = that new line's number. this update marks where the next     |
 | token is expected to appear (and if it doesn't appear there, an error        |
 | message will print the # of the line where it's expected to appear).         |
+|                                                                              |
+| (note: Rat23S is NOT case sensitive. i.e. both 'function' and 'FuNCtiOn'     |
+| are equivalent keywords. the lexer already gives both the same Symbol_id,    |
+| so every check is a single comparison of ids)                                |
 *******************************************************************************/
-void Syntax_Analyzer::check_symbol(std::string symbol) {
-	// if a token hasn't been read from the lexer yet, call get_token().
-	// otherwise, STAY on the same (current) token - don't skip tokens!!!
-	if (current_token.first == "") {
-		while (true) {
-			current_token = lexer->get_token();
-			// when looking for new tokens, skip over comments
-			if (current_token.first != "comment") {
-				break;
-			}
-		}
+bool Syntax_Analyzer::check_symbol(Symbol_id symbol) {
+	read_token();
+
+	// if current token doesn't match expected symbol, it isn't used
+	if (current_token.symbol != symbol) {
+		return false;
 	}
 
-	// <Identifier>, <Integer>, or <Real>
-	if (symbol == "<identifier>" || symbol == "<integer>"
-		|| symbol == "<real>") {
+	// otherwise, print the token and its productions
+	if (trace && ofs != nullptr) {
+		print_current_token();
+		print_productions();
+	}
 
-		// if current token doesn't match expected symbol, throw exception
-		if (current_token.first != symbol.substr(1, symbol.find(">") - 1)) {
-			throw -1;
-		}
-		else {  // otherwise, print the token and its productions
-			print_current_token();
-			print_productions();
+	// update where next symbol is expected to appear (line #)
+	err_line_number = current_token.line;
+	matched_token = current_token;  // (for the AST)
+	matched_count++;
 
-			// reset everything for next token
-			current_token = { "", "" };
-			Productions.clear();
+	// reset everything for next token
+	current_token = NO_TOKEN;
+	Productions.clear();
+	return true;
+}
 
-			// update where next symbol is expected to appear (line #)
-			err_line_number = lexer->get_line_number();
-			return;
+// if a token hasn't been read from the token stream yet, read the next one.
+// otherwise, STAY on the same (current) token - don't skip tokens!!!
+// (comments were already removed from the stream by the lexer)
+void Syntax_Analyzer::read_token() {
+	if (current_token.kind == TOKEN_NONE) {
+		if (next_token == tokens->tokens.size()) {  // (only when pipelined)
+			receive_token();
 		}
-	}
-	// EOF
-	else if (symbol == "EOF") {
-		if (current_token.first != "EOF") {
-			throw -1;
+		current_token = tokens->tokens[next_token];
+		if (current_token.kind != TOKEN_EOF) {  // stay on EOF at end
+			next_token++;
 		}
-		else {
-			print_current_token();
-			print_productions();
-			current_token = { "", "" };
-			Productions.clear();
-			err_line_number = lexer->get_line_number();
-			return;
-		}
-	}
-	// keywords, operators, separators
-	// (note: Rat23S is NOT case sensitive. i.e. both 'function' and 'FuNCtiOn'
-	// are equivalent keywords. so, current symbol is converted to all lowercase
-	// before checking)
-	std::string lower_lexeme = convert_to_lowercase(current_token.second);
-	if (lower_lexeme != symbol) {
-		throw -1;
-	}
-	else {
-		print_current_token();
-		print_productions();
-		current_token = { "", "" };
-		Productions.clear();
-		err_line_number = lexer->get_line_number();
-		return;
 	}
 }
 
+// waits for the next token from the lexer thread, and keeps it
+void Syntax_Analyzer::receive_token() {
+	Token token = ring->pop();
+	if (token.kind == TOKEN_ERROR) {
+		throw Lexical_error();
+	}
+	received.tokens.push_back(token);
+}
+
+/******************************************************************************
+| can_start is checked before each alternative of a production is tried. In   |
+| predictive mode, it returns true only if the current token is in the        |
+| alternative's FIRST set, so alternatives that would fail on their first     |
+| token are skipped instead of being tried and rolled back. An alternative    |
+| only ever fails on its first token (after that, a missing token is an       |
+| error), and no two alternatives share a first token (FIRST_SETS checks      |
+| this), so both modes end up using the same alternatives.                    |
+******************************************************************************/
+bool Syntax_Analyzer::can_start(Symbol_set first) {
+	if (mode == PARSE_BACKTRACKING) {
+		return true;
+	}
+	read_token();
+	return (first & symbol_set(current_token.symbol)) != 0;
+}
+
 /*****************************************************************************
-| This function makes the list 'copy' have the same contents as 'original'.  |
-| It is used for backtracking (i.e. reverting the list of productions to its |
-| former steps).                                                             |
+| checkpoint() and rollback() are used for backtracking (i.e. reverting the  |
+| list of productions to its former steps). An alternative only ever fails   |
+| before it matches a token, so the productions that were in the list at the |
+| checkpoint are still there when it fails: the alternative only added new   |
+| ones to the end. Rolling back just removes those, without copying or       |
+| allocating anything. The same goes for the AST: any node that the failed   |
+| alternative built is freed by moving the arena back to its mark.           |
 *****************************************************************************/
-void Syntax_Analyzer::copy_list(Rule_list original, Rule_list& copy) {
-	copy.clear();
-	for (int i = 0; i < original.size(); i++) {
-		copy.push_back(original.at(i));
+Checkpoint Syntax_Analyzer::checkpoint() {
+	Checkpoint saved;
+	saved.productions = Productions.size();
+	saved.nodes = arena.mark();
+	return saved;
+}
+
+void Syntax_Analyzer::rollback(Checkpoint saved) {
+	if (Productions.size() > saved.productions) {  // (errors clear the list)
+		Productions.erase(Productions.begin() + saved.productions,
+						  Productions.end());
 	}
+	arena.reset(saved.nodes);
 }
 
-/*******************************************************************************
-| This function returns the lowercase version of 's'. It is called during      |
-| symbol checks since Rat23S is not a case sensitive language (which means     |
-| that COMPARISONS between symbols should be in the same case, i.e. lowercase) |
-*******************************************************************************/
-std::string Syntax_Analyzer::convert_to_lowercase(std::string s) {
-	std::string lower = "";
-	for (int i = 0; i < s.size(); i++) {
-		lower += tolower(s[i]);
+// index of the current token in the token stream (it is read if needed)
+std::size_t Syntax_Analyzer::token_position() {
+	read_token();
+	// (read_token() stays on EOF instead of moving past it)
+	return (current_token.kind == TOKEN_EOF) ? next_token : next_token - 1;
+}
+
+/******************************************************************************
+| Only failures are memoized. A rule only fails before it matches its first   |
+| token (see checkpoint()), so a failure doesn't read any tokens, build any   |
+| AST nodes, or print anything: all it does is add the productions it tried   |
+| to the end of Productions (those are printed with the next token or error). |
+| recall_failure() adds the same productions again, which is exactly what     |
+| running the rule would do. A rule that works always matches a token, and    |
+| the analysis never goes back before a matched token, so it can't be asked   |
+| for again at the same token.                                                |
+******************************************************************************/
+bool Syntax_Analyzer::recall_failure(std::uint8_t rule, Rule_start& start) {
+	if (!memo.enabled()) {
+		return false;
+	}
+	start.rule = rule;
+	start.position = token_position();
+	start.productions = Productions.size();
+
+	std::size_t length = 0;
+	const std::uint8_t* trace = memo.find(rule, start.position, length);
+	if (trace == nullptr) {
+		return false;
+	}
+	for (std::size_t i = 0; i < length; i++) {
+		Productions.push_back(static_cast<Production_id>(trace[i]));
 	}
-	return lower;
+	return true;
+}
+
+void Syntax_Analyzer::remember_failure(const Rule_start& start) {
+	if (memo.enabled() && Productions.size() >= start.productions) {
+		memo.store(start.rule, start.position,
+				   reinterpret_cast<const std::uint8_t*>(Productions.data())
+				   + start.productions,
+				   Productions.size() - start.productions);
+	}
+}
+
+// the name or literal of the token that check_symbol() last matched (it
+// points into the input buffer, so it stays valid as long as the tokens do)
+std::string_view Syntax_Analyzer::matched_lexeme() {
+	return tokens->lexeme(matched_token);
+}
+
+// a new expression node for the token that check_symbol() last matched
+Expression_node* Syntax_Analyzer::make_expression(Expression_kind kind) {
+	Expression_node* node = arena.make<Expression_node>();
+	node->kind = kind;
+	node->line = matched_token.line;
+	node->lexeme = matched_lexeme();
+	return node;
+}
+
+// a new binary expression for the operator that check_symbol() last matched
+Expression_node* Syntax_Analyzer::make_binary(Symbol_id op,
+											  Expression_node* left) {
+	Expression_node* node = make_expression(EXPRESSION_BINARY);
+	node->op = op;
+	node->left = left;
+	return node;
 }
 
 // prints the current token onto the output file
 void Syntax_Analyzer::print_current_token() {
-	if (current_token.first == "") {
+	if (current_token.kind == TOKEN_NONE) {
 		return;
 	}
-	else if (current_token.first == "identifier" ||
-		current_token.first == "separator") {
-		*ofs << "Token: " << current_token.first << "\tLexeme: "
-			<< current_token.second << "\n";
+	else if (current_token.kind == TOKEN_IDENTIFIER ||
+		current_token.kind == TOKEN_SEPARATOR) {
+		*ofs << "Token: " << token_type_name(current_token.kind)
+			<< "\tLexeme: " << tokens->lexeme(current_token) << "\n";
 	}
 	else {  // number of tabs adjusted based on token type length
-		*ofs << "Token: " << current_token.first << "\t\tLexeme: "
-			<< current_token.second << "\n";
+		*ofs << "Token: " << token_type_name(current_token.kind)
+			<< "\t\tLexeme: " << tokens->lexeme(current_token) << "\n";
 	}
 }
 
 // prints the list of productions used by the current token onto the output file
 void Syntax_Analyzer::print_productions() {
-	for (int i = 0; i < Productions.size(); i++) {
-		*ofs << Productions.at(i) << "\n";
+	for (Production_id production : Productions) {
+		*ofs << "\t" << PRODUCTION_TEXT[production] << "\n";
 	}
 }
 
@@ -1212,16 +2060,118 @@ void Syntax_Analyzer::print_productions() {
 | This function prints the given error message (err_msg) onto the output file. |
 | The format of an error message is the line number it occurred, its           |
 | description, the list of productions leading to the error, and the           |
-| unexpected token. Additionally, reaching an error means that the SA phase    |
-| has failed. Thus, the input and output file streams are closed and the       |
-| program exits with an error code of -1.                                      |
+| unexpected token. The error is also recorded, so that Rat23S() can return    |
+| it. An error found before any token was matched since the last one (ie. a    |
+| cascade of errors while recovering) is neither printed nor recorded.         |
 *******************************************************************************/
+void Syntax_Analyzer::report_error(std::string err_msg) {
+	if (matched_count != last_error) {
+		last_error = matched_count;
+		if (ofs != nullptr) {
+			*ofs << err_line_number << ": ERROR - " << err_msg << "\n";
+			if (trace) {
+				print_productions();
+			}
+			*ofs << "\t";
+			print_current_token();
+		}
+
+		Diagnostic diagnostic;
+		diagnostic.line = err_line_number;
+		diagnostic.message = std::move(err_msg);
+		diagnostic.token = current_token;
+		diagnostics.push_back(std::move(diagnostic));
+	}
+	Productions.clear();  // (they were printed with the error)
+}
+
+/******************************************************************************
+| print_error reports the error, then throws a Syntax_error instead of ending |
+| the program. It is caught by the nearest function, declaration, statement,  |
+| or if/while condition that the error is in, which skips the rest of itself  |
+| (see skip_to()) so that the analysis can go on after it. Each of these      |
+| matches at least one token before anything in it can fail, so every error   |
+| moves the analysis forward, and a file with many errors is still checked    |
+| in one pass.                                                                |
+******************************************************************************/
 void Syntax_Analyzer::print_error(std::string err_msg) {
-	*ofs << err_line_number << ": ERROR - " << err_msg << "\n";
-	print_productions();
-	*ofs << "\t";
-	print_current_token();
-	lexer->close_ifs();
-	ofs->close();
-	exit(-1);
-}
\ No newline at end of file
+	report_error(std::move(err_msg));
+	throw Syntax_error();
+}
+
+// skips tokens until the current token is in stop (or is the end of file).
+// skipped tokens aren't printed
+void Syntax_Analyzer::skip_to(Symbol_set stop) {
+	read_token();
+	while (current_token.symbol != SYMBOL_EOF
+		   && (stop & symbol_set(current_token.symbol)) == 0) {
+		current_token = NO_TOKEN;
+		read_token();
+	}
+}
+
+// skips the current token if it is the given symbol (ie. the ';' that ends
+// a broken statement)
+void Syntax_Analyzer::skip_symbol(Symbol_id symbol) {
+	read_token();
+	if (current_token.symbol == symbol) {
+		current_token = NO_TOKEN;
+	}
+}
+
+// after a broken if/while condition, skips to its ')' (which is skipped too),
+// or to the first token that can come after the condition
+void Syntax_Analyzer::skip_condition() {
+	skip_to(symbol_set(SEPARATOR_RIGHT_PAREN) | STATEMENT_SYNC);
+	skip_symbol(SEPARATOR_RIGHT_PAREN);
+}
+
+// pushes the frame of a compound/if/while statement that Statement() has begun
+// (initial is the state before the <Statement>), so that Statement_List_Start()
+// reads the rest of it
+void Syntax_Analyzer::begin_statement(Statement_node* node,
+									  Statement_step step, Checkpoint initial) {
+	if (statement_depth == max_depth && max_depth != 0) {
+		nesting_error("Statements");
+	}
+	statement_depth++;
+	Statement_frame frame = {};
+	frame.step = step;
+	frame.node = node;
+	frame.initial = initial;
+	statement_frames.push_back(frame);
+}
+
+// pops the frame of the compound/if/while statement on top, and returns it
+Statement_node* Syntax_Analyzer::end_statement() {
+	Statement_node* node = statement_frames.back().node;
+	statement_frames.pop_back();
+	statement_depth--;
+	return node;
+}
+
+// skips the rest of a statement that had a syntax error (initial is the state
+// before it), and returns a STATEMENT_ERROR node in its place
+Statement_node* Syntax_Analyzer::recover_statement(Checkpoint initial) {
+	// skip the rest of the broken statement: up to its ';', or up to a token
+	// that can begin the next statement or end the enclosing one
+	skip_to(STATEMENT_SYNC);
+	skip_symbol(SEPARATOR_SEMICOLON);
+	arena.reset(initial.nodes);
+	Statement_node* broken = arena.make<Statement_node>();
+	broken->kind = STATEMENT_ERROR;
+	broken->line = err_line_number;
+	return broken;
+}
+
+/******************************************************************************
+| Input that is nested deeper than max_depth can't be analyzed: the error is  |
+| reported, and Nesting_error unwinds the whole analysis (instead of just the |
+| statement it is in, since everything around it is unfinished too), so the   |
+| rest of the file isn't checked.                                             |
+******************************************************************************/
+void Syntax_Analyzer::nesting_error(const char* nested) {
+	report_error(std::string(nested) + " are nested deeper than the limit ("
+				 + std::to_string(max_depth) + " levels)");
+	throw Nesting_error();
+}
@@ -3,77 +3,291 @@
 #define SYNTAX_ANALYZER_H_
 
 /* ------------------------------- LIBRARIES ------------------------------- */
-#include <fstream>  // input and output files
+#include <cstddef>  // size_t
+#include <cstdint>  // Production_id  Symbol_set  SIZE_MAX
 #include <string>  // substring
+#include <string_view>  // lexemes of AST nodes
 #include <vector>  // Rule_list
 
-#include "lexer.h"  // Lexer (get tokens)
+#include "arena.h"  // AST nodes
+#include "ast.h"  // AST built during the analysis
+#include "lexer.h"  // Token_stream (get tokens)
+#include "memo_table.h"  // packrat memoization
+#include "output_buffer.h"  // output file
+#include "token_ring.h"  // tokens from a lexer thread (pipelined)
 
 /* ------------------- DEFINE STATEMENTS FOR STRUCTURES ------------------- */
-typedef std::string Production;  // ex. "E -> T"
-typedef std::vector<Production> Rule_list;  // productions used by a token
+// every production that the analyzer can print (ex. "<Qualifier> -> int").
+// the *_NO_MATCH productions list all of the alternatives, and are printed
+// when none of them matches. their text is in syntax_analyzer.cpp
+enum Production_id : std::uint8_t {
+	PROD_RAT23S,
+	PROD_OPT_FUNCTION_DEFINITIONS,
+	PROD_OPT_FUNCTION_DEFINITIONS_EMPTY,
+	PROD_FUNCTION_DEFINITIONS_START,
+	PROD_FUNCTION_DEFINITIONS_CONT,
+	PROD_FUNCTION_DEFINITIONS_CONT_EMPTY,
+	PROD_FUNCTION,
+	PROD_OPT_PARAMETER_LIST,
+	PROD_OPT_PARAMETER_LIST_EMPTY,
+	PROD_PARAMETER_LIST_START,
+	PROD_PARAMETER_LIST_CONT,
+	PROD_PARAMETER_LIST_CONT_EMPTY,
+	PROD_PARAMETER,
+	PROD_QUALIFIER_INT,
+	PROD_QUALIFIER_BOOL,
+	PROD_QUALIFIER_REAL,
+	PROD_QUALIFIER_NO_MATCH,
+	PROD_BODY,
+	PROD_OPT_DECLARATION_LIST,
+	PROD_OPT_DECLARATION_LIST_EMPTY,
+	PROD_DECLARATION_LIST_START,
+	PROD_DECLARATION_LIST_CONT,
+	PROD_DECLARATION_LIST_CONT_EMPTY,
+	PROD_DECLARATION,
+	PROD_IDS_START,
+	PROD_IDS_CONT,
+	PROD_IDS_CONT_EMPTY,
+	PROD_STATEMENT_LIST_START,
+	PROD_STATEMENT_LIST_CONT,
+	PROD_STATEMENT_LIST_CONT_EMPTY,
+	PROD_STATEMENT_COMPOUND,
+	PROD_STATEMENT_ASSIGN,
+	PROD_STATEMENT_IF,
+	PROD_STATEMENT_RETURN,
+	PROD_STATEMENT_PRINT,
+	PROD_STATEMENT_SCAN,
+	PROD_STATEMENT_WHILE,
+	PROD_STATEMENT_NO_MATCH,
+	PROD_COMPOUND,
+	PROD_ASSIGN,
+	PROD_IF_START,
+	PROD_IF_CONT_ELSE,
+	PROD_IF_CONT_FI,
+	PROD_IF_CONT_NO_MATCH,
+	PROD_RETURN_START,
+	PROD_RETURN_CONT_EXPRESSION,
+	PROD_RETURN_CONT_SEMICOLON,
+	PROD_RETURN_CONT_NO_MATCH,
+	PROD_PRINT,
+	PROD_SCAN,
+	PROD_WHILE,
+	PROD_CONDITION,
+	PROD_RELOP_EQUAL,
+	PROD_RELOP_NOT_EQUAL,
+	PROD_RELOP_GREATER,
+	PROD_RELOP_LESS,
+	PROD_RELOP_LESS_EQUAL,
+	PROD_RELOP_GREATER_EQUAL,
+	PROD_RELOP_NO_MATCH,
+	PROD_EXPRESSION_START,
+	PROD_EXPRESSION_CONT_PLUS,
+	PROD_EXPRESSION_CONT_MINUS,
+	PROD_EXPRESSION_CONT_EMPTY,
+	PROD_TERM_START,
+	PROD_TERM_CONT_MULTIPLY,
+	PROD_TERM_CONT_DIVIDE,
+	PROD_TERM_CONT_EMPTY,
+	PROD_FACTOR_NEGATIVE,
+	PROD_FACTOR_PRIMARY,
+	PROD_FACTOR_NO_MATCH,
+	PROD_PRIMARY_IDENTIFIER,
+	PROD_PRIMARY_INTEGER,
+	PROD_PRIMARY_PARENTHESES,
+	PROD_PRIMARY_REAL,
+	PROD_PRIMARY_TRUE,
+	PROD_PRIMARY_FALSE,
+	PROD_PRIMARY_NO_MATCH,
+	PROD_PRIMARY_CONT,
+	PROD_PRIMARY_CONT_EMPTY,
+	PRODUCTION_COUNT
+};
+typedef std::vector<Production_id> Rule_list;  // productions used by a token
+
+const Token NO_TOKEN = { TOKEN_NONE, SYMBOL_NONE, 0, 0, 0 };  // nothing read
+
+// the state of the analyzer when an alternative is tried (for backtracking)
+struct Checkpoint {
+	std::size_t productions;  // length of Productions
+	Arena_mark nodes;  // end of the AST nodes
+};
+
+// where a rule started (for memoizing its failure in packrat mode)
+struct Rule_start {
+	std::uint8_t rule;  // the rule's Nonterminal (see syntax_analyzer.cpp)
+	std::size_t position;  // index of its first token
+	std::size_t productions;  // length of Productions
+};
+
+// a statement list, or a compound/if/while statement, that the analyzer is in
+// the middle of (see Statement_List_Start())
+enum Statement_step : std::uint8_t {
+	STEP_LIST_START,  // read a <Statement List Start>
+	STEP_LIST_STATEMENT,  // got its <Statement>
+	STEP_COMPOUND_START,  // read the statements after '{'
+	STEP_COMPOUND_BODY,  // got them
+	STEP_IF_START,  // read the statement after the condition
+	STEP_IF_BODY,  // got it
+	STEP_IF_ELSE,  // got the statement after 'else'
+	STEP_WHILE_START,  // read the statement after the condition
+	STEP_WHILE_BODY  // got it
+};
+
+struct Statement_frame {
+	Statement_step step;  // what to do next
+	Statement_node* node;  // list: its first statement, else: the statement
+	Statement_node* last;  // (list) its last statement so far
+	Checkpoint initial;  // list: before <Statement List Cont>, else: before
+						 // <Statement> (for error recovery)
+	Rule_start start;  // (list, packrat) its current <Statement List Start>
+};
+
+// an expression inside parentheses that the analyzer is in the middle of
+// (see Expression_Start())
+struct Binary_operator;
+const std::size_t OPERATOR_LEVEL_COUNT = 2;  // + - and * / (OPERATOR_LEVELS)
+
+struct Expression_frame {
+	Expression_node* value[OPERATOR_LEVEL_COUNT];  // each open level's value
+	const Binary_operator* op;  // its last operator (null: none yet)
+	std::size_t level;  // the first level that is (re)opened
+	Expression_node* negative;  // '-' before the '(' of the one inside it
+	Rule_start start;  // (packrat)
+};
+
+// a syntax error: where it was found, its description, and the token that
+// wasn't expected there
+struct Diagnostic {
+	int line;
+	std::string message;
+	Token token;  // (NO_TOKEN if no token had been read yet)
+};
+
+// thrown when a pipelined analysis receives the ERROR token that the lexer
+// stopped at (the file fails the LA phase instead, see compile())
+struct Lexical_error {};
+
+// thrown when statements or parentheses are nested more than max_depth levels
+// deep (the rest of the file isn't analyzed)
+struct Nesting_error {};
+
+// everything that Rat23S() found out about the input file
+struct Syntax_result {
+	Program_node* program = nullptr;  // AST (null if there were errors)
+	std::vector<Diagnostic> diagnostics;  // in the order they were found
+	Memo_stats memo;  // (packrat mode) how often a rule didn't run again
+
+	bool passed() const { return diagnostics.empty(); }
+};
+
+typedef std::uint64_t Symbol_set;  // one bit per Symbol_id (ie. FIRST sets)
+
+// how the analyzer chooses between the alternatives of a production
+enum Parse_mode {
+	PARSE_PREDICTIVE,  // the current token picks the alternative (FIRST sets)
+	PARSE_BACKTRACKING  // each alternative is tried until one works
+};
+
+// how deeply statements and parentheses can be nested (see set_max_depth())
+const std::size_t DEFAULT_MAX_DEPTH = 100000;
 
 
 /* -------------------------------- CLASSES -------------------------------- */
 class Syntax_Analyzer {  // used for an input file's Syntax Analysis
 	private:
-		Lexer* lexer;  // get tokens from input file
-		Token current_token = { "", "" };  // used for backtracking/symbol check
+		const Token_stream* tokens;  // tokens of input file (from the LA phase)
+		Token_ring* ring = nullptr;  // (pipelined) where the tokens come from
+		Token_stream received;  // (pipelined) tokens taken out of ring so far
+		std::size_t next_token = 0;  // position of the next token to be read
+		Token current_token = NO_TOKEN;  // used for backtracking/symbol check
 		Rule_list Productions;  // productions used by current_token
-		std::ofstream* ofs;  // write to output file
+		Output_buffer* ofs;  // write to output file (if there is one)
 		int err_line_number = 1;  // keep track of where error occurs
+		Parse_mode mode = PARSE_PREDICTIVE;
+		bool trace = true;  // print every token and its productions
+		Token matched_token = NO_TOKEN;  // last token used by check_symbol()
+		Arena arena;  // AST nodes
+		Program_node* program = nullptr;  // AST (set when the file passes)
+		std::vector<Diagnostic> diagnostics;  // errors found so far
+		std::size_t matched_count = 0;  // tokens used by check_symbol()
+		std::size_t last_error = SIZE_MAX;  // matched_count at the last error
+		Memo_table memo;  // (packrat) rules that failed, by token position
+		std::size_t max_depth = DEFAULT_MAX_DEPTH;  // (0 -> no limit)
+		std::vector<Statement_frame> statement_frames;  // (explicit stack)
+		std::size_t statement_depth = 0;  // compound/if/while frames
+		std::vector<Expression_frame> expression_frames;  // (explicit stack)
 
-		// productions
-		void Opt_Function_Definitions();
-		void Function_Definitions_Start();
-		void Function_Definitions_Cont();
-		void Function();
-		void Opt_Parameter_List();
-		void Parameter_List_Start();
-		void Parameter_List_Cont();
-		void Parameter();
-		void Qualifier();
-		void Body();
-		void Opt_Declaration_List();
-		void Declaration_List_Start();
-		void Declaration_List_Cont();
-		void Declaration();
-		void IDs_Start();
-		void IDs_Cont();
-		void Statement_List_Start();
-		void Statement_List_Cont();
-		void Statement();
-		void Compound();
-		void Assign();
-		void If_Start();
-		void If_Cont();
-		void Return_Start();
-		void Return_Cont();
-		void Print();
-		void Scan();
-		void While();
-		void Condition();
-		void Relop();
-		void Expression_Start();
-		void Expression_Cont();
-		void Term_Start();
-		void Term_Cont();
-		void Factor();
-		void Primary_Start();
-		void Primary_Cont();
+		// productions (each one returns the AST it built, null if it failed)
+		Function_node* Opt_Function_Definitions();
+		Function_node* Function_Definitions_Start();
+		Function_node* Function();
+		Declaration_node* Opt_Parameter_List();
+		Declaration_node* Parameter_List_Start();
+		Declaration_node* Parameter();
+		Symbol_id Qualifier();  // SYMBOL_NONE if it failed
+		Statement_node* Body();
+		Declaration_node* Opt_Declaration_List();
+		Declaration_node* Declaration_List_Start();
+		Declaration_node* Declaration();
+		Identifier_node* IDs_Start();
+		Statement_node* Statement_List_Start();  // (and nested statements)
+		Statement_node* Statement();
+		Statement_node* Compound();  // (only up to '{')
+		Statement_node* Assign();
+		Statement_node* If_Start();  // (only up to the condition's ')')
+		bool If_Cont();  // true: 'else' (its statement is next), false: 'fi'
+		Statement_node* Return_Start();
+		Expression_node* Return_Cont();  // null for just ';'
+		Statement_node* Print();
+		Statement_node* Scan();
+		Statement_node* While();  // (only up to the condition's ')')
+		Condition_node Condition();
+		Symbol_id Relop();
+		Expression_node* Expression_Start();  // (and nested parentheses)
+		Expression_node* Factor(bool& opened);  // opened: see Primary_Start()
+		Expression_node* Primary_Start(bool& opened);  // opened: matched '('
+		Identifier_node* Primary_Cont();  // arguments (null if not a call)
 
 		// helper functions
-		void check_symbol(std::string symbol);  // match expected symbol
-		void copy_list(Rule_list original, Rule_list& copy);  // backtrack
-		std::string convert_to_lowercase(std::string s);
+		bool check_symbol(Symbol_id symbol);  // match expected symbol
+		void read_token();  // read the next token (if needed)
+		void receive_token();  // (pipelined) wait for the lexer's next token
+		bool can_start(Symbol_set first);  // should an alternative be tried?
+		Checkpoint checkpoint();  // save the state before an alternative
+		void rollback(Checkpoint saved);  // undo a failed alternative
+		std::size_t token_position();  // index of the current token
+		bool recall_failure(std::uint8_t rule, Rule_start& start);
+		void remember_failure(const Rule_start& start);
+		std::string_view matched_lexeme();  // lexeme of matched_token
+		Expression_node* make_expression(Expression_kind kind);
+		Expression_node* make_binary(Symbol_id op, Expression_node* left);
 		void print_current_token();  // print the current token
 		void print_productions();  // print the productions of current token
-		void print_error(std::string err_msg);  // write error message
+		void report_error(std::string err_msg);  // record/write error message
+		void print_error(std::string err_msg);  // report error, then unwind
+		void skip_to(Symbol_set stop);  // skip tokens (error recovery)
+		void skip_symbol(Symbol_id symbol);  // skip it if it's the current one
+		void skip_condition();  // skip a broken if/while condition
+		void begin_statement(Statement_node* node, Statement_step step,
+							 Checkpoint initial);  // push its frame
+		Statement_node* end_statement();  // pop its frame
+		Statement_node* recover_statement(Checkpoint initial);  // (error)
+		void nesting_error(const char* nested);  // report it, then unwind
 
 	public:
-		Syntax_Analyzer(std::ifstream* input_file_stream,
-						std::ofstream* output_file_stream);  // constructor
-		void Rat23S();  // start Syntax Analysis
+		Syntax_Analyzer(const Token_stream* token_stream,
+						Output_buffer* output_file);  // constructor
+		Syntax_Analyzer(Token_ring* token_ring, const char* text_begin,
+						const char* text_end,
+						Output_buffer* output_file);  // pipelined
+		void set_parse_mode(Parse_mode parse_mode);  // default: predictive
+		void set_trace(bool enabled);  // false -> only print errors
+		void set_packrat(std::size_t max_entries);  // 0 -> off (default)
+		void set_max_depth(std::size_t depth);  // 0 -> no limit
+		Syntax_result Rat23S();  // start Syntax Analysis
+		const Program_node* get_program() const;  // AST built by Rat23S()
+		const Token_stream& get_tokens() const;  // tokens read so far
+		void receive_rest();  // (pipelined) take the tokens Rat23S() didn't
 };
 
 #endif
\ No newline at end of file
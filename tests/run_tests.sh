@@ -0,0 +1,111 @@
+#!/bin/sh
+###############################################################################
+# Runs every test program (tests/name.txt) on each machine, and compares what #
+# it prints (put() output, then any error, then "exit: N") with the expected  #
+# output in tests/name.expected. Its input for get() is tests/name.in, or     #
+# nothing if there isn't one. Each program runs with --run --vm stack,        #
+# register and jit, and then from the code file that --binary wrote (with     #
+# --run-binary), so the JIT is checked against both interpreters. A code file #
+# (tests/name.bin) holds stack code that no program compiles to, and only     #
+# runs with --run-binary. Every program is also compiled (with the trace)     #
+# with --backtracking and with --packrat, which mustn't change its output     #
+# file or exit code. Any difference fails the test.                           #
+#                                                                             #
+# usage: tests/run_tests.sh [path/to/main]   (./main by default)              #
+###############################################################################
+
+main=${1:-./main}
+tests=$(dirname "$0")
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+
+if [ ! -x "$main" ]; then
+	echo "ERROR: Couldn't run '$main'"
+	exit 1
+fi
+
+# runs "$main" with the arguments, and prints its output and exit code
+run() {
+	input=$1
+	shift
+	"$main" --no-trace "$@" < "$input" > "$work/actual" 2>&1
+	echo "exit: $?" >> "$work/actual"
+}
+
+# compares the last run with the expected output
+check() {
+	if cmp -s "$expected" "$work/actual"; then
+		return 0
+	fi
+	echo "FAIL $name ($1)"
+	diff "$expected" "$work/actual" | sed 's/^/    /'
+	failed=$((failed + 1))
+}
+
+# compiles the program with the options, and compares the output file and
+# exit code with the ones it had without them
+check_parse() {
+	"$main" "$@" "$program" "$work/parsed" < /dev/null > /dev/null 2>&1
+	echo "exit: $?" >> "$work/parsed"
+	if cmp -s "$work/reference" "$work/parsed"; then
+		return 0
+	fi
+	echo "FAIL $name ($*)"
+	diff "$work/reference" "$work/parsed" | sed 's/^/    /'
+	failed=$((failed + 1))
+}
+
+count=0
+failed=0
+for program in "$tests"/*.txt "$tests"/*.bin; do
+	if [ ! -f "$program" ]; then
+		continue  # (no file matched)
+	fi
+	name=$(basename "$program")
+	name=${name%.*}
+	expected="$tests/$name.expected"
+	input="$tests/$name.in"
+	if [ ! -f "$input" ]; then
+		input=/dev/null
+	fi
+	if [ ! -f "$expected" ]; then
+		echo "FAIL $name (no $name.expected)"
+		failed=$((failed + 1))
+		continue
+	fi
+	count=$((count + 1))
+	if [ "${program##*.}" = bin ]; then
+		for vm in stack register jit; do
+			run "$input" --run-binary "$program" --vm "$vm"
+			check "--run-binary --vm $vm"
+		done
+		continue
+	fi
+	rm -f "$work/code.bin"
+	for vm in stack register jit; do
+		if [ "$vm" = stack ]; then
+			run "$input" --run --vm stack --binary "$work/code.bin" \
+				"$program" "$work/output"
+		else
+			run "$input" --run --vm "$vm" "$program" "$work/output"
+		fi
+		check "--vm $vm"
+	done
+	if [ -f "$work/code.bin" ]; then  # (it passed)
+		for vm in stack register jit; do
+			run "$input" --run-binary "$work/code.bin" --vm "$vm"
+			check "--run-binary --vm $vm"
+		done
+	fi
+
+	"$main" "$program" "$work/reference" < /dev/null > /dev/null 2>&1
+	echo "exit: $?" >> "$work/reference"
+	check_parse --packrat 1  # (most failures don't fit)
+	check_parse --packrat 65536
+	check_parse --backtracking
+	check_parse --backtracking --packrat 1
+	check_parse --backtracking --packrat 65536
+done
+
+echo "$count tests, $failed failed runs"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,111 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <utility>  // move()
+
+#include "thread_pool.h"
+
+/******************************************************************************
+| Every worker has its own queue, and submit() hands tasks out to the queues  |
+| in turn. A worker runs the tasks of its own queue from the front (in the    |
+| order they were submitted), and once its queue is empty, it steals from the |
+| back of the other queues, so no worker sits idle while another one still    |
+| has a backlog. Each queue has its own lock, so workers only contend when    |
+| they steal.                                                                 |
+******************************************************************************/
+Thread_pool::Thread_pool(unsigned thread_count) {
+	if (thread_count == 0) {
+		thread_count = std::thread::hardware_concurrency();
+	}
+	if (thread_count == 0) {  // (the core count couldn't be found)
+		thread_count = 1;
+	}
+	for (unsigned i = 0; i < thread_count; i++) {
+		queues.push_back(std::make_unique<Task_queue>());
+	}
+	for (unsigned i = 0; i < thread_count; i++) {
+		workers.emplace_back(&Thread_pool::work, this, i);
+	}
+}
+
+Thread_pool::~Thread_pool() {
+	wait();
+	{
+		std::lock_guard<std::mutex> guard(state_lock);
+		stopping = true;
+	}
+	work_ready.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void Thread_pool::submit(Task task) {
+	std::size_t index;
+	{
+		// counted before it is queued, so that queued never goes below 0
+		std::lock_guard<std::mutex> guard(state_lock);
+		queued++;
+		pending++;
+		index = next_queue;
+		next_queue = (next_queue + 1) % queues.size();
+	}
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	work_ready.notify_one();
+}
+
+void Thread_pool::wait() {
+	std::unique_lock<std::mutex> guard(state_lock);
+	all_done.wait(guard, [this] { return pending == 0; });
+}
+
+unsigned Thread_pool::size() const {
+	return static_cast<unsigned>(workers.size());
+}
+
+// takes a task from the worker's own queue, or steals one from another queue
+bool Thread_pool::take(std::size_t index, Task& task) {
+	for (std::size_t i = 0; i < queues.size(); i++) {
+		Task_queue& queue = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (queue.tasks.empty()) {
+			continue;
+		}
+		if (i == 0) {  // own queue
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		else {  // steal
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
+
+void Thread_pool::work(std::size_t index) {
+	while (true) {
+		Task task;
+		if (take(index, task)) {
+			{
+				std::lock_guard<std::mutex> guard(state_lock);
+				queued--;
+			}
+			task();
+			std::lock_guard<std::mutex> guard(state_lock);
+			if (--pending == 0) {
+				all_done.notify_all();
+			}
+			continue;
+		}
+
+		// nothing to take: sleep until a task is submitted (or the pool ends)
+		std::unique_lock<std::mutex> guard(state_lock);
+		work_ready.wait(guard, [this] { return stopping || queued > 0; });
+		if (stopping && queued == 0) {
+			return;
+		}
+	}
+}
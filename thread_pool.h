@@ -0,0 +1,52 @@
+#pragma once
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <condition_variable>  // idle workers, wait()
+#include <cstddef>  // size_t
+#include <deque>  // task queues
+#include <functional>  // Task
+#include <memory>  // queues
+#include <mutex>  // queue locks
+#include <thread>  // workers
+#include <vector>
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Thread_pool {  // worker threads that steal tasks from each other
+	public:
+		typedef std::function<void()> Task;
+
+	private:
+		struct Task_queue {  // one per worker
+			std::mutex lock;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<Task_queue>> queues;
+		std::vector<std::thread> workers;
+
+		std::mutex state_lock;  // guards the members below
+		std::size_t next_queue = 0;  // queue that gets the next task
+		std::condition_variable work_ready;  // a task was submitted
+		std::condition_variable all_done;  // pending became 0
+		std::size_t queued = 0;  // tasks waiting in the queues
+		std::size_t pending = 0;  // tasks submitted but not finished
+		bool stopping = false;
+
+		void work(std::size_t index);
+		bool take(std::size_t index, Task& task);
+
+	public:
+		explicit Thread_pool(unsigned thread_count = 0);  // 0 -> one per core
+		~Thread_pool();  // finishes the submitted tasks first
+		Thread_pool(const Thread_pool&) = delete;
+		Thread_pool& operator=(const Thread_pool&) = delete;
+
+		void submit(Task task);
+		void wait();  // until every submitted task has finished
+		unsigned size() const;  // number of worker threads
+};
+
+#endif
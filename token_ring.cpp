@@ -0,0 +1,48 @@
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <thread>  // this_thread::yield()
+
+#include "token_ring.h"
+
+static constexpr unsigned SPINS_BEFORE_YIELD = 64;
+
+Token_ring::Token_ring(std::size_t capacity) {
+	std::size_t size = 2;
+	while (size < capacity) {
+		size *= 2;
+	}
+	slots.resize(size);
+	mask = size - 1;
+}
+
+/******************************************************************************
+| Backpressure: a full ring makes the lexer wait for the analyzer, and an     |
+| empty one makes the analyzer wait for the lexer. The waiting side spins for |
+| a moment (the other side is usually only a few tokens away), then gives up  |
+| its time slice on each try, so the two threads still take turns when they   |
+| share a core.                                                               |
+******************************************************************************/
+void Token_ring::wait_for_space() {
+	std::size_t position = tail.load(std::memory_order_relaxed);
+	for (unsigned spins = 0; ; spins++) {
+		known_head = head.load(std::memory_order_acquire);
+		if (position - known_head <= mask) {
+			return;
+		}
+		if (spins >= SPINS_BEFORE_YIELD) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void Token_ring::wait_for_token() {
+	std::size_t position = head.load(std::memory_order_relaxed);
+	for (unsigned spins = 0; ; spins++) {
+		known_tail = tail.load(std::memory_order_acquire);
+		if (known_tail != position) {
+			return;
+		}
+		if (spins >= SPINS_BEFORE_YIELD) {
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef TOKEN_RING_H_
+#define TOKEN_RING_H_
+
+/* ------------------------------- LIBRARIES ------------------------------- */
+#include <atomic>  // read/write positions
+#include <cstddef>  // size_t
+#include <vector>  // slots
+
+#include "lexer.h"  // Token
+
+
+/* -------------------------------- CLASSES -------------------------------- */
+class Token_ring {  // bounded queue of tokens from one thread to another one
+	private:
+		std::vector<Token> slots;  // (the capacity is a power of 2)
+		std::size_t mask;  // capacity - 1
+
+		// each side's position is on its own cache line, next to its copy of
+		// the other side's position (only reloaded when the copy runs out)
+		alignas(64) std::atomic<std::size_t> head{0};  // next slot to read
+		std::size_t known_tail = 0;  // (reader's copy)
+		alignas(64) std::atomic<std::size_t> tail{0};  // next slot to write
+		std::size_t known_head = 0;  // (writer's copy)
+
+		void wait_for_space();
+		void wait_for_token();
+
+	public:
+		explicit Token_ring(std::size_t capacity = 1 << 14);  // 256 KiB
+		Token_ring(const Token_ring&) = delete;
+		Token_ring& operator=(const Token_ring&) = delete;
+
+		void push(const Token& token);  // (writer) waits while the ring is full
+		Token pop();  // (reader) waits while the ring is empty
+};
+
+/******************************************************************************
+| push() and pop() only ever wait when the other side has fallen behind. The  |
+| writer only stores tail and the reader only stores head, so neither needs   |
+| a lock: the release store of a position publishes the slot before it, and   |
+| the other side's acquire load makes that slot visible to it.                |
+******************************************************************************/
+inline void Token_ring::push(const Token& token) {
+	std::size_t position = tail.load(std::memory_order_relaxed);
+	if (position - known_head > mask) {
+		wait_for_space();
+	}
+	slots[position & mask] = token;
+	tail.store(position + 1, std::memory_order_release);
+}
+
+inline Token Token_ring::pop() {
+	std::size_t position = head.load(std::memory_order_relaxed);
+	if (position == known_tail) {
+		wait_for_token();
+	}
+	Token token = slots[position & mask];
+	head.store(position + 1, std::memory_order_release);
+	return token;
+}
+
+#endif